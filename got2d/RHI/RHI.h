@@ -1,5 +1,6 @@
 #pragma once
 #include <cinttypes>
+#include <vector>
 #include "cxx_math/cxx_color.h"
 #include "cxx_math/cxx_vector.h"
 #include "../source/scope_utility.h"
@@ -42,6 +43,7 @@ namespace rhi
 	enum class InputFormat : int
 	{
 		Float2, Float3, Float4,
+		UNorm16x2, UNorm8x4,
 	};
 
 	enum class BlendFactor : int
@@ -63,6 +65,11 @@ namespace rhi
 		Add = 0, Sub = 1,
 	};
 
+	enum class ShaderStage : int
+	{
+		Vertex = 0, Pixel = 1,
+	};
+
 	class TextureBinding
 	{
 	public:
@@ -87,6 +94,10 @@ namespace rhi
 		Mirror = 2,
 	};
 
+	// offset and length of a bound constant buffer range
+	// must be multiples of it.
+	constexpr unsigned int ConstantBufferAlignment = 256;
+
 	class RHIObject
 	{
 	public:
@@ -234,6 +245,15 @@ namespace rhi
 
 	class TextureSampler : public RHIObject { };
 
+	// depth passes if it is less than or equal to the stored one.
+	class DepthStencilState : public RHIObject
+	{
+	public:
+		virtual bool IsDepthTestEnabled() const = 0;
+
+		virtual bool IsDepthWriteEnabled() const = 0;
+	};
+
 	class SwapChain : public RHIObject
 	{
 	public:
@@ -256,7 +276,8 @@ namespace rhi
 	{
 	public:
 		// if width / height is specified as zero, default size of native window will be used.
-		virtual SwapChain* CreateSwapChain(void* nativeWindow, bool useDepthStencil, unsigned int windowWidth, unsigned int windowHeight) = 0;
+		// back buffer keeps contents after presenting if preserveContents is true.
+		virtual SwapChain* CreateSwapChain(void* nativeWindow, bool useDepthStencil, bool preserveContents, unsigned int windowWidth, unsigned int windowHeight) = 0;
 
 		virtual Buffer* CreateBuffer(BufferBinding binding, ResourceUsage usage, unsigned int bufferLength) = 0;
 
@@ -266,12 +287,21 @@ namespace rhi
 
 		virtual PixelShader* CreatePixelShader(const char* source, const char* entry) = 0;
 
+		// return false if compiling failed, or the device has no compiler.
+		virtual bool CompileShader(const char* source, const char* entry, ShaderStage stage, std::vector<uint8_t>& bytecode) = 0;
+
+		virtual VertexShader* CreateVertexShaderFromBytecode(const void* bytecode, unsigned int length, Semantic* layouts, SemanticCount layoutCount) = 0;
+
+		virtual PixelShader* CreatePixelShaderFromBytecode(const void* bytecode, unsigned int length) = 0;
+
 		virtual ShaderProgram* LinkShader(VertexShader*, PixelShader*) = 0;
 
 		virtual BlendState* CreateBlendState(bool enabled, BlendFactor source, BlendFactor dest, BlendOperator op) = 0;
 
 		virtual TextureSampler* CreateTextureSampler(SamplerFilter filter, TextureAddress addressU, TextureAddress addressV) = 0;
 
+		virtual DepthStencilState* CreateDepthStencilState(bool depthTest, bool depthWrite) = 0;
+
 		virtual RenderTarget* CreateRenderTarget(unsigned int width, unsigned int height, TextureFormat* rtFormats, RTCount rtCount, bool useDpethStencil) = 0;
 	};
 
@@ -282,6 +312,15 @@ namespace rhi
 		cxx::float2 MinMaxZ;
 	};
 
+	// in pixels, right and bottom are exclusive.
+	struct Rect
+	{
+		int Left = 0;
+		int Top = 0;
+		int Right = 0;
+		int Bottom = 0;
+	};
+
 	struct VertexBufferInfo
 	{
 		Buffer* buffer = nullptr;
@@ -301,8 +340,14 @@ namespace rhi
 	public:
 		virtual void ClearRenderTarget(RenderTarget* renderTarget, cxx::color4f clearColor) = 0;
 
+		// do nothing if the target has no depth/stencil buffer.
+		virtual void ClearDepthStencil(RenderTarget* renderTarget, float depth, uint8_t stencil) = 0;
+
 		virtual void SetViewport(const Viewport& viewport) = 0;
 
+		// nullptr to disable the scissor test.
+		virtual void SetScissorRect(const Rect* rect) = 0;
+
 		virtual void SetRenderTarget(RenderTarget* renderTarget) = 0;
 
 		virtual void SetVertexBuffers(unsigned int startSlot, VertexBufferInfo* buffers, unsigned int bufferCount) = 0;
@@ -315,10 +360,21 @@ namespace rhi
 
 		virtual void SetPixelShaderConstantBuffers(unsigned int startSlot, Buffer** buffers, unsigned int bufferCount) = 0;
 
+		// return false if the driver cannot bind a part of constant buffers,
+		// functions binding ranges must not be used in that case.
+		virtual bool IsConstantBufferRangeSupported() const = 0;
+
+		// offset and length are in bytes, aligned to ConstantBufferAlignment.
+		virtual void SetVertexShaderConstantBufferRange(unsigned int slot, Buffer* buffer, unsigned int offset, unsigned int length) = 0;
+
+		virtual void SetPixelShaderConstantBufferRange(unsigned int slot, Buffer* buffer, unsigned int offset, unsigned int length) = 0;
+
 		virtual void SetTextures(unsigned int startSlot, Texture2D** textures, unsigned int resCount) = 0;
 
 		virtual void SetBlendState(BlendState* state) = 0;
 
+		virtual void SetDepthStencilState(DepthStencilState* state) = 0;
+
 		virtual void SetTextureSampler(unsigned int startSlot, TextureSampler** samplers, unsigned int count) = 0;
 
 		virtual void DrawIndexed(Primitive primitive, unsigned int indexCount, unsigned int startIndex, unsigned int baseVertex) = 0;
@@ -341,5 +397,7 @@ namespace rhi
 		Context* ContextPtr = nullptr;
 	};
 
-	RHICreationResult CreateRHI();
+	// device should be thread-safe if resources
+	// are released from another thread.
+	RHICreationResult CreateRHI(bool threadSafeDevice);
 }
\ No newline at end of file
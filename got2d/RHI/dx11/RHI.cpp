@@ -1,7 +1,7 @@
 #include "inner_RHI.h"
 #include "../../source/scope_utility.h"
 #include "cxx_scope.h"
-rhi::RHICreationResult rhi::CreateRHI()
+rhi::RHICreationResult rhi::CreateRHI(bool threadSafeDevice)
 {
 	ID3D11Device* d3dDevice = nullptr;
 	ID3D11DeviceContext* d3dContext = nullptr;
@@ -13,13 +13,13 @@ rhi::RHICreationResult rhi::CreateRHI()
 	});
 
 	D3D_DRIVER_TYPE driverType = D3D_DRIVER_TYPE_HARDWARE;
-	D3D11_CREATE_DEVICE_FLAG deviceFlag = D3D11_CREATE_DEVICE_SINGLETHREADED;
+	UINT deviceFlag = threadSafeDevice ? 0 : D3D11_CREATE_DEVICE_SINGLETHREADED;
 	D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_11_0;
 	HRESULT hr = ::D3D11CreateDevice(
 		NULL,		//adapter
 		driverType,	//hardware device
 		NULL,		//no software renderer
-		deviceFlag,	//single-thread
+		deviceFlag,	//single-thread if possible
 		&featureLevel, 1,	//desire feature level setting
 		D3D11_SDK_VERSION,
 		&d3dDevice,
@@ -80,6 +80,19 @@ BlendState::~BlendState()
 	m_blendState.Release();
 }
 
+DepthStencilState::DepthStencilState(ID3D11DepthStencilState& depthStencilState, bool depthTest, bool depthWrite)
+	: m_depthStencilState(depthStencilState)
+	, m_depthTest(depthTest)
+	, m_depthWrite(depthWrite)
+{
+
+}
+
+DepthStencilState::~DepthStencilState()
+{
+	m_depthStencilState.Release();
+}
+
 Texture2D::Texture2D(ID3D11Texture2D* texture, ID3D11ShaderResourceView* srView, rhi::TextureFormat format, unsigned int width, unsigned int height)
 	: m_texture(texture)
 	, m_srView(srView)
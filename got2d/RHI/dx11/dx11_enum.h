@@ -45,6 +45,8 @@ constexpr DXGI_FORMAT kInputFormat[] =
 	DXGI_FORMAT_R32G32_FLOAT,
 	DXGI_FORMAT_R32G32B32_FLOAT,
 	DXGI_FORMAT_R32G32B32A32_FLOAT,
+	DXGI_FORMAT_R16G16_UNORM,
+	DXGI_FORMAT_R8G8B8A8_UNORM,
 };
 
 constexpr D3D11_BLEND kBlendOperand[] =
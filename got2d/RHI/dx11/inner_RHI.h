@@ -1,6 +1,7 @@
 #pragma once
 #include <Windows.h>
 #include <d3d11.h>
+#include <d3d11_1.h>
 #include <vector>
 #include "../RHI.h"
 
@@ -191,6 +192,28 @@ private:
 	rhi::BlendOperator m_blendOp = rhi::BlendOperator::Add;
 };
 
+class DepthStencilState : public rhi::DepthStencilState
+{
+public:
+	virtual void Release() override { delete this; }
+
+	virtual bool IsDepthTestEnabled() const override { return m_depthTest; }
+
+	virtual bool IsDepthWriteEnabled() const override { return m_depthWrite; }
+
+public:
+	DepthStencilState(ID3D11DepthStencilState& depthStencilState, bool depthTest, bool depthWrite);
+
+	~DepthStencilState();
+
+	ID3D11DepthStencilState* GetRaw() { return &m_depthStencilState; }
+
+private:
+	ID3D11DepthStencilState& m_depthStencilState;
+	bool m_depthTest;
+	bool m_depthWrite;
+};
+
 class RenderTarget : public rhi::RenderTarget
 {
 public:
@@ -268,7 +291,7 @@ class Device : public rhi::Device
 public:
 	virtual void Release() override { delete this; }
 
-	virtual rhi::SwapChain* CreateSwapChain(void* nativeWindow, bool useDepthStencil, unsigned int windowWidth, unsigned int windowHeight) override;
+	virtual rhi::SwapChain* CreateSwapChain(void* nativeWindow, bool useDepthStencil, bool preserveContents, unsigned int windowWidth, unsigned int windowHeight) override;
 
 	virtual rhi::Buffer* CreateBuffer(rhi::BufferBinding binding, rhi::ResourceUsage usage, unsigned int bufferLength) override;
 
@@ -278,12 +301,20 @@ public:
 
 	virtual rhi::PixelShader* CreatePixelShader(const char* source, const char* entry) override;
 
+	virtual bool CompileShader(const char* source, const char* entry, rhi::ShaderStage stage, std::vector<uint8_t>& bytecode) override;
+
+	virtual rhi::VertexShader* CreateVertexShaderFromBytecode(const void* bytecode, unsigned int length, rhi::Semantic* layouts, rhi::SemanticCount layoutCount) override;
+
+	virtual rhi::PixelShader* CreatePixelShaderFromBytecode(const void* bytecode, unsigned int length) override;
+
 	virtual rhi::ShaderProgram* LinkShader(rhi::VertexShader* vertexShader, rhi::PixelShader* pixelShader)  override;
 
 	virtual rhi::BlendState* CreateBlendState(bool enabled, rhi::BlendFactor source, rhi::BlendFactor dest, rhi::BlendOperator op) override;
 
 	virtual rhi::TextureSampler* CreateTextureSampler(rhi::SamplerFilter filter, rhi::TextureAddress addressU, rhi::TextureAddress addressV) override;
 
+	virtual rhi::DepthStencilState* CreateDepthStencilState(bool depthTest, bool depthWrite) override;
+
 	virtual rhi::RenderTarget* CreateRenderTarget(unsigned int width, unsigned int height, rhi::TextureFormat* rtFormats, rhi::RTCount rtCount, bool useDpethStencil) override;
 
 public:
@@ -306,8 +337,12 @@ public:
 
 	virtual void ClearRenderTarget(rhi::RenderTarget* renderTarget, cxx::color4f clearColor) override;
 
+	virtual void ClearDepthStencil(rhi::RenderTarget* renderTarget, float depth, uint8_t stencil) override;
+
 	virtual void SetViewport(const rhi::Viewport& viewport) override;
 
+	virtual void SetScissorRect(const rhi::Rect* rect) override;
+
 	virtual void SetRenderTarget(rhi::RenderTarget* renderTargets) override;
 
 	virtual void SetVertexBuffers(unsigned int startSlot, rhi::VertexBufferInfo* buffers, unsigned int bufferCount) override;
@@ -320,10 +355,18 @@ public:
 
 	virtual void SetPixelShaderConstantBuffers(unsigned int startSlot, rhi::Buffer** buffers, unsigned int bufferCount) override;
 
+	virtual bool IsConstantBufferRangeSupported() const override { return m_d3dContext1 != nullptr; }
+
+	virtual void SetVertexShaderConstantBufferRange(unsigned int slot, rhi::Buffer* buffer, unsigned int offset, unsigned int length) override;
+
+	virtual void SetPixelShaderConstantBufferRange(unsigned int slot, rhi::Buffer* buffer, unsigned int offset, unsigned int length) override;
+
 	virtual void SetTextures(unsigned int startSlot, rhi::Texture2D** textures, unsigned int resCount) override;
 
 	virtual void SetBlendState(rhi::BlendState* state) override;
 
+	virtual void SetDepthStencilState(rhi::DepthStencilState* state) override;
+
 	virtual void SetTextureSampler(unsigned int startSlot, rhi::TextureSampler** samplers, unsigned int count) override;
 
 	virtual void DrawIndexed(rhi::Primitive primitive, unsigned int startIndex, unsigned int indexOffset, unsigned int baseVertex) override;
@@ -351,6 +394,8 @@ private:
 	void Unmap(ID3D11Resource* resource, UINT subResource);
 
 	ID3D11DeviceContext& m_d3dContext;
+	ID3D11DeviceContext1* m_d3dContext1 = nullptr;	//null if constant buffer offsetting is not supported.
+	ID3D11RasterizerState* m_scissorState = nullptr;	//default states with scissor enabled.
 	std::vector<ID3D11Buffer*> m_vertexbuffers;
 	std::vector<ID3D11Buffer*> m_vsConstantBuffers;
 	std::vector<ID3D11Buffer*> m_psConstantBuffers;
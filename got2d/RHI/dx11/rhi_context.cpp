@@ -5,10 +5,32 @@
 Context::Context(ID3D11DeviceContext& d3dContext)
 	: m_d3dContext(d3dContext)
 {
+	ID3D11Device* d3dDevice = nullptr;
+	m_d3dContext.GetDevice(&d3dDevice);
+
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	if (S_OK == d3dDevice->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options)) &&
+		options.ConstantBufferOffsetting)
+	{
+		m_d3dContext.QueryInterface(__uuidof(ID3D11DeviceContext1), reinterpret_cast<void**>(&m_d3dContext1));
+	}
+
+	CD3D11_RASTERIZER_DESC rasterizerDesc(D3D11_DEFAULT);
+	rasterizerDesc.ScissorEnable = TRUE;
+	d3dDevice->CreateRasterizerState(&rasterizerDesc, &m_scissorState);
+	d3dDevice->Release();
 }
 
 Context::~Context()
 {
+	if (m_d3dContext1 != nullptr)
+	{
+		m_d3dContext1->Release();
+	}
+	if (m_scissorState != nullptr)
+	{
+		m_scissorState->Release();
+	}
 	m_d3dContext.Release();
 }
 
@@ -27,6 +49,20 @@ void Context::ClearRenderTarget(rhi::RenderTarget * renderTarget, cxx::color4f c
 
 }
 
+void Context::ClearDepthStencil(rhi::RenderTarget* renderTarget, float depth, uint8_t stencil)
+{
+	auto renderTargetImpl = reinterpret_cast<::RenderTarget*>(renderTarget);
+	ENSURE(renderTargetImpl != nullptr);
+
+	if (renderTargetImpl->IsDepthStencilUsed())
+	{
+		m_d3dContext.ClearDepthStencilView(
+			renderTargetImpl->GetDepthStencilBufferImpl()->GetDSView(),
+			D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL,
+			depth, stencil);
+	}
+}
+
 void Context::SetViewport(const rhi::Viewport& viewport)
 {
 	D3D11_VIEWPORT vp11 =
@@ -40,6 +76,19 @@ void Context::SetViewport(const rhi::Viewport& viewport)
 	};
 	m_d3dContext.RSSetViewports(1, &vp11);
 }
+
+void Context::SetScissorRect(const rhi::Rect* rect)
+{
+	if (rect == nullptr || m_scissorState == nullptr)
+	{
+		m_d3dContext.RSSetState(nullptr);
+		return;
+	}
+
+	D3D11_RECT rect11 = { rect->Left, rect->Top, rect->Right, rect->Bottom };
+	m_d3dContext.RSSetState(m_scissorState);
+	m_d3dContext.RSSetScissorRects(1, &rect11);
+}
 void Context::SetRenderTarget(rhi::RenderTarget* renderTarget)
 {
 	auto renderTargetImpl = reinterpret_cast<::RenderTarget*>(renderTarget);
@@ -133,6 +182,31 @@ void Context::SetPixelShaderConstantBuffers(unsigned int startSlot, rhi::Buffer*
 	m_d3dContext.PSSetConstantBuffers(startSlot, bufferCount, &(m_psConstantBuffers[0]));
 }
 
+void Context::SetVertexShaderConstantBufferRange(unsigned int slot, rhi::Buffer* buffer, unsigned int offset, unsigned int length)
+{
+	auto bufferImpl = reinterpret_cast<::Buffer*>(buffer);
+	ENSURE(m_d3dContext1 != nullptr && bufferImpl != nullptr);
+	ENSURE(offset % rhi::ConstantBufferAlignment == 0 && length % rhi::ConstantBufferAlignment == 0);
+
+	//offsets are counted in shader constants of 16 bytes.
+	ID3D11Buffer* d3dBuffer = bufferImpl->GetRaw();
+	UINT firstConstant = offset / 16;
+	UINT numConstants = length / 16;
+	m_d3dContext1->VSSetConstantBuffers1(slot, 1, &d3dBuffer, &firstConstant, &numConstants);
+}
+
+void Context::SetPixelShaderConstantBufferRange(unsigned int slot, rhi::Buffer* buffer, unsigned int offset, unsigned int length)
+{
+	auto bufferImpl = reinterpret_cast<::Buffer*>(buffer);
+	ENSURE(m_d3dContext1 != nullptr && bufferImpl != nullptr);
+	ENSURE(offset % rhi::ConstantBufferAlignment == 0 && length % rhi::ConstantBufferAlignment == 0);
+
+	ID3D11Buffer* d3dBuffer = bufferImpl->GetRaw();
+	UINT firstConstant = offset / 16;
+	UINT numConstants = length / 16;
+	m_d3dContext1->PSSetConstantBuffers1(slot, 1, &d3dBuffer, &firstConstant, &numConstants);
+}
+
 void Context::SetShaderProgram(rhi::ShaderProgram * program)
 {
 	auto programImpl = reinterpret_cast<::ShaderProgram*>(program);
@@ -168,6 +242,13 @@ void Context::SetBlendState(rhi::BlendState* state)
 	m_d3dContext.OMSetBlendState(blendState, nullptr, 0xFFFFFFFF);
 }
 
+void Context::SetDepthStencilState(rhi::DepthStencilState* state)
+{
+	auto stateImpl = reinterpret_cast<::DepthStencilState*>(state);
+	ID3D11DepthStencilState* depthStencilState = stateImpl == nullptr ? nullptr : stateImpl->GetRaw();
+	m_d3dContext.OMSetDepthStencilState(depthStencilState, 0);
+}
+
 void Context::SetTextureSampler(unsigned int startSlot, rhi::TextureSampler** samplers, unsigned int count)
 {
 	ENSURE(samplers != nullptr);
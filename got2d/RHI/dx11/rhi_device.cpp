@@ -83,7 +83,7 @@ Device::~Device()
 	return nullptr;
 }
 
-rhi::SwapChain* Device::CreateSwapChain(void* nativeWindow, bool useDepthStencil, unsigned int windowWidth, unsigned int windowHeight)
+rhi::SwapChain* Device::CreateSwapChain(void* nativeWindow, bool useDepthStencil, bool preserveContents, unsigned int windowWidth, unsigned int windowHeight)
 {
 	IDXGIDevice* dxgiDevice = nullptr;
 	IDXGIAdapter* adapter = nullptr;
@@ -127,7 +127,7 @@ rhi::SwapChain* Device::CreateSwapChain(void* nativeWindow, bool useDepthStencil
 	scDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
 	scDesc.OutputWindow = reinterpret_cast<HWND>(nativeWindow);
 	scDesc.Windowed = TRUE;
-	scDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
+	scDesc.SwapEffect = preserveContents ? DXGI_SWAP_EFFECT_SEQUENTIAL : DXGI_SWAP_EFFECT_DISCARD;
 
 	scDesc.SampleDesc.Count = 1;
 	scDesc.SampleDesc.Quality = 0;
@@ -202,12 +202,43 @@ ID3DBlob* CompileShaderSource(std::string sourceCodes, std::string entryPoint, s
 
 rhi::VertexShader* Device::CreateVertexShader(const char* source, const char* entry, rhi::Semantic * layouts, rhi::SemanticCount layoutCount)
 {
-
 	cxx::unique_i<ID3DBlob> vsBlob(CompileShaderSource(source, entry, "vs_5_0"));
 
 	if (vsBlob == nullptr)
 		return nullptr;
 
+	return CreateVertexShaderFromBytecode(
+		vsBlob->GetBufferPointer(),
+		static_cast<unsigned int>(vsBlob->GetBufferSize()),
+		layouts, layoutCount);
+}
+
+rhi::PixelShader* Device::CreatePixelShader(const char* source, const char* entry)
+{
+	cxx::unique_i<ID3DBlob> psBlob(CompileShaderSource(source, entry, "ps_5_0"));
+
+	if (psBlob == nullptr)
+		return nullptr;
+
+	return CreatePixelShaderFromBytecode(
+		psBlob->GetBufferPointer(),
+		static_cast<unsigned int>(psBlob->GetBufferSize()));
+}
+
+bool Device::CompileShader(const char* source, const char* entry, rhi::ShaderStage stage, std::vector<uint8_t>& bytecode)
+{
+	cxx::unique_i<ID3DBlob> blob(CompileShaderSource(source, entry, (stage == rhi::ShaderStage::Vertex) ? "vs_5_0" : "ps_5_0"));
+
+	if (blob == nullptr)
+		return false;
+
+	const uint8_t* data = static_cast<const uint8_t*>(blob->GetBufferPointer());
+	bytecode.assign(data, data + blob->GetBufferSize());
+	return true;
+}
+
+rhi::VertexShader* Device::CreateVertexShaderFromBytecode(const void* bytecode, unsigned int length, rhi::Semantic* layouts, rhi::SemanticCount layoutCount)
+{
 	ID3D11VertexShader* vertexShader = nullptr;
 	ID3D11InputLayout* inputLayout = nullptr;
 
@@ -218,8 +249,8 @@ rhi::VertexShader* Device::CreateVertexShader(const char* source, const char* en
 	});
 
 	if (S_OK != m_d3dDevice.CreateVertexShader(
-		vsBlob->GetBufferPointer(),
-		vsBlob->GetBufferSize(),
+		bytecode,
+		length,
 		NULL,
 		&vertexShader))
 	{
@@ -242,7 +273,7 @@ rhi::VertexShader* Device::CreateVertexShader(const char* source, const char* en
 
 	if (S_OK != m_d3dDevice.CreateInputLayout(
 		&(m_inputLayouts[0]), m_inputLayouts.size(),
-		vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(),
+		bytecode, length,
 		&inputLayout))
 	{
 		return nullptr;
@@ -252,18 +283,13 @@ rhi::VertexShader* Device::CreateVertexShader(const char* source, const char* en
 	return new ::VertexShader(vertexShader, inputLayout, std::move(m_semantics));
 }
 
-rhi::PixelShader* Device::CreatePixelShader(const char* source, const char* entry)
+rhi::PixelShader* Device::CreatePixelShaderFromBytecode(const void* bytecode, unsigned int length)
 {
-	cxx::unique_i<ID3DBlob> psBlob(CompileShaderSource(source, entry, "ps_5_0"));
-
-	if (psBlob == nullptr)
-		return nullptr;
-
 	ID3D11PixelShader* pixelShader = nullptr;
 
 	if (S_OK != m_d3dDevice.CreatePixelShader(
-		psBlob->GetBufferPointer(),
-		psBlob->GetBufferSize(),
+		bytecode,
+		length,
 		NULL,
 		&pixelShader))
 	{
@@ -313,6 +339,25 @@ rhi::BlendState* Device::CreateBlendState(bool enabled, rhi::BlendFactor source,
 	}
 }
 
+rhi::DepthStencilState* Device::CreateDepthStencilState(bool depthTest, bool depthWrite)
+{
+	D3D11_DEPTH_STENCIL_DESC depthStencilDesc = {};
+	depthStencilDesc.DepthEnable = depthTest ? TRUE : FALSE;
+	depthStencilDesc.DepthWriteMask = depthWrite ? D3D11_DEPTH_WRITE_MASK_ALL : D3D11_DEPTH_WRITE_MASK_ZERO;
+	depthStencilDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
+	depthStencilDesc.StencilEnable = FALSE;
+
+	ID3D11DepthStencilState* depthStencilState = nullptr;
+	if (S_OK == m_d3dDevice.CreateDepthStencilState(&depthStencilDesc, &depthStencilState))
+	{
+		return new ::DepthStencilState(*depthStencilState, depthTest, depthWrite);
+	}
+	else
+	{
+		return nullptr;
+	}
+}
+
 rhi::TextureSampler* Device::CreateTextureSampler(rhi::SamplerFilter filter, rhi::TextureAddress addressU, rhi::TextureAddress addressV)
 {
 	D3D11_SAMPLER_DESC samlerDesc;
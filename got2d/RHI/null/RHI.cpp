@@ -0,0 +1,145 @@
+#include "inner_RHI.h"
+#include "../../source/scope_utility.h"
+
+namespace
+{
+	// size of back buffer if native window is not given.
+	constexpr unsigned int DefaultWindowWidth = 1280;
+	constexpr unsigned int DefaultWindowHeight = 720;
+}
+
+rhi::RHICreationResult rhi::CreateRHI(bool threadSafeDevice)
+{
+	RHICreationResult result;
+	result.Success = true;
+	result.DevicePtr = new ::Device();
+	result.ContextPtr = new ::Context();
+	return result;
+}
+
+Buffer::Buffer(rhi::BufferBinding binding, rhi::ResourceUsage usage, unsigned int length)
+	: m_bufferBinding(binding)
+	, m_bufferUsage(usage)
+	, m_data(length)
+{
+}
+
+Texture2D::Texture2D(rhi::TextureFormat format, unsigned int binding, unsigned int width, unsigned int height)
+	: m_width(width)
+	, m_height(height)
+	, m_binding(binding)
+	, m_format(format)
+	, m_data(width * height * 4)
+{
+}
+
+VertexShader::VertexShader(std::vector<rhi::Semantic>&& layouts)
+	: m_semantics(std::move(layouts))
+{
+
+}
+
+void VertexShader::Release()
+{
+	if (--m_refCount == 0)
+	{
+		delete this;
+	}
+}
+
+void VertexShader::AddReference()
+{
+	m_refCount++;
+}
+
+rhi::Semantic VertexShader::GetSemanticByIndex(rhi::SemanticIndex index) const
+{
+	ENSURE(index < GetSemanticCount());
+	return m_semantics.at(index);
+}
+
+rhi::SemanticIndex VertexShader::GetSemanticCount() const
+{
+	return static_cast<unsigned int>(m_semantics.size());
+}
+
+void PixelShader::Release()
+{
+	if (--m_refCount == 0)
+	{
+		delete this;
+	}
+}
+
+void PixelShader::AddReference()
+{
+	m_refCount++;
+}
+
+ShaderProgram::ShaderProgram(::VertexShader* vertexShader, ::PixelShader* pixelShader)
+	: m_vertexShader(vertexShader)
+	, m_pixelShader(pixelShader)
+{
+	m_vertexShader->AddReference();
+	m_pixelShader->AddReference();
+}
+
+ShaderProgram::~ShaderProgram()
+{
+	m_vertexShader->Release();
+	m_pixelShader->Release();
+}
+
+BlendState::BlendState(bool enable, rhi::BlendFactor srcFactor, rhi::BlendFactor dstFactor, rhi::BlendOperator blendOp)
+	: m_enabled(enable)
+	, m_srcFactor(srcFactor)
+	, m_dstFactor(dstFactor)
+	, m_blendOp(blendOp)
+{
+
+}
+
+RenderTarget::RenderTarget(unsigned int width, unsigned int height, std::vector<::Texture2D*>&& colorBuffers, ::Texture2D* dsBuffer)
+	: m_width(width)
+	, m_height(height)
+	, m_colorBuffers(std::move(colorBuffers))
+	, m_depthStencilBuffer(dsBuffer)
+{
+
+}
+
+RenderTarget::~RenderTarget()
+{
+	for (auto& t : m_colorBuffers)
+	{
+		SR(t);
+	}
+	m_colorBuffers.clear();
+	SR(m_depthStencilBuffer);
+}
+
+SwapChain::SwapChain(::Device& device, bool useDepthStencil, unsigned int width, unsigned int height)
+	: m_device(device)
+	, m_useDepthStencil(useDepthStencil)
+{
+	OnResize(width > 0 ? width : DefaultWindowWidth, height > 0 ? height : DefaultWindowHeight);
+}
+
+SwapChain::~SwapChain()
+{
+	SR(m_renderTarget);
+}
+
+bool SwapChain::OnResize(unsigned int width, unsigned int height)
+{
+	rhi::TextureFormat format = rhi::TextureFormat::BGRA;
+	::RenderTarget* renderTarget = m_device.CreateRenderTargetImpl(width, height, &format, 1, m_useDepthStencil);
+	if (renderTarget == nullptr)
+		return false;
+
+	SR(m_renderTarget);
+	m_renderTarget = renderTarget;
+	m_windowWidth = width;
+	m_windowHeight = height;
+	return true;
+}
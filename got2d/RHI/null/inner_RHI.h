@@ -0,0 +1,330 @@
+#pragma once
+#include <vector>
+#include "../RHI.h"
+
+// headless backend, resources are kept in system memory
+// and nothing is drawn. used for running the engine without
+// graphics device, e.g. replaying input on build servers.
+
+class Buffer : public rhi::Buffer
+{
+public:
+	virtual void Release() override { delete this; }
+
+	virtual rhi::BufferBinding GetBinding() const override { return m_bufferBinding; }
+
+	virtual rhi::ResourceUsage GetUsage() const override { return m_bufferUsage; }
+
+	virtual unsigned int GetLength() const override { return static_cast<unsigned int>(m_data.size()); }
+
+public:
+	Buffer(rhi::BufferBinding binding, rhi::ResourceUsage usage, unsigned int length);
+
+	void* GetData() { return m_data.data(); }
+
+private:
+	rhi::BufferBinding m_bufferBinding;
+	rhi::ResourceUsage m_bufferUsage;
+	std::vector<uint8_t> m_data;
+};
+
+class Texture2D : public rhi::Texture2D
+{
+public:
+	virtual void Release() override { delete this; }
+
+	virtual unsigned int GetWidth() const override { return m_width; }
+
+	virtual unsigned int GetHeight() const override { return m_height; }
+
+	virtual rhi::TextureFormat GetFormat() const override { return m_format; }
+
+	virtual bool IsRenderTarget() const override { return (m_binding & rhi::TextureBinding::RenderTarget) != 0; }
+
+	virtual bool IsShaderResource() const override { return (m_binding & rhi::TextureBinding::ShaderResource) != 0; }
+
+	virtual bool IsDepthStencil() const override { return (m_binding & rhi::TextureBinding::DepthStencil) != 0; }
+
+public:
+	Texture2D(rhi::TextureFormat format, unsigned int binding, unsigned int width, unsigned int height);
+
+	void* GetData() { return m_data.data(); }
+
+	// 4 bytes per pixel, large enough for all formats.
+	unsigned int GetLinePitch() const { return m_width * 4; }
+
+private:
+	const unsigned int m_width;
+	const unsigned int m_height;
+	const unsigned int m_binding;
+	rhi::TextureFormat m_format;
+	std::vector<uint8_t> m_data;
+};
+
+class VertexShader : public rhi::VertexShader
+{
+public:
+	virtual void Release() override;
+
+	virtual void AddReference() override;
+
+	virtual rhi::Semantic GetSemanticByIndex(rhi::SemanticIndex index) const override;
+
+	virtual rhi::SemanticIndex GetSemanticCount() const override;
+
+public:
+	VertexShader(std::vector<rhi::Semantic>&& layouts);
+
+private:
+	unsigned int m_refCount = 1;
+	std::vector<rhi::Semantic> m_semantics;
+};
+
+class PixelShader : public rhi::PixelShader
+{
+public:
+	virtual void Release() override;
+
+	virtual void AddReference() override;
+
+private:
+	unsigned int m_refCount = 1;
+};
+
+class ShaderProgram : public rhi::ShaderProgram
+{
+public:
+	virtual void Release() override { delete this; }
+
+	virtual rhi::VertexShader* GetVertexShader() const override { return m_vertexShader; }
+
+	virtual rhi::PixelShader* GetPixelShader() const override { return m_pixelShader; }
+
+public:
+	ShaderProgram(::VertexShader* vertexShader, ::PixelShader* pixelShader);
+
+	~ShaderProgram();
+
+private:
+	::VertexShader* m_vertexShader = nullptr;
+	::PixelShader* m_pixelShader = nullptr;
+};
+
+class TextureSampler : public rhi::TextureSampler
+{
+public:
+	virtual void Release() override { delete this; }
+};
+
+class BlendState : public rhi::BlendState
+{
+public:
+	virtual void Release() override { delete this; }
+
+	virtual bool IsEnabled() const override { return m_enabled; }
+
+	virtual rhi::BlendFactor GetSourceFactor() const override { return m_srcFactor; }
+
+	virtual rhi::BlendFactor GetDestinationFactor() const override { return m_dstFactor; }
+
+	virtual rhi::BlendOperator GetOperator() const override { return m_blendOp; }
+
+public:
+	BlendState(bool enable, rhi::BlendFactor srcFactor, rhi::BlendFactor dstFactor, rhi::BlendOperator blendOp);
+
+private:
+	bool m_enabled = false;
+	rhi::BlendFactor m_srcFactor = rhi::BlendFactor::One;
+	rhi::BlendFactor m_dstFactor = rhi::BlendFactor::Zero;
+	rhi::BlendOperator m_blendOp = rhi::BlendOperator::Add;
+};
+
+class DepthStencilState : public rhi::DepthStencilState
+{
+public:
+	virtual void Release() override { delete this; }
+
+	virtual bool IsDepthTestEnabled() const override { return m_depthTest; }
+
+	virtual bool IsDepthWriteEnabled() const override { return m_depthWrite; }
+
+public:
+	DepthStencilState(bool depthTest, bool depthWrite) : m_depthTest(depthTest), m_depthWrite(depthWrite) { }
+
+private:
+	bool m_depthTest;
+	bool m_depthWrite;
+};
+
+class RenderTarget : public rhi::RenderTarget
+{
+public:
+	virtual void Release() { delete this; }
+
+	virtual rhi::Texture2D* GetColorBufferByIndex(rhi::RTIndex index) const override { return m_colorBuffers.at(index); }
+
+	virtual unsigned int GetColorBufferCount() const override { return static_cast<unsigned int>(m_colorBuffers.size()); }
+
+	virtual rhi::Texture2D* GetDepthStencilBuffer() const override { return m_depthStencilBuffer; }
+
+	virtual bool IsDepthStencilUsed() const override { return m_depthStencilBuffer != nullptr; }
+
+	virtual unsigned int GetWidth() const override { return m_width; }
+
+	virtual unsigned int GetHeight() const override { return m_height; }
+
+public:
+	RenderTarget(unsigned int width, unsigned int height, std::vector<::Texture2D*>&& colorBuffers, ::Texture2D* dsBuffer);
+
+	~RenderTarget();
+
+private:
+	const unsigned int m_width;
+	const unsigned int m_height;
+	std::vector<::Texture2D*> m_colorBuffers;
+	::Texture2D* m_depthStencilBuffer;
+};
+
+class Device;
+
+class SwapChain : public rhi::SwapChain
+{
+public:
+	virtual void Release() override { delete this; }
+
+	virtual rhi::RenderTarget* GetBackBuffer() const override { return m_renderTarget; }
+
+	virtual unsigned int GetWidth() const override { return m_windowWidth; }
+
+	virtual unsigned int GetHeight() const override { return m_windowHeight; }
+
+	virtual bool OnResize(unsigned int width, unsigned int height) override;
+
+	virtual void SetFullscreen(bool fullscreen) override { m_fullscreen = fullscreen; }
+
+	virtual bool IsFullscreen() const override { return m_fullscreen; }
+
+	virtual void Present() override { }
+
+public:
+	SwapChain(::Device& device, bool useDepthStencil, unsigned int width, unsigned int height);
+
+	~SwapChain();
+
+private:
+	::Device& m_device;
+	::RenderTarget* m_renderTarget = nullptr;
+	unsigned int m_windowWidth = 0;
+	unsigned int m_windowHeight = 0;
+	const bool m_useDepthStencil;
+	bool m_fullscreen = false;
+};
+
+class Device : public rhi::Device
+{
+public:
+	virtual void Release() override { delete this; }
+
+	virtual rhi::SwapChain* CreateSwapChain(void* nativeWindow, bool useDepthStencil, bool preserveContents, unsigned int windowWidth, unsigned int windowHeight) override;
+
+	virtual rhi::Buffer* CreateBuffer(rhi::BufferBinding binding, rhi::ResourceUsage usage, unsigned int bufferLength) override;
+
+	virtual rhi::Texture2D* CreateTexture2D(rhi::TextureFormat format, rhi::ResourceUsage usage, unsigned int binding, unsigned int width, unsigned int height) override;
+
+	virtual rhi::VertexShader* CreateVertexShader(const char* source, const char* entry, rhi::Semantic* layouts, rhi::SemanticCount layoutCount) override;
+
+	virtual rhi::PixelShader* CreatePixelShader(const char* source, const char* entry) override;
+
+	virtual bool CompileShader(const char* source, const char* entry, rhi::ShaderStage stage, std::vector<uint8_t>& bytecode) override;
+
+	virtual rhi::VertexShader* CreateVertexShaderFromBytecode(const void* bytecode, unsigned int length, rhi::Semantic* layouts, rhi::SemanticCount layoutCount) override;
+
+	virtual rhi::PixelShader* CreatePixelShaderFromBytecode(const void* bytecode, unsigned int length) override;
+
+	virtual rhi::ShaderProgram* LinkShader(rhi::VertexShader* vertexShader, rhi::PixelShader* pixelShader)  override;
+
+	virtual rhi::BlendState* CreateBlendState(bool enabled, rhi::BlendFactor source, rhi::BlendFactor dest, rhi::BlendOperator op) override;
+
+	virtual rhi::TextureSampler* CreateTextureSampler(rhi::SamplerFilter filter, rhi::TextureAddress addressU, rhi::TextureAddress addressV) override;
+
+	virtual rhi::DepthStencilState* CreateDepthStencilState(bool depthTest, bool depthWrite) override;
+
+	virtual rhi::RenderTarget* CreateRenderTarget(unsigned int width, unsigned int height, rhi::TextureFormat* rtFormats, rhi::RTCount rtCount, bool useDpethStencil) override;
+
+public:
+	::RenderTarget* CreateRenderTargetImpl(unsigned int width, unsigned int height, rhi::TextureFormat* rtFormats, unsigned int rtCount, bool useDpethStencil);
+};
+
+class Context : public rhi::Context
+{
+public:
+	virtual void Release() override { delete this; }
+
+	virtual void ClearRenderTarget(rhi::RenderTarget* renderTarget, cxx::color4f clearColor) override { }
+
+	virtual void ClearDepthStencil(rhi::RenderTarget* renderTarget, float depth, uint8_t stencil) override { }
+
+	virtual void SetViewport(const rhi::Viewport& viewport) override { m_viewport = viewport; }
+
+	virtual void SetScissorRect(const rhi::Rect* rect) override { }
+
+	virtual void SetRenderTarget(rhi::RenderTarget* renderTargets) override { }
+
+	virtual void SetVertexBuffers(unsigned int startSlot, rhi::VertexBufferInfo* buffers, unsigned int bufferCount) override { }
+
+	virtual void SetIndexBuffer(rhi::Buffer* buffer, unsigned int offset, rhi::IndexFormat format) override { }
+
+	virtual void SetShaderProgram(rhi::ShaderProgram* program) override { }
+
+	virtual void SetVertexShaderConstantBuffers(unsigned int startSlot, rhi::Buffer** buffers, unsigned int bufferCount) override { }
+
+	virtual void SetPixelShaderConstantBuffers(unsigned int startSlot, rhi::Buffer** buffers, unsigned int bufferCount) override { }
+
+	virtual bool IsConstantBufferRangeSupported() const override { return true; }
+
+	virtual void SetVertexShaderConstantBufferRange(unsigned int slot, rhi::Buffer* buffer, unsigned int offset, unsigned int length) override { }
+
+	virtual void SetPixelShaderConstantBufferRange(unsigned int slot, rhi::Buffer* buffer, unsigned int offset, unsigned int length) override { }
+
+	virtual void SetTextures(unsigned int startSlot, rhi::Texture2D** textures, unsigned int resCount) override { }
+
+	virtual void SetBlendState(rhi::BlendState* state) override { m_blendState = state; }
+
+	virtual void SetDepthStencilState(rhi::DepthStencilState* state) override { m_depthStencilState = state; }
+
+	virtual void SetTextureSampler(unsigned int startSlot, rhi::TextureSampler** samplers, unsigned int count) override { }
+
+	virtual void DrawIndexed(rhi::Primitive primitive, unsigned int indexCount, unsigned int startIndex, unsigned int baseVertex) override;
+
+	virtual rhi::MappedResource Map(rhi::Buffer* buffer) override;
+
+	virtual rhi::MappedResource Map(rhi::Texture2D* buffer) override;
+
+	virtual void Unmap(rhi::Buffer* buffer) override { }
+
+	virtual void Unmap(rhi::Texture2D* buffer) override { }
+
+	virtual void GenerateMipmaps(rhi::Texture2D* textures) override { }
+
+public:
+	// states bound at a DrawIndexed, for checking executed frames.
+	struct DrawRecord
+	{
+		unsigned int IndexCount;
+		rhi::BlendState* BlendState;
+		rhi::DepthStencilState* DepthStencilState;
+		rhi::Viewport Viewport;
+	};
+
+	// records are cleared when starting.
+	void SetDrawRecording(bool recording);
+
+	const std::vector<DrawRecord>& GetDrawRecords() const { return m_drawRecords; }
+
+private:
+	rhi::BlendState* m_blendState = nullptr;
+	rhi::DepthStencilState* m_depthStencilState = nullptr;
+	rhi::Viewport m_viewport;
+	bool m_isDrawRecording = false;
+	std::vector<DrawRecord> m_drawRecords;
+};
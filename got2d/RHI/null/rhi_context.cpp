@@ -0,0 +1,44 @@
+#include "inner_RHI.h"
+
+rhi::MappedResource Context::Map(rhi::Buffer* buffer)
+{
+	rhi::MappedResource mappedRes;
+	if (buffer != nullptr)
+	{
+		::Buffer* bufferImpl = reinterpret_cast<::Buffer*>(buffer);
+		mappedRes.success = true;
+		mappedRes.data = bufferImpl->GetData();
+		mappedRes.linePitch = bufferImpl->GetLength();
+	}
+	return mappedRes;
+}
+
+rhi::MappedResource Context::Map(rhi::Texture2D* buffer)
+{
+	rhi::MappedResource mappedRes;
+	if (buffer != nullptr)
+	{
+		::Texture2D* textureImpl = reinterpret_cast<::Texture2D*>(buffer);
+		mappedRes.success = true;
+		mappedRes.data = textureImpl->GetData();
+		mappedRes.linePitch = textureImpl->GetLinePitch();
+	}
+	return mappedRes;
+}
+
+void Context::DrawIndexed(rhi::Primitive primitive, unsigned int indexCount, unsigned int startIndex, unsigned int baseVertex)
+{
+	if (m_isDrawRecording)
+	{
+		m_drawRecords.push_back({ indexCount, m_blendState, m_depthStencilState, m_viewport });
+	}
+}
+
+void Context::SetDrawRecording(bool recording)
+{
+	m_isDrawRecording = recording;
+	if (recording)
+	{
+		m_drawRecords.clear();
+	}
+}
@@ -0,0 +1,104 @@
+#include <cstring>
+#include "inner_RHI.h"
+#include "../../source/scope_utility.h"
+
+rhi::SwapChain* Device::CreateSwapChain(void* nativeWindow, bool useDepthStencil, bool preserveContents, unsigned int windowWidth, unsigned int windowHeight)
+{
+	return new ::SwapChain(*this, useDepthStencil, windowWidth, windowHeight);
+}
+
+rhi::Buffer* Device::CreateBuffer(rhi::BufferBinding binding, rhi::ResourceUsage usage, unsigned int bufferLength)
+{
+	if (bufferLength == 0)
+		return nullptr;
+
+	return new ::Buffer(binding, usage, bufferLength);
+}
+
+rhi::Texture2D* Device::CreateTexture2D(rhi::TextureFormat format, rhi::ResourceUsage usage, unsigned int binding, unsigned int width, unsigned int height)
+{
+	if (width == 0 || height == 0)
+		return nullptr;
+
+	return new ::Texture2D(format, binding, width, height);
+}
+
+rhi::VertexShader* Device::CreateVertexShader(const char* source, const char* entry, rhi::Semantic* layouts, rhi::SemanticCount layoutCount)
+{
+	// shaders are not compiled, only the layouts are kept.
+	std::vector<rhi::Semantic> semantics(layouts, layouts + layoutCount);
+	return new ::VertexShader(std::move(semantics));
+}
+
+rhi::PixelShader* Device::CreatePixelShader(const char* source, const char* entry)
+{
+	return new ::PixelShader();
+}
+
+bool Device::CompileShader(const char* source, const char* entry, rhi::ShaderStage stage, std::vector<uint8_t>& bytecode)
+{
+	// no compiler, the source itself is the fake bytecode,
+	// shader objects created from it never run anyway.
+	bytecode.assign(source, source + strlen(source));
+	return true;
+}
+
+rhi::VertexShader* Device::CreateVertexShaderFromBytecode(const void* bytecode, unsigned int length, rhi::Semantic* layouts, rhi::SemanticCount layoutCount)
+{
+	std::vector<rhi::Semantic> semantics(layouts, layouts + layoutCount);
+	return new ::VertexShader(std::move(semantics));
+}
+
+rhi::PixelShader* Device::CreatePixelShaderFromBytecode(const void* bytecode, unsigned int length)
+{
+	return new ::PixelShader();
+}
+
+rhi::ShaderProgram* Device::LinkShader(rhi::VertexShader* vertexShader, rhi::PixelShader* pixelShader)
+{
+	if (vertexShader == nullptr || pixelShader == nullptr)
+		return nullptr;
+
+	return new ::ShaderProgram(reinterpret_cast<::VertexShader*>(vertexShader), reinterpret_cast<::PixelShader*>(pixelShader));
+}
+
+rhi::BlendState* Device::CreateBlendState(bool enabled, rhi::BlendFactor source, rhi::BlendFactor dest, rhi::BlendOperator op)
+{
+	return new ::BlendState(enabled, source, dest, op);
+}
+
+rhi::TextureSampler* Device::CreateTextureSampler(rhi::SamplerFilter filter, rhi::TextureAddress addressU, rhi::TextureAddress addressV)
+{
+	return new ::TextureSampler();
+}
+
+rhi::DepthStencilState* Device::CreateDepthStencilState(bool depthTest, bool depthWrite)
+{
+	return new ::DepthStencilState(depthTest, depthWrite);
+}
+
+rhi::RenderTarget* Device::CreateRenderTarget(unsigned int width, unsigned int height, rhi::TextureFormat* rtFormats, rhi::RTCount rtCount, bool useDpethStencil)
+{
+	return CreateRenderTargetImpl(width, height, rtFormats, rtCount, useDpethStencil);
+}
+
+::RenderTarget* Device::CreateRenderTargetImpl(unsigned int width, unsigned int height, rhi::TextureFormat* rtFormats, unsigned int rtCount, bool useDpethStencil)
+{
+	if (width == 0 || height == 0)
+		return nullptr;
+
+	std::vector<::Texture2D*> colorBuffers(rtCount);
+	unsigned int binding = rhi::TextureBinding::ShaderResource | rhi::TextureBinding::RenderTarget;
+	for (unsigned int i = 0; i < rtCount; i++)
+	{
+		colorBuffers[i] = new ::Texture2D(rtFormats[i], binding, width, height);
+	}
+
+	::Texture2D* dsBuffer = nullptr;
+	if (useDpethStencil)
+	{
+		binding = rhi::TextureBinding::ShaderResource | rhi::TextureBinding::DepthStencil;
+		dsBuffer = new ::Texture2D(rhi::TextureFormat::D24S8, binding, width, height);
+	}
+	return new ::RenderTarget(width, height, std::move(colorBuffers), dsBuffer);
+}
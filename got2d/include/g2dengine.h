@@ -30,6 +30,47 @@ namespace g2d
 			*	 Engine will prefix this path to all relative resource-loading paths using in the engine, turning them to absolute paths.
 			*/
 			const char* ResourceFolderPath;
+
+			/** \brief
+			*
+			*	 Number of frames that can be queued before the render thread executing them.
+			*	 0 means rendering in the thread calling RenderSystem::EndRender, without render thread.
+			*	 2 or 3 is recommended for double/triple buffering.
+			*/
+			unsigned int FrameLatency = 0;
+
+			/** \brief
+			*
+			*	 Number of worker threads updating parallel-safe components, see Component::IsParallelSafe.
+			*	 0 means all components are updated in the thread calling Engine::Update.
+			*/
+			unsigned int UpdateWorkerCount = 0;
+
+			/** \brief
+			*
+			*	 Messages are queued by OnMessage and processed at the beginning of next Update,
+			*	 consecutive MouseMove messages are merged into the last one.
+			*	 true means processing every message immediately in OnMessage.
+			*/
+			bool RawInput = false;
+
+			/** \brief
+			*
+			*	 Shader cache built offline by g2dshaderc, shaders are compiled at runtime
+			*	 if the file is missing or out of date, nullptr means always compiling.
+			*	 All shaders are created at initialization either way.
+			*	 Backends without shader compiler can only run with the cache.
+			*/
+			const char* ShaderCachePath = nullptr;
+
+			/** \brief
+			*
+			*	 The back buffer keeps contents between frames, Scene::Render redraws only the
+			*	 regions covering changed nodes, clipped by scissor, and frames without changes
+			*	 are not presented. Changes the scene can not detect, e.g. editing materials,
+			*	 need Scene::InvalidateRegion. Designed for one scene drawing the whole window.
+			*/
+			bool PartialRedraw = false;
 		};
 
 		enum class InitialResult
@@ -81,6 +122,46 @@ namespace g2d
 		*/
 		virtual void OnMessage(const Message& message) = 0;
 
+		/** \brief Inject a message with its time stamp.
+		*
+		*	Works like OnMessage on every platform, the time stamp is in
+		*	milliseconds, accumulated by the delta time passed to Update.
+		*	Used for replaying recorded input streams.
+		*/
+		virtual void InjectMessage(const Message& message, unsigned int timeStamp) = 0;
+
+		/** \brief Record input into a binary log file.
+		*
+		*	Messages passed to OnMessage or InjectMessage and delta times
+		*	passed to Update are written to the log until StopRecording.
+		*/
+		virtual bool StartRecording(const char* filePath) = 0;
+
+		/**
+		*
+		*/
+		virtual void StopRecording() = 0;
+
+		/** \brief Replay a log written by StartRecording.
+		*
+		*	Call ReplayFrame instead of Update each frame while replaying,
+		*	messages passed to OnMessage and system keys states are ignored,
+		*	so that the replay does not depend on the machine running it.
+		*/
+		virtual bool StartReplaying(const char* filePath) = 0;
+
+		/** \brief Replay next recorded frame.
+		*
+		*	Inject messages of the frame and Update with its recorded delta time,
+		*	without waiting for real time. Return false and stop replaying at the end of the log.
+		*/
+		virtual bool ReplayFrame() = 0;
+
+		/**
+		*
+		*/
+		virtual void StopReplaying() = 0;
+
 		/** \brief Create an Engine Instance;
 		*
 		*	Call it when the size of the native render window changed.
@@ -93,7 +93,7 @@ namespace g2d
 		const MessageSource Source = MessageSource::None;
 
 		// Cursor Infos.
-		const MouseButton MouseButton = MouseButton::None;
+		const g2d::MouseButton MouseButton = g2d::MouseButton::None;
 
 		const int CursorPositionX = 0;
 
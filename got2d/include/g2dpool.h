@@ -0,0 +1,169 @@
+#pragma once
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+#include "g2dscene.h"
+
+namespace g2d
+{
+	/** \brief Type-erased component pool
+	*
+	*	Pools register themselves by the class id of their component type,
+	*	so that components of one type can be iterated without knowing
+	*	where they are allocated, see ForEachComponent.
+	*/
+	struct ComponentPoolBase
+	{
+		using Visitor = void(*)(Component* component, void* userData);
+
+		/**
+		*	Class id of components allocated by the pool.
+		*/
+		virtual unsigned int GetComponentClassID() const = 0;
+
+		/**
+		*	Visit all living components in memory order.
+		*/
+		virtual void ForEach(Visitor visitor, void* userData) = 0;
+
+	protected:
+		virtual ~ComponentPoolBase() = default;
+	};
+
+	G2DAPI void RegisterComponentPool(ComponentPoolBase* pool);
+
+	G2DAPI void UnregisterComponentPool(ComponentPoolBase* pool);
+
+	/**
+	*	return nullptr if components of the class are not pooled.
+	*/
+	G2DAPI ComponentPoolBase* FindComponentPool(unsigned int classID);
+
+	/** \brief Chunked storage of one component type
+	*
+	*	Components are constructed in chunks of continuous memory,
+	*	freed slots are reused before allocating new chunks.
+	*	Quad and Camera are pooled by the engine, custom components
+	*	can be pooled by holding a pool of its type and creating the
+	*	components by the pool, T is required to use RTTI_IMPL.
+	*
+	*	e.g.
+	*	static g2d::ComponentPool<MyComponent>& GetPool() { static g2d::ComponentPool<MyComponent> pool; return pool; }
+	*	virtual void Release() override { GetPool().Destroy(this); }
+	*
+	*	All components should be destroyed before the pool,
+	*	Create and Destroy are thread-safe, Traversal is not.
+	*/
+	template<typename T>
+	class ComponentPool : public ComponentPoolBase
+	{
+	public:
+		ComponentPool()
+		{
+			RegisterComponentPool(this);
+		}
+
+		~ComponentPool()
+		{
+			UnregisterComponentPool(this);
+			for (Slot* chunk : mChunks)
+			{
+				delete[] chunk;
+			}
+			mChunks.clear();
+			mFreeSlots.clear();
+		}
+
+		template<typename... TArgs>
+		T* Create(TArgs&&... args)
+		{
+			Slot* slot = nullptr;
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				if (mFreeSlots.empty())
+				{
+					Slot* chunk = new Slot[ChunkSize];
+					mChunks.push_back(chunk);
+
+					// lower address first.
+					for (unsigned int i = ChunkSize; i > 0; i--)
+					{
+						mFreeSlots.push_back(&(chunk[i - 1]));
+					}
+				}
+				slot = mFreeSlots.back();
+				mFreeSlots.pop_back();
+			}
+
+			T* component = new (slot->Storage) T(std::forward<TArgs>(args)...);
+			slot->IsAlive = true;
+			return component;
+		}
+
+		void Destroy(T* component)
+		{
+			Slot* slot = reinterpret_cast<Slot*>(component);
+			slot->IsAlive = false;
+			component->~T();
+
+			std::lock_guard<std::mutex> lock(mMutex);
+			mFreeSlots.push_back(slot);
+		}
+
+		template<typename TVisitor> void Traversal(TVisitor func)
+		{
+			for (Slot* chunk : mChunks)
+			{
+				for (unsigned int i = 0; i < ChunkSize; i++)
+				{
+					if (chunk[i].IsAlive)
+					{
+						func(reinterpret_cast<T*>(chunk[i].Storage));
+					}
+				}
+			}
+		}
+
+		virtual unsigned int GetComponentClassID() const override
+		{
+			return T::GetStaticClassID();
+		}
+
+		virtual void ForEach(Visitor visitor, void* userData) override
+		{
+			Traversal([&](T* component) { visitor(component, userData); });
+		}
+
+	private:
+		constexpr static unsigned int ChunkSize = 256;
+
+		struct Slot
+		{
+			alignas(T) unsigned char Storage[sizeof(T)];
+			bool IsAlive = false;
+		};
+
+		std::mutex mMutex;
+		std::vector<Slot*> mChunks;
+		std::vector<Slot*> mFreeSlots;
+	};
+
+	/** \brief Run the function over all pooled components of the type
+	*
+	*	Components are visited in memory order, T can be Quad, Camera
+	*	or custom components pooled by ComponentPool.
+	*/
+	template<typename T, typename TFunc>
+	void ForEachComponent(TFunc func)
+	{
+		ComponentPoolBase* pool = FindComponentPool(T::GetStaticClassID());
+		if (pool != nullptr)
+		{
+			pool->ForEach([](Component* component, void* userData)
+			{
+				(*static_cast<TFunc*>(userData))(static_cast<T*>(component));
+			}, &func);
+		}
+	}
+}
@@ -11,6 +11,39 @@ namespace g2d
 		Additve,	// src*1 + dst*1
 	};
 
+	// Filtering method of texture sampling.
+	enum class G2DAPI TextureFilter
+	{
+		Linear,		// bilinear with mipmaps
+		Point,		// nearest texel, for pixel arts
+	};
+
+	// Addressing method of texcoord out of [0,1].
+	enum class G2DAPI TextureAddress
+	{
+		Clamp,
+		Repeat,
+		Mirror,
+	};
+
+	/**
+	*	Sampling states of one texture slot,
+	*	default one is the same as sampling without states.
+	*/
+	struct SamplerDesc
+	{
+		TextureFilter Filter = TextureFilter::Linear;
+		TextureAddress AddressU = TextureAddress::Clamp;
+		TextureAddress AddressV = TextureAddress::Clamp;
+
+		bool operator==(const SamplerDesc& other) const
+		{
+			return Filter == other.Filter && AddressU == other.AddressU && AddressV == other.AddressV;
+		}
+
+		bool operator!=(const SamplerDesc& other) const { return !(*this == other); }
+	};
+
 	/**
 	*	Memory layout of Mesh.
 	*/
@@ -147,6 +180,13 @@ namespace g2d
 		// there is no texture in the slot during render process.
 		virtual void SetTexture(unsigned int index, Texture*, bool autoRelease) = 0;
 
+		// Set sampling states of a texture slot, slots never
+		// be set are sampled with the default SamplerDesc.
+		// Passes with different samplers will not be batched.
+		virtual void SetSampler(unsigned int index, const SamplerDesc& desc) = 0;
+
+		virtual const SamplerDesc& GetSampler(unsigned int index) const = 0;
+
 		// Not every slot has solid data, it means some index
 		// may return nullptr when they never be set.
 		virtual Texture* GetTextureByIndex(unsigned int index) const = 0;
@@ -166,14 +206,26 @@ namespace g2d
 		// memory size of pixel constant buffer.
 		virtual unsigned int GetPSConstantLength() const = 0;
 
+		// Changed whenever constants are set, a cloned pass keeps
+		// the version, passes of the same version hold same constants.
+		virtual unsigned int GetConstantVersion() const = 0;
+
+		// Changed whenever anything of the pass is set, including
+		// textures, samplers and blend mode, unique among passes.
+		virtual unsigned int GetStateVersion() const = 0;
+
 		virtual BlendMode GetBlendMode() const = 0;
 	};
 
 	/** \brief
 	*	Material is another rendering resources.
 	*	One material can holds one or more passes,
-	*	each pass will save the material info datas,
-	*	so do NOT use one material with different objects.
+	*	each pass will save the material info datas.
+	*	It is a shared resources, objects differing only in
+	*	tint or texcoord should share one material and pass
+	*	DrawParameters when rendering, so that they can be
+	*	merged into one drawcall. Do NOT modify a material
+	*	while it is being shared.
 	*/
 	struct G2DAPI Material : public Object
 	{
@@ -187,11 +239,15 @@ namespace g2d
 		// Create a new material that rendering with vertex color 
 		static Material* CreateSimpleColor();
 
-		// Call this manually when the material no longer 
-		// being used, to release passes and itself.
-		// Function can ONLY be called ONCE.
+		// Call this manually when the material no longer
+		// being referenced, to decrease reference count.
+		// Passes and itself will be released when count drop to 0.
 		virtual void Release() = 0;
 
+		// Call this manually when material being referenced
+		// to add reference count.
+		virtual void AddRef() = 0;
+
 		// Usually, a material holds one pass, but some can 
 		// holds multiple passes, such as filtering,
 		// silhouette materials, they can invoke multiple drawcalls.
@@ -206,6 +262,51 @@ namespace g2d
 		virtual Material* Clone() const = 0;
 	};
 
+	/** \brief Parameters of one render request
+	*
+	*	They are applied to the vertices when meshes are merged
+	*	into a drawcall, requests sharing one material are drawn
+	*	together even if their parameters are different.
+	*/
+	struct DrawParameters
+	{
+		// multiplied with vertex color.
+		cxx::color4f Tint;
+
+		// texcoord * TexcoordScale + TexcoordOffset
+		cxx::float2 TexcoordScale = cxx::float2::one();
+		cxx::float2 TexcoordOffset = cxx::float2::zero();
+
+		DrawParameters()
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				Tint.value.v[c] = 1.0f;
+			}
+		}
+	};
+
+	/** \brief Fill statistics of the back buffer in one frame
+	*
+	*	Estimated on CPU by rasterizing the submitted geometry
+	*	coarsely, it does not depend on the backend, so it also
+	*	works with the headless one. Overdraw of the frame is
+	*	ShadedPixels / ScreenPixels.
+	*/
+	struct FillStatistics
+	{
+		unsigned int DrawCount = 0;
+		unsigned int OpaqueDrawCount = 0;
+
+		// pixel shader invocations, multiplied by pass count.
+		unsigned long long ShadedPixels = 0;
+
+		// pixels hidden by opaque drawcalls in front of them.
+		unsigned long long RejectedPixels = 0;
+
+		unsigned long long ScreenPixels = 0;
+	};
+
 	/** \brief Predefine the rendering order
 	*
 	*	for register a render requst.
@@ -254,6 +355,28 @@ namespace g2d
 		*/
 		virtual void RenderMesh(unsigned int layer, Mesh* mesh, Material* material, const cxx::float2x3& worldMatrix) = 0;
 
+		/** \brief Register a Rendering Request with per-draw parameters.
+		*
+		*	Material is NOT copied, requests of one material are
+		*	merged into one drawcall with their own parameters.
+		*	\param params tint and texcoord transform of the mesh.
+		*/
+		virtual void RenderMesh(unsigned int layer, Mesh* mesh, Material* material, const cxx::float2x3& worldMatrix, const DrawParameters& params) = 0;
+
+		/** \brief Rendering order of requests submitted by the calling thread.
+		*
+		*	RenderMesh is thread-safe, requests in one layer are drawn by this order.
+		*	Scene sets it before calling Component::OnRender, so worker threads
+		*	spawned by a component should set the order of the component first.
+		*	All submitting must be finished before Scene::Render returns.
+		*	\param sequence requests of the same order are drawn by it, workers
+		*	sharing one order must use different ones, such as their job index,
+		*	the result is not deterministic otherwise.
+		*/
+		virtual void SetSubmissionOrder(unsigned int order, unsigned int sequence = 0) = 0;
+
+		virtual unsigned int GetSubmissionOrder() const = 0;
+
 		/** \brief Rendering window Width
 		*
 		*/
@@ -275,5 +398,82 @@ namespace g2d
 		*	Convert camera-space coordinate to screen-space coordinate.
 		*/
 		virtual cxx::point2d<int> ViewToScreen(const cxx::point2d<float>& view) const = 0;
+
+		/** \brief Quantize vertices when uploading
+		*
+		*	Texcoord will be stored in unorm16, vertex color will
+		*	be stored in unorm8, it halves the vertex size.
+		*	Geometry having any texcoord out of [0,1], such as
+		*	repeating ones or ones transformed by DrawParameters,
+		*	falls back to the standard format as a whole. The
+		*	geometry of a frame is uploaded as one.
+		*/
+		virtual void SetCompactVertexFormat(bool compact) = 0;
+
+		virtual bool IsCompactVertexFormat() const = 0;
+
+		/** \brief Fence of the last frame submitted by EndRender
+		*
+		*	Frames are executed asynchronously if engine is created
+		*	with FrameLatency > 0, resources used by a frame, like the
+		*	textures, can be safely modified after its fence completed.
+		*/
+		virtual unsigned int GetFrameFence() const = 0;
+
+		virtual bool IsFenceCompleted(unsigned int fence) const = 0;
+
+		// block the calling thread until the frame executed.
+		virtual void WaitForFence(unsigned int fence) = 0;
+
+		/** \brief Declare an off-screen render target
+		*
+		*	Cameras render into it by Camera::SetRenderTarget, and
+		*	compositing passes read or write it. Size of the target
+		*	is the window size multiplied by scale, e.g. 0.25 for a
+		*	minimap. It is cleared by the color when it is rendered
+		*	the first time in a frame. Contents of persistent targets
+		*	are kept until they are rendered again, they do not share
+		*	video memory with others, see Camera::SetCached.
+		*	Return false if the name exists or scale is not positive.
+		*/
+		virtual bool DeclareRenderTarget(const char* name, float scale, const cxx::color4f& clearColor, bool persistent) = 0;
+
+		/** \brief Add a compositing pass
+		*
+		*	Draw a full-screen quad into the output target (nullptr
+		*	for the back buffer) with the material, texture slot i of
+		*	the material passes is replaced by the target inputs[i].
+		*	Passes are executed at EndRender after all cameras, in
+		*	the order of their dependency, targets whose lifetime
+		*	do not overlap share one video memory.
+		*	Return false if a target is not declared, or the pass
+		*	reads its output directly or through other passes.
+		*/
+		virtual bool AddCompositePass(const char* output, const char** inputs, unsigned int inputCount, Material* material) = 0;
+
+		// Remove all targets and compositing passes.
+		virtual void ClearCompositor() = 0;
+
+		/** \brief Collect FillStatistics of executed frames
+		*
+		*	Drawcalls whose passes all use BlendMode::None are opaque,
+		*	they are drawn front-to-back with depth writing before the
+		*	blended ones in the back buffer. Counting costs CPU time of
+		*	the thread executing frames, it is disabled by default.
+		*/
+		virtual void SetFillStatisticsEnabled(bool enabled) = 0;
+
+		virtual bool IsFillStatisticsEnabled() const = 0;
+
+		// statistics of the last executed frame, zero if disabled.
+		virtual FillStatistics GetFillStatistics() const = 0;
 	};
+
+	/** \brief Compile built-in shaders into a cache file
+	*
+	*	Used by the offline tool g2dshaderc, without initializing
+	*	the engine. Load the file by CreationConfig::ShaderCachePath.
+	*	return false if the backend has no shader compiler.
+	*/
+	G2DAPI bool BuildShaderCache(const char* filePath);
 }
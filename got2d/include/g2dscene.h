@@ -8,8 +8,27 @@ namespace g2d
 
 	constexpr int DefaultComponentOrder = 0x5000;
 
+	/** \brief Events broadcasting to the whole scene
+	*
+	*	Components subscribe them by Component::GetSubscribedEvents,
+	*	only subscribers receive the events.
+	*/
+	class BroadcastEvent
+	{
+	public:
+		constexpr static unsigned int None = 0;
+		constexpr static unsigned int Update = 1 << 0;
+		constexpr static unsigned int Message = 1 << 1;
+		constexpr static unsigned int KeyPress = 1 << 2;
+		constexpr static unsigned int KeyPressingBegin = 1 << 3;
+		constexpr static unsigned int KeyPressing = 1 << 4;
+		constexpr static unsigned int KeyPressingEnd = 1 << 5;
+		constexpr static unsigned int All = 0xFFFFFFFF;
+	};
+
 	struct Component;
 	struct Camera;
+	struct Material;
 	struct SceneNode;
 	struct Scene;
 
@@ -52,9 +71,21 @@ namespace g2d
 		*/
 		virtual const aabb2d<float>& GetLocalAABB() const { static aabb2d<float> b; return b; }
 
+		/**
+		*	override this function along with GetLocalAABB, and increase
+		*	the version every time the local AABB changes, so that
+		*	the cached world-space AABB can be refreshed.
+		*/
+		virtual unsigned int GetLocalAABBVersion() const { return 0; }
+
 		/**
 		*	AABB in world-space, by defaultm, calculating world-space
 		*	AABB is transforming local AABB with their world transform.
+		*	The result is cached, and refreshed by the thread changing the
+		*	transform of the node. A new version of GetLocalAABBVersion is
+		*	picked up at the next call outside parallel jobs. Calls inside
+		*	jobs never write the cache, so jobs can read the bounds of any
+		*	component not being modified.
 		*/
 		virtual aabb2d<float> GetWorldAABB() const;
 
@@ -64,6 +95,28 @@ namespace g2d
 		*/
 		virtual int GetExecuteOrder() const { return DefaultComponentOrder; }
 
+		/**
+		*	override this function to allow OnUpdate being called in worker threads,
+		*	together with other parallel-safe components of the same execute order.
+		*	It only works when Engine::CreationConfig::UpdateWorkerCount is not 0.
+		*
+		*	A parallel-safe component can read anything, but only writes the states
+		*	of its own and its own scene node. CreateChild, AddComponent, RemoveComponent
+		*	and Release are deferred to the end of the execute order, other changes of
+		*	the scene structure (e.g. MoveToFront) are not allowed in OnUpdate.
+		*	Parallel-safe components are updated before the others of the same execute order.
+		*/
+		virtual bool IsParallelSafe() const { return false; }
+
+		/**
+		*	override this function to receive only the broadcasting events
+		*	the component handles, combination of BroadcastEvent flags.
+		*	OnUpdate, OnMessage and OnKeyXXX will not be called if
+		*	the event is not subscribed. It is read when the component
+		*	is added to the scene node, changing it later takes no effect.
+		*/
+		virtual unsigned int GetSubscribedEvents() const { return BroadcastEvent::All; }
+
 		/**
 		*
 		*/
@@ -245,10 +298,20 @@ namespace g2d
 
 		unsigned int _GetRenderingOrder_Internal() { return mRenderingOrder; }
 
+		void _UpdateWorldAABB_Internal();
+
 	private:
+		aabb2d<float> CalculateWorldAABB() const;
+
 		SceneNode* mAttachNode = nullptr;
 
 		unsigned int mRenderingOrder = 0xFFFFFFFF;
+
+		bool mIsWorldAABBDirty = true;
+
+		unsigned int mWorldAABBVersion = 0;
+
+		aabb2d<float> mWorldAABB;
 	};
 
 	/** \brief Image Quad
@@ -259,6 +322,8 @@ namespace g2d
 	public:
 		static Quad* Create();
 
+		static unsigned int GetStaticClassID();
+
 		/**
 		*	Resize mesh size of the Quad.
 		*/
@@ -268,6 +333,80 @@ namespace g2d
 		*	Get the mesh size of the Quad.
 		*/
 		virtual const float2& GetSize() const = 0;
+
+		/**
+		*	Anchor of the Quad at the origin of its scene node,
+		*	normalized in the size, (0.5, 0.5) for the center.
+		*/
+		virtual Quad* SetPivot(const float2& pivot) = 0;
+
+		virtual const float2& GetPivot() const = 0;
+
+		/**
+		*	Sub-rectangle of the texture, the whole
+		*	texture is (0, 0) with a scale of (1, 1).
+		*/
+		virtual Quad* SetTexcoordRect(const float2& offset, const float2& scale) = 0;
+
+		virtual const float2& GetTexcoordOffset() const = 0;
+
+		virtual const float2& GetTexcoordScale() const = 0;
+
+		/**
+		*	Multiplied with the color of the material.
+		*/
+		virtual Quad* SetColor(const color4f& color) = 0;
+
+		virtual const color4f& GetColor() const = 0;
+	};
+
+	/** \brief Grid of tiles drawn from a tileset atlas
+	*
+	*	Tiles are indices of cells in the atlas, a texture of the
+	*	material divided into columns x rows cells, counted from
+	*	the top-left. Tile (0, 0) is at the origin of the scene
+	*	node, rows go upward. The grid is split into chunks of
+	*	64 x 64 tiles, each chunk keeps its geometry until a tile
+	*	in it changes, and only chunks seen by the camera are drawn.
+	*	Use one Tilemap instead of a scene node for each tile.
+	*/
+	struct G2DAPI Tilemap : public Component
+	{
+	public:
+		constexpr static unsigned int EmptyTile = 0xFFFF;
+
+		static Tilemap* Create(unsigned int columns, unsigned int rows, const float2& tileSize);
+
+		static unsigned int GetStaticClassID();
+
+		virtual unsigned int GetColumnCount() const = 0;
+
+		virtual unsigned int GetRowCount() const = 0;
+
+		virtual const float2& GetTileSize() const = 0;
+
+		/**
+		*	Material is shared, reference count is increased.
+		*	Nothing is drawn until the tileset is set.
+		*/
+		virtual void SetTileset(Material* material, unsigned int atlasColumns, unsigned int atlasRows) = 0;
+
+		virtual Material* GetTilesetMaterial() const = 0;
+
+		/**
+		*	Tiles are empty by default, set EmptyTile to clear.
+		*	Tiles out of the atlas are not drawn.
+		*/
+		virtual void SetTile(unsigned int column, unsigned int row, unsigned int tile) = 0;
+
+		virtual unsigned int GetTile(unsigned int column, unsigned int row) const = 0;
+
+		/**
+		*	RenderLayer::BackGround by default.
+		*/
+		virtual void SetRenderLayer(unsigned int layer) = 0;
+
+		virtual unsigned int GetRenderLayer() const = 0;
 	};
 
 	/**
@@ -276,6 +415,8 @@ namespace g2d
 	struct G2DAPI Camera : public Component
 	{
 	public:
+		static unsigned int GetStaticClassID();
+
 		/**
 		*	Index in scene, index of main(default) camera is 0
 		*/
@@ -326,6 +467,38 @@ namespace g2d
 
 		virtual const float2x3& GetViewMatrix() const = 0;
 
+		/**
+		*	Render into a target declared by RenderSystem::DeclareRenderTarget,
+		*	nullptr or undeclared names for the back buffer.
+		*/
+		virtual void SetRenderTarget(const char* name) = 0;
+
+		/**
+		*	nullptr if the camera renders into the back buffer.
+		*/
+		virtual const char* GetRenderTargetName() const = 0;
+
+		/** \brief Render only when contents are changed
+		*
+		*	A cached camera renders into its target again only if
+		*	nodes matching its mask are added, removed, moved or
+		*	hidden, or the camera itself is changed. In other frames
+		*	the target keeps the last image, composite it by
+		*	RenderSystem::AddCompositePass, e.g. static backgrounds
+		*	and UI. The target must be declared as persistent,
+		*	otherwise the camera renders every frame.
+		*/
+		virtual void SetCached(bool cached) = 0;
+
+		virtual bool IsCached() const = 0;
+
+		/**
+		*	Render the cached camera again in the next frame,
+		*	for changes the scene can not detect, e.g. editing
+		*	materials, meshes or textures of components.
+		*/
+		virtual void Invalidate() = 0;
+
 		/**
 		*	Check whether an AABB is intersect with the camera boundry.
 		*	Point AABB is treat as not visible.
@@ -623,6 +796,26 @@ namespace g2d
 		*/
 		virtual void Render() = 0;
 
+		/**
+		*	Redraw the world region in the next frame, when partial
+		*	redraw is enabled by CreationConfig::PartialRedraw, for
+		*	changes the scene can not detect, e.g. editing materials.
+		*/
+		virtual void InvalidateRegion(const aabb2d<float>& worldRegion) = 0;
+
+		/**
+		*	Batch editing, for building large numbers of nodes.
+		*
+		*	Spatial insertion, transform notification and rendering
+		*	order adjustment are suspended until EndBatchEdit, and
+		*	then done once for all changed nodes. World transforms
+		*	are not updated inside the scope, do not update or
+		*	render the scene before ending it. Calls can be nested.
+		*/
+		virtual void BeginBatchEdit() = 0;
+
+		virtual void EndBatchEdit() = 0;
+
 		/**
 		*
 		*/
@@ -0,0 +1,129 @@
+#pragma once
+#include <cinttypes>
+#include <cstring>
+#include <vector>
+#include "g2dscene.h"
+
+namespace g2d
+{
+	/** \brief Append component payload to a scene file.
+	*/
+	class PayloadWriter
+	{
+	public:
+		PayloadWriter(std::vector<uint8_t>& buffer) : mBuffer(buffer) { }
+
+		void Write(const void* data, unsigned int length)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			mBuffer.insert(mBuffer.end(), bytes, bytes + length);
+		}
+
+		/**
+		*	T should be trivially copyable.
+		*/
+		template<typename T> void Write(const T& value)
+		{
+			Write(&value, sizeof(T));
+		}
+
+	private:
+		std::vector<uint8_t>& mBuffer;
+	};
+
+	/** \brief Read component payload from a scene file.
+	*
+	*	Reading beyond the payload fails and returns false.
+	*/
+	class PayloadReader
+	{
+	public:
+		PayloadReader(const void* data, unsigned int length)
+			: mData(static_cast<const uint8_t*>(data))
+			, mLength(length)
+		{ }
+
+		bool Read(void* data, unsigned int length)
+		{
+			if (mLength - mOffset < length)
+				return false;
+
+			std::memcpy(data, mData + mOffset, length);
+			mOffset += length;
+			return true;
+		}
+
+		/**
+		*	T should be trivially copyable.
+		*/
+		template<typename T> bool Read(T& value)
+		{
+			return Read(&value, sizeof(T));
+		}
+
+		unsigned int GetRemainingLength() const { return mLength - mOffset; }
+
+	private:
+		const uint8_t* mData;
+		unsigned int mLength;
+		unsigned int mOffset = 0;
+	};
+
+	/** \brief Save and load components of one type
+	*
+	*	Register serializers of custom components before saving
+	*	or loading scenes, components without serializers are not
+	*	saved, e.g. Camera. Quad is registered by the engine.
+	*/
+	struct ComponentSerializer
+	{
+		/**
+		*	Name of the type stored in scene files, keep it unchanged
+		*	between versions, files will not be loaded otherwise.
+		*/
+		virtual const char* GetTypeName() const = 0;
+
+		/**
+		*	Class id of components saved by the serializer.
+		*/
+		virtual unsigned int GetComponentClassID() const = 0;
+
+		virtual void Save(Component* component, PayloadWriter& writer) = 0;
+
+		/**
+		*	Create a component by the payload, it will be
+		*	added to the scene node with auto release set.
+		*	return nullptr if the payload is broken.
+		*/
+		virtual Component* Load(PayloadReader& reader) = 0;
+
+	protected:
+		virtual ~ComponentSerializer() = default;
+	};
+
+	G2DAPI void RegisterComponentSerializer(ComponentSerializer* serializer);
+
+	G2DAPI void UnregisterComponentSerializer(ComponentSerializer* serializer);
+
+	/**
+	*	return nullptr if components of the class have no serializer.
+	*/
+	G2DAPI ComponentSerializer* FindComponentSerializer(unsigned int classID);
+
+	G2DAPI ComponentSerializer* FindComponentSerializer(const char* typeName);
+
+	/** \brief Save children of the node into a binary scene file.
+	*
+	*	Hierarchy, transforms, visible/static states, camera visible
+	*	masks and components with serializers are saved.
+	*/
+	G2DAPI bool SaveSceneNodes(SceneNode* parent, const char* filePath);
+
+	/** \brief Load nodes of a scene file as children of the node.
+	*
+	*	Nodes are built in one pass, rendering order and spatial
+	*	graph are updated once after all nodes are loaded.
+	*	Nothing is added if the file is broken.
+	*/
+	G2DAPI bool LoadSceneNodes(SceneNode* parent, const char* filePath);
+}
@@ -20,7 +20,20 @@ g2d::Scene* Engine::CreateNewScene(float sceneBoundSize)
 
 void Engine::Update(unsigned int deltaTime)
 {
+	if (!mInputPlayer.IsOpen())
+	{
+		PollSystemKeys(mElapsedTime + deltaTime);
+	}
+
+	if (mInputRecorder.IsOpen())
+	{
+		mInputRecorder.WriteUpdate(deltaTime);
+	}
+
 	mElapsedTime += deltaTime;
+	mLastUpdateTime = std::chrono::steady_clock::now();
+
+	ProcessQueuedMessages();
 
 	GetKeyboardImpl().Update(mElapsedTime);
 	GetMouseImpl().Update(mElapsedTime);
@@ -33,13 +46,57 @@ void Engine::Update(unsigned int deltaTime)
 
 void Engine::OnMessage(const g2d::Message& message)
 {
-	GetKeyboardImpl().OnMessage(message, mElapsedTime);
-	GetMouseImpl().OnMessage(message, mElapsedTime);
+	// live input breaks the replay.
+	if (mInputPlayer.IsOpen())
+		return;
 
-	for (::Scene* pScene : mSceneList)
+	SubmitMessage(message, mRawInput ? mElapsedTime : GetMessageTimeStamp());
+}
+
+void Engine::InjectMessage(const g2d::Message& message, unsigned int timeStamp)
+{
+	SubmitMessage(message, timeStamp);
+}
+
+bool Engine::StartRecording(const char* filePath)
+{
+	return mInputRecorder.Open(filePath);
+}
+
+void Engine::StopRecording()
+{
+	mInputRecorder.Close();
+}
+
+bool Engine::StartReplaying(const char* filePath)
+{
+	return mInputPlayer.Open(filePath);
+}
+
+bool Engine::ReplayFrame()
+{
+	if (!mInputPlayer.IsOpen())
+		return false;
+
+	unsigned int deltaTime = 0;
+	bool success = mInputPlayer.ReadFrame(deltaTime, [this](const g2d::Message& message, unsigned int timeStamp)
 	{
-		pScene->OnMessage(message, mElapsedTime);
+		SubmitMessage(message, timeStamp);
+	});
+
+	if (!success)
+	{
+		mInputPlayer.Close();
+		return false;
 	}
+
+	Update(deltaTime);
+	return true;
+}
+
+void Engine::StopReplaying()
+{
+	mInputPlayer.Close();
 }
 
 bool Engine::OnResize(unsigned int width, unsigned int height)
@@ -82,22 +139,36 @@ void Engine::Release()
 	return mKeyboard;
 }
 
+::JobSystem& Engine::GetJobSystemImpl()
+{
+	return mJobSystem;
+}
+
 
 //*************************************************************
 // functions
 //*************************************************************
 Engine::~Engine()
 {
+	mJobSystem.Destroy();
 	mRenderSystem.Destroy();
 }
 
 bool Engine::Initialize(const CreationConfig& config)
 {
-	if (!CreateRenderSystem(config.NativeWindow))
+	if (!CreateRenderSystem(config.NativeWindow, config.FrameLatency, config.ShaderCachePath, config.PartialRedraw))
+	{
+		return false;
+	}
+
+	if (!mJobSystem.Create(config.UpdateWorkerCount))
 	{
 		return false;
 	}
 
+	mRawInput = config.RawInput;
+	mLastUpdateTime = std::chrono::steady_clock::now();
+
 	SetResourceRoot(config.ResourceFolderPath);
 	return true;
 }
@@ -127,10 +198,84 @@ const std::string & Engine::GetResourceRoot() const
 //	mSceneList.erase(newEnd, oldEnd);
 //}
 
-bool Engine::CreateRenderSystem(void* nativeWindow)
+unsigned int Engine::GetMessageTimeStamp() const
+{
+	auto realTime = std::chrono::steady_clock::now() - mLastUpdateTime;
+	auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(realTime).count();
+	return mElapsedTime + static_cast<unsigned int>(milliseconds);
+}
+
+void Engine::SubmitMessage(const g2d::Message& message, unsigned int timeStamp)
+{
+	if (mInputRecorder.IsOpen())
+	{
+		mInputRecorder.WriteMessage(message, timeStamp);
+	}
+
+	if (mRawInput)
+	{
+		ProcessMessage(message, timeStamp);
+	}
+	else
+	{
+		QueueMessage(message, timeStamp);
+	}
+}
+
+void Engine::PollSystemKeys(unsigned int timeStamp)
+{
+	auto ALTKey = g2d::KeyCode::Alt;
+	bool ALTDown = AltDownWin32();
+	bool ALTPressing = GetKeyboardImpl().GetPressState(ALTKey) != g2d::SwitchState::Releasing;
+	if (ALTDown && !ALTPressing)
+	{
+		SubmitMessage(g2d::Message(g2d::MessageEvent::KeyDown, ALTKey), timeStamp);
+	}
+	else if (!ALTDown && ALTPressing)
+	{
+		SubmitMessage(g2d::Message(g2d::MessageEvent::KeyUp, ALTKey), timeStamp);
+	}
+}
+
+void Engine::QueueMessage(const g2d::Message& message, unsigned int timeStamp)
+{
+	// only the last cursor position matters to picking and dragging.
+	if (message.Event == g2d::MessageEvent::MouseMove && !mMessageQueue.empty() &&
+		mMessageQueue.back().Message.Event == g2d::MessageEvent::MouseMove)
+	{
+		mMessageQueue.pop_back();
+	}
+	mMessageQueue.push_back({ message, timeStamp });
+}
+
+void Engine::ProcessMessage(const g2d::Message& message, unsigned int timeStamp)
+{
+	GetKeyboardImpl().OnMessage(message, timeStamp);
+	GetMouseImpl().OnMessage(message, timeStamp);
+
+	for (::Scene* pScene : mSceneList)
+	{
+		pScene->OnMessage(message, timeStamp);
+	}
+}
+
+void Engine::ProcessQueuedMessages()
+{
+	// messages queued by receivers are processed next frame.
+	mProcessingMessages.swap(mMessageQueue);
+	for (const QueuedMessage& queued : mProcessingMessages)
+	{
+		// time stamps never go beyond the time of current frame,
+		// keeps press durations measured by input devices valid.
+		ProcessMessage(queued.Message, std::min(queued.TimeStamp, mElapsedTime));
+	}
+	mProcessingMessages.clear();
+}
+
+bool Engine::CreateRenderSystem(void* nativeWindow, unsigned int frameLatency, const char* shaderCachePath, bool partialRedraw)
 {
 	mNativeWindow = nativeWindow;
-	if (!mRenderSystem.Create(nativeWindow))
+	if (!mRenderSystem.Create(nativeWindow, frameLatency, shaderCachePath, partialRedraw))
 	{
 		return false;
 	}
@@ -1,10 +1,13 @@
 #pragma once
+#include <chrono>
 #include <vector>
 #include <string>
 #include "g2dengine.h"
 #include "render/render_system.h"
 #include "scene/scene.h"
 #include "input/input.h"
+#include "input/input_record.h"
+#include "job_system.h"
 
 class Engine : public g2d::Engine
 {
@@ -18,6 +21,18 @@ public:
 
 	virtual void OnMessage(const g2d::Message& message) override;
 
+	virtual void InjectMessage(const g2d::Message& message, unsigned int timeStamp) override;
+
+	virtual bool StartRecording(const char* filePath) override;
+
+	virtual void StopRecording() override;
+
+	virtual bool StartReplaying(const char* filePath) override;
+
+	virtual bool ReplayFrame() override;
+
+	virtual void StopReplaying() override;
+
 	virtual bool OnResize(unsigned int width, unsigned int height) override;
 
 	virtual void Release() override;
@@ -30,6 +45,8 @@ public:
 
 	::Keyboard& GetKeyboardImpl();
 
+	::JobSystem& GetJobSystemImpl();
+
 public:
 	static Engine* Instance;
 
@@ -46,17 +63,49 @@ public:
 	//void RemoveScene(::Scene& scene);
 
 private:
-	bool CreateRenderSystem(void* nativeWindow);
+	bool CreateRenderSystem(void* nativeWindow, unsigned int frameLatency, const char* shaderCachePath, bool partialRedraw);
+
+	// elapsed time plus real time passed since last Update.
+	unsigned int GetMessageTimeStamp() const;
+
+	// record and deliver the message, in queue or immediately.
+	void SubmitMessage(const g2d::Message& message, unsigned int timeStamp);
+
+	// keys that can not be known by messages.
+	void PollSystemKeys(unsigned int timeStamp);
+
+	void QueueMessage(const g2d::Message& message, unsigned int timeStamp);
+
+	void ProcessMessage(const g2d::Message& message, unsigned int timeStamp);
+
+	void ProcessQueuedMessages();
+
+	struct QueuedMessage
+	{
+		g2d::Message Message;
+		unsigned int TimeStamp;
+	};
 
 	void* mNativeWindow = nullptr;
 
 	unsigned int mElapsedTime = 0;
 
+	std::chrono::steady_clock::time_point mLastUpdateTime;
+
+	bool mRawInput = false;
+
+	std::vector<QueuedMessage> mMessageQueue;
+	std::vector<QueuedMessage> mProcessingMessages;
+
+	InputRecorder mInputRecorder;
+	InputPlayer mInputPlayer;
+
 	std::string mResourceRoot;
 
 	RenderSystem	mRenderSystem;
 	Mouse			mMouse;
 	Keyboard		mKeyboard;
+	JobSystem		mJobSystem;
 
 	std::vector<::Scene*> mSceneList;
 };
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "render/material.h"
 #include "render/pass.h"
 #include "render/texture.h"
+#include "render/shader.h"
 
 namespace g2d
 {
@@ -27,4 +28,17 @@ namespace g2d
 		mat->SetPass(0, new ::Pass("default", "simple.color"));
 		return mat;
 	}
+
+	bool BuildShaderCache(const char* filePath)
+	{
+		rhi::RHICreationResult rhiResult = rhi::CreateRHI(false);
+		if (!rhiResult.Success)
+			return false;
+
+		ShaderLib shaderLib;
+		bool success = shaderLib.CompileSources(rhiResult.DevicePtr) && shaderLib.SaveCache(filePath);
+		rhiResult.ContextPtr->Release();
+		rhiResult.DevicePtr->Release();
+		return success;
+	}
 }
\ No newline at end of file
@@ -1,30 +1,205 @@
+#include <map>
 #include "g2dscene.h"
+#include "g2dpool.h"
+#include "g2dserialize.h"
+#include "scope_utility.h"
+#include "job_system.h"
 #include "scene/quad.h"
+#include "scene/tilemap.h"
+#include "scene/camera.h"
+#include "scene/scene_node.h"
+#include "scene/scene_serializer.h"
 
 namespace g2d
 {
 	Quad* Quad::Create()
 	{
-		return new ::Quad();
+		return ::Quad::GetPool().Create();
 	}
 
+	unsigned int Quad::GetStaticClassID()
+	{
+		return ::Quad::GetStaticClassID();
+	}
 
-	cxx::aabb2d<float> Component::GetWorldAABB() const
+	Tilemap* Tilemap::Create(unsigned int columns, unsigned int rows, const float2& tileSize)
 	{
-		if (!GetLocalAABB().is_valid())
+		return new ::Tilemap(columns, rows, tileSize);
+	}
+
+	unsigned int Tilemap::GetStaticClassID()
+	{
+		return ::Tilemap::GetStaticClassID();
+	}
+
+	unsigned int Camera::GetStaticClassID()
+	{
+		return ::Camera::GetStaticClassID();
+	}
+
+	namespace
+	{
+		struct ComponentPoolRegistry
 		{
-			return GetLocalAABB();
+			std::mutex Mutex;
+			std::map<unsigned int, ComponentPoolBase*> Pools;
+		};
+
+		ComponentPoolRegistry& GetComponentPoolRegistry()
+		{
+			static ComponentPoolRegistry sRegistry;
+			return sRegistry;
+		}
+	}
+
+	void RegisterComponentPool(ComponentPoolBase* pool)
+	{
+		auto& registry = GetComponentPoolRegistry();
+		std::lock_guard<std::mutex> lock(registry.Mutex);
+		registry.Pools[pool->GetComponentClassID()] = pool;
+	}
+
+	void UnregisterComponentPool(ComponentPoolBase* pool)
+	{
+		auto& registry = GetComponentPoolRegistry();
+		std::lock_guard<std::mutex> lock(registry.Mutex);
+		auto itFound = registry.Pools.find(pool->GetComponentClassID());
+		if (itFound != registry.Pools.end() && itFound->second == pool)
+		{
+			registry.Pools.erase(itFound);
 		}
-		else
+	}
+
+	ComponentPoolBase* FindComponentPool(unsigned int classID)
+	{
+		auto& registry = GetComponentPoolRegistry();
+		std::lock_guard<std::mutex> lock(registry.Mutex);
+		auto itFound = registry.Pools.find(classID);
+		return (itFound != registry.Pools.end()) ? itFound->second : nullptr;
+	}
+
+	namespace
+	{
+		struct ComponentSerializerRegistry
+		{
+			std::mutex Mutex;
+			std::map<unsigned int, ComponentSerializer*> Serializers;
+		};
+
+		ComponentSerializerRegistry& GetComponentSerializerRegistry()
 		{
-			float2x3 worldMatrix = GetSceneNode()->GetWorldMatrix();
-			return transform(worldMatrix, GetLocalAABB());
+			static ComponentSerializerRegistry sRegistry;
+			return sRegistry;
 		}
 	}
 
+	void RegisterComponentSerializer(ComponentSerializer* serializer)
+	{
+		auto& registry = GetComponentSerializerRegistry();
+		std::lock_guard<std::mutex> lock(registry.Mutex);
+		registry.Serializers[serializer->GetComponentClassID()] = serializer;
+	}
+
+	void UnregisterComponentSerializer(ComponentSerializer* serializer)
+	{
+		auto& registry = GetComponentSerializerRegistry();
+		std::lock_guard<std::mutex> lock(registry.Mutex);
+		auto itFound = registry.Serializers.find(serializer->GetComponentClassID());
+		if (itFound != registry.Serializers.end() && itFound->second == serializer)
+		{
+			registry.Serializers.erase(itFound);
+		}
+	}
+
+	ComponentSerializer* FindComponentSerializer(unsigned int classID)
+	{
+		auto& registry = GetComponentSerializerRegistry();
+		std::lock_guard<std::mutex> lock(registry.Mutex);
+		auto itFound = registry.Serializers.find(classID);
+		return (itFound != registry.Serializers.end()) ? itFound->second : nullptr;
+	}
+
+	ComponentSerializer* FindComponentSerializer(const char* typeName)
+	{
+		auto& registry = GetComponentSerializerRegistry();
+		std::lock_guard<std::mutex> lock(registry.Mutex);
+		for (auto& pair : registry.Serializers)
+		{
+			if (std::strcmp(pair.second->GetTypeName(), typeName) == 0)
+				return pair.second;
+		}
+		return nullptr;
+	}
+
+	bool SaveSceneNodes(SceneNode* parent, const char* filePath)
+	{
+		ENSURE(parent != nullptr && filePath != nullptr);
+		SceneSaver saver;
+		saver.SaveChildren(parent);
+		return saver.WriteFile(filePath);
+	}
+
+	bool LoadSceneNodes(SceneNode* parent, const char* filePath)
+	{
+		ENSURE(parent != nullptr && filePath != nullptr);
+		std::FILE* file = std::fopen(filePath, "rb");
+		if (file == nullptr)
+			return false;
+
+		std::vector<uint8_t> data;
+		std::fseek(file, 0, SEEK_END);
+		long length = std::ftell(file);
+		std::fseek(file, 0, SEEK_SET);
+		if (length > 0)
+		{
+			data.resize(static_cast<size_t>(length));
+			if (std::fread(data.data(), 1, data.size(), file) != data.size())
+			{
+				data.clear();
+			}
+		}
+		std::fclose(file);
+
+		SceneLoader loader(data);
+		return loader.Load(reinterpret_cast<::SceneNode*>(parent));
+	}
+
+
+	cxx::aabb2d<float> Component::GetWorldAABB() const
+	{
+		if (mIsWorldAABBDirty || mWorldAABBVersion != GetLocalAABBVersion())
+		{
+			// other jobs may be reading the cache.
+			if (JobSystem::IsInJob())
+			{
+				return CalculateWorldAABB();
+			}
+			const_cast<Component*>(this)->_UpdateWorldAABB_Internal();
+		}
+		return mWorldAABB;
+	}
+
 	void Component::_SetSceneNode_Internal(g2d::SceneNode* node)
 	{
 		mAttachNode = node;
+		mIsWorldAABBDirty = true;
+	}
+
+	void Component::_UpdateWorldAABB_Internal()
+	{
+		mIsWorldAABBDirty = false;
+		mWorldAABBVersion = GetLocalAABBVersion();
+		mWorldAABB = CalculateWorldAABB();
+	}
+
+	aabb2d<float> Component::CalculateWorldAABB() const
+	{
+		if (!GetLocalAABB().is_valid())
+		{
+			return GetLocalAABB();
+		}
+		const float2x3& worldMatrix = GetSceneNode()->GetWorldMatrix();
+		return transform(worldMatrix, GetLocalAABB());
 	}
 
 	void Component::_SetRenderingOrder_Internal(unsigned int& order)
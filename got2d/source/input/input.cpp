@@ -28,13 +28,14 @@ void MouseEvent::NotifyAll(g2d::MouseButton button)
 }
 
 
-Keyboard::~Keyboard()
+Keyboard::Keyboard()
 {
-	for (auto& keyState : mStates)
+	for (unsigned int i = 0; i < KeyTableSize; i++)
 	{
-		delete keyState.second;
+		unsigned int page = i / KeyPageSize;
+		unsigned int code = (page == 0 ? 0 : g2d::NUMPAD_OFFSET + (page - 1) * KeyPageSize) + i % KeyPageSize;
+		mStates[i].Key = static_cast<g2d::KeyCode>(code);
 	}
-	mStates.clear();
 }
 
 g2d::SwitchState Keyboard::GetPressState(g2d::KeyCode key) const
@@ -49,69 +50,77 @@ unsigned int Keyboard::GetRepeatingCount(g2d::KeyCode key) const
 
 bool Keyboard::IsFree() const
 {
-	for (auto& key : mStates)
+	return mPressedKeys.empty();
+}
+
+unsigned int Keyboard::GetKeyIndex(g2d::KeyCode key)
+{
+	unsigned int code = static_cast<unsigned int>(key);
+	unsigned int page = code / KeyPageSize;
+	if (page == 0)
 	{
-		if (key.second->State() != g2d::SwitchState::Releasing)
-			return false;
+		return code;
 	}
-	return true;
+
+	page = (page - g2d::NUMPAD_OFFSET / KeyPageSize) + 1;
+	if (page > 0 && page < KeyTableSize / KeyPageSize)
+	{
+		return page * KeyPageSize + code % KeyPageSize;
+	}
+	return static_cast<unsigned int>(g2d::KeyCode::Invalid);
 }
 
-void Keyboard::CreateKeyState(g2d::KeyCode key)
+Keyboard::KeyState& Keyboard::GetState(g2d::KeyCode key)
 {
-	mStates.insert({ key, new KeyState(key) });
-	mStates[key]->OnPress = [this](KeyState& state) { this->OnPress.NotifyAll(state.Key); };
-	mStates[key]->OnPressingBegin = [this](KeyState& state) { this->OnPressingBegin.NotifyAll(state.Key); };
-	mStates[key]->OnPressing = [this](KeyState& state) { this->OnPressing.NotifyAll(state.Key); };
-	mStates[key]->OnPressingEnd = [this](KeyState& state) { this->OnPressingEnd.NotifyAll(state.Key); };
+	return mStates[GetKeyIndex(key)];
+}
 
+const Keyboard::KeyState& Keyboard::GetState(g2d::KeyCode key) const
+{
+	return mStates[GetKeyIndex(key)];
+}
+
+void Keyboard::OnKeyPressed(g2d::KeyCode key)
+{
+	mPressedKeys.push_back(key);
 }
 
-Keyboard::KeyState& Keyboard::GetState(g2d::KeyCode key) const
+void Keyboard::OnKeyReleased(g2d::KeyCode key)
 {
-	if (mStates.count(key) == 0)
+	auto itEnd = mPressedKeys.end();
+	auto itFound = std::find(mPressedKeys.begin(), itEnd, key);
+	if (itFound != itEnd)
 	{
-		const_cast<Keyboard*>(this)->CreateKeyState(key);
+		mPressedKeys.erase(itFound);
 	}
-	return *(mStates.at(key));
 }
 
 void Keyboard::OnMessage(const g2d::Message& message, unsigned int currentTimeStamp)
 {
 	if (message.Source == g2d::MessageSource::Keyboard)
 	{
-		GetState(message.Key).OnMessage(message, currentTimeStamp);
+		GetState(message.Key).OnMessage(*this, message, currentTimeStamp);
 	}
 	else if (message.Event == g2d::MessageEvent::LostFocus)
 	{
-		for (auto& keyState : mStates)
+		// released keys are erased from the list.
+		while (!mPressedKeys.empty())
 		{
-			keyState.second->ForceRelease();
+			GetState(mPressedKeys.back()).ForceRelease(*this);
 		}
 	}
 }
 
 void Keyboard::Update(unsigned int currentTimeStamp)
 {
-	auto ALTKey = g2d::KeyCode::Alt;
-	auto ALTDown = AltDownWin32();
-	auto& ALTState = GetState(ALTKey);
-	bool ALTPressing = ALTState.State() != g2d::SwitchState::Releasing;
-	if (ALTDown && !ALTPressing)
-	{
-		ALTState.OnMessage(g2d::Message(g2d::MessageEvent::KeyDown, ALTKey), currentTimeStamp);
-	}
-	else if (!ALTDown && ALTPressing)
-	{
-		ALTState.OnMessage(g2d::Message(g2d::MessageEvent::KeyUp, ALTKey), currentTimeStamp);
-	}
-	for (auto& keyState : mStates)
+	// only pressed keys have something to update.
+	for (size_t i = 0; i < mPressedKeys.size(); i++)
 	{
-		keyState.second->Update(currentTimeStamp);
+		GetState(mPressedKeys[i]).Update(*this, currentTimeStamp);
 	}
 }
 
-void Keyboard::KeyState::OnMessage(const g2d::Message& message, unsigned int currentTimeStamp)
+void Keyboard::KeyState::OnMessage(Keyboard& keyboard, const g2d::Message& message, unsigned int currentTimeStamp)
 {
 	if (message.Event == g2d::MessageEvent::KeyDown)
 	{
@@ -122,66 +131,52 @@ void Keyboard::KeyState::OnMessage(const g2d::Message& message, unsigned int cur
 		{
 			state = g2d::SwitchState::JustPressed;
 			pressTimeStamp = currentTimeStamp;
+			keyboard.OnKeyPressed(Key);
 		}
 	}
 	else if (message.Event == g2d::MessageEvent::KeyUp)
 	{
-		if (state == g2d::SwitchState::JustPressed)
-		{
-			OnPress(*this);
-		}
-		else if (state == g2d::SwitchState::Pressing)
-		{
-			OnPressingEnd(*this);
-			repeatCount = 0;
-		}
-		else
-		{
-			// unexpected state
-		}
-		state = g2d::SwitchState::Releasing;
+		ForceRelease(keyboard);
 	}
 }
 
-void Keyboard::KeyState::Update(unsigned int currentTimeStamp)
+void Keyboard::KeyState::Update(Keyboard& keyboard, unsigned int currentTimeStamp)
 {
 	if (state == g2d::SwitchState::JustPressed && (currentTimeStamp - pressTimeStamp) > PRESSING_INTERVAL)
 	{
 		state = g2d::SwitchState::Pressing;
-		OnPressingBegin(*this);
+		keyboard.OnPressingBegin.NotifyAll(Key);
 		repeatCount = 1;
 	}
 	if (state == g2d::SwitchState::Pressing)
 	{
-		OnPressing(*this);
+		keyboard.OnPressing.NotifyAll(Key);
 		repeatCount++;
 	}
 }
 
-inline void Keyboard::KeyState::ForceRelease()
+void Keyboard::KeyState::ForceRelease(Keyboard& keyboard)
 {
+	if (state == g2d::SwitchState::Releasing)
+		return;
+
 	if (state == g2d::SwitchState::JustPressed)
 	{
-		OnPress(*this);
+		keyboard.OnPress.NotifyAll(Key);
 	}
 	else if (state == g2d::SwitchState::Pressing)
 	{
-		OnPressingEnd(*this);
+		keyboard.OnPressingEnd.NotifyAll(Key);
 		repeatCount = 0;
 	}
 	state = g2d::SwitchState::Releasing;
+	keyboard.OnKeyReleased(Key);
 }
 
 Mouse::Mouse()
 	: mButtons{ g2d::MouseButton::Left, g2d::MouseButton::Middle, g2d::MouseButton::Right, }
 {
-	for (auto& button : mButtons)
-	{
-		button.OnPress = [this](ButtonState& state) { this->OnPress.NotifyAll(state.Button); };
-		button.OnPressingBegin = [this](ButtonState& state) { this->OnPressingBegin.NotifyAll(state.Button); };
-		button.OnPressing = [this](ButtonState& state) { this->OnPressing.NotifyAll(state.Button); };
-		button.OnPressingEnd = [this](ButtonState& state) { this->OnPressingEnd.NotifyAll(state.Button); };
-	}
+
 }
 
 void Mouse::OnMessage(const g2d::Message& message, unsigned int currentTimeStamp)
@@ -193,7 +188,7 @@ void Mouse::OnMessage(const g2d::Message& message, unsigned int currentTimeStamp
 			mCursorPosition = cxx::int2(message.CursorPositionX, message.CursorPositionY);
 			for (auto& button : mButtons)
 			{
-				button.BeginDrag();
+				button.BeginDrag(*this);
 			}
 			this->OnMoving.NotifyAll(g2d::MouseButton::None);
 		}
@@ -214,7 +209,7 @@ void Mouse::OnMessage(const g2d::Message& message, unsigned int currentTimeStamp
 				for (auto& button : mButtons)
 				{
 					if (message.MouseButton == button.Button)
-						button.OnMessage(message, currentTimeStamp);
+						button.OnMessage(*this, message, currentTimeStamp);
 				}
 			}
 		}
@@ -223,7 +218,7 @@ void Mouse::OnMessage(const g2d::Message& message, unsigned int currentTimeStamp
 	{
 		for (auto& button : mButtons)
 		{
-			button.ForceRelease();
+			button.ForceRelease(*this);
 		}
 	}
 }
@@ -232,7 +227,7 @@ void Mouse::Update(unsigned int currentTimeStamp)
 {
 	for (auto& button : mButtons)
 	{
-		button.Update(currentTimeStamp);
+		button.Update(*this, currentTimeStamp);
 	}
 }
 
@@ -287,18 +282,18 @@ Mouse::ButtonState& Mouse::GetButton(g2d::MouseButton& button)
 	return mButtons[(int)button];
 }
 
-void Mouse::ButtonState::BeginDrag()
+void Mouse::ButtonState::BeginDrag(Mouse& mouse)
 {
 	if (state == g2d::SwitchState::JustPressed)
 	{
 		state = g2d::SwitchState::Pressing;
-		OnPressingBegin(*this);
+		mouse.OnPressingBegin.NotifyAll(Button);
 		repeatCount = 1;
 		repeated = true;
 	}
 }
 
-void Mouse::ButtonState::OnMessage(const g2d::Message& message, unsigned int currentTimeStamp)
+void Mouse::ButtonState::OnMessage(Mouse& mouse, const g2d::Message& message, unsigned int currentTimeStamp)
 {
 	if (message.Event == g2d::MessageEvent::MouseButtonDown)
 	{
@@ -309,7 +304,7 @@ void Mouse::ButtonState::OnMessage(const g2d::Message& message, unsigned int cur
 		else if (state != g2d::SwitchState::Pressing)
 		{
 			// unexpected state
-			OnPressingEnd(*this);
+			mouse.OnPressingEnd.NotifyAll(Button);
 			repeated = true;
 			repeatCount = 0;
 		}
@@ -321,11 +316,11 @@ void Mouse::ButtonState::OnMessage(const g2d::Message& message, unsigned int cur
 	{
 		if (state == g2d::SwitchState::JustPressed)
 		{
-			OnPress(*this);
+			mouse.OnPress.NotifyAll(Button);
 		}
 		else if (state == g2d::SwitchState::Pressing)
 		{
-			OnPressingEnd(*this);
+			mouse.OnPressingEnd.NotifyAll(Button);
 			repeated = true;
 			repeatCount = 0;
 		}
@@ -337,33 +332,33 @@ void Mouse::ButtonState::OnMessage(const g2d::Message& message, unsigned int cur
 	}
 }
 
-void Mouse::ButtonState::Update(unsigned int currentTimeStamp)
+void Mouse::ButtonState::Update(Mouse& mouse, unsigned int currentTimeStamp)
 {
 	if (state == g2d::SwitchState::JustPressed && (currentTimeStamp - pressTimeStamp) > PRESSING_INTERVAL)
 	{
 		state = g2d::SwitchState::Pressing;
-		OnPressingBegin(*this);
+		mouse.OnPressingBegin.NotifyAll(Button);
 		repeatCount = 1;
 		repeated = true;
 	}
 	if (state == g2d::SwitchState::Pressing && !repeated)
 	{
-		OnPressing(*this);
+		mouse.OnPressing.NotifyAll(Button);
 		repeatCount++;
 		repeated = true;
 	}
 	repeated = false;
 }
 
-void Mouse::ButtonState::ForceRelease()
+void Mouse::ButtonState::ForceRelease(Mouse& mouse)
 {
 	if (state == g2d::SwitchState::JustPressed)
 	{
-		OnPress(*this);
+		mouse.OnPress.NotifyAll(Button);
 	}
 	else if (state == g2d::SwitchState::Pressing)
 	{
-		OnPressingEnd(*this);
+		mouse.OnPressingEnd.NotifyAll(Button);
 		repeatCount = 0;
 	}
 	state = g2d::SwitchState::Releasing;
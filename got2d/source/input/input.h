@@ -1,7 +1,6 @@
 #pragma once
-#include <functional>
+#include <algorithm>
 #include <vector>
-#include <map>
 #include "cxx_math/cxx_aabb.h"
 #include "g2dinput.h"
 
@@ -69,7 +68,7 @@ public:
 public:
 	static Keyboard Instance;
 
-	~Keyboard();
+	Keyboard();
 
 	void OnMessage(const g2d::Message& message, unsigned int currentTimeStamp);
 
@@ -84,28 +83,40 @@ private:
 	class KeyState
 	{
 		unsigned int repeatCount = 0;
-		unsigned int pressTimeStamp;
+		unsigned int pressTimeStamp = 0;
 		g2d::SwitchState state = g2d::SwitchState::Releasing;
 	public:
-		const g2d::KeyCode Key;
+		g2d::KeyCode Key = g2d::KeyCode::Invalid;
 
 		g2d::SwitchState State() const { return state; }
 
 		unsigned int RepeatingCount() const { return repeatCount; }
 
-		KeyState(g2d::KeyCode key) : Key(key) { }
-		void OnMessage(const g2d::Message& message, unsigned int currentTimeStamp);
-		void Update(unsigned int currentTimeStamp);
-		void ForceRelease();
-		std::function<void(KeyState&)> OnPress = nullptr;
-		std::function<void(KeyState&)> OnPressingBegin = nullptr;
-		std::function<void(KeyState&)> OnPressing = nullptr;
-		std::function<void(KeyState&)> OnPressingEnd = nullptr;
-
+		void OnMessage(Keyboard& keyboard, const g2d::Message& message, unsigned int currentTimeStamp);
+		void Update(Keyboard& keyboard, unsigned int currentTimeStamp);
+		void ForceRelease(Keyboard& keyboard);
 	};
-	KeyState& GetState(g2d::KeyCode key) const;
-	void CreateKeyState(g2d::KeyCode key);
-	std::map<g2d::KeyCode, KeyState*> mStates;
+
+	// key codes are spread over 3 pages: characters
+	// in 0x00XX, numpad in 0x10XX and F area in 0x11XX.
+	constexpr static unsigned int KeyPageSize = 0x100;
+	constexpr static unsigned int KeyTableSize = KeyPageSize * 3;
+
+	// unknown key codes share the slot of KeyCode::Invalid.
+	static unsigned int GetKeyIndex(g2d::KeyCode key);
+
+	KeyState& GetState(g2d::KeyCode key);
+
+	const KeyState& GetState(g2d::KeyCode key) const;
+
+	void OnKeyPressed(g2d::KeyCode key);
+
+	void OnKeyReleased(g2d::KeyCode key);
+
+	KeyState mStates[KeyTableSize];
+
+	// keys not in releasing state, in the order of pressing.
+	std::vector<g2d::KeyCode> mPressedKeys;
 };
 
 class Mouse : public g2d::Mouse
@@ -155,14 +166,10 @@ private:
 		unsigned int RepeatingCount() const { return repeatCount; }
 
 		ButtonState(g2d::MouseButton btn) : Button(btn) { }
-		void OnMessage(const g2d::Message& message, unsigned int currentTimeStamp);
-		void BeginDrag();
-		void Update(unsigned int currentTimeStamp);
-		void ForceRelease();
-		std::function<void(ButtonState&)> OnPress = nullptr;
-		std::function<void(ButtonState&)> OnPressingBegin = nullptr;
-		std::function<void(ButtonState&)> OnPressing = nullptr;
-		std::function<void(ButtonState&)> OnPressingEnd = nullptr;
+		void OnMessage(Mouse& mouse, const g2d::Message& message, unsigned int currentTimeStamp);
+		void BeginDrag(Mouse& mouse);
+		void Update(Mouse& mouse, unsigned int currentTimeStamp);
+		void ForceRelease(Mouse& mouse);
 	} mButtons[3];
 
 	ButtonState& GetButton(g2d::MouseButton& button);
@@ -172,4 +179,5 @@ private:
 	cxx::int2 mCursorPosition;
 };
 
+// implemented by platforms, return false if it can not be polled.
 bool AltDownWin32();
\ No newline at end of file
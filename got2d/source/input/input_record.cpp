@@ -0,0 +1,111 @@
+#include "input_record.h"
+
+namespace
+{
+	constexpr uint32_t InputLogMagic = 0x49443247;	// "G2DI"
+	constexpr uint32_t InputLogVersion = 1;
+}
+
+InputRecorder::~InputRecorder()
+{
+	Close();
+}
+
+bool InputRecorder::Open(const char* filePath)
+{
+	Close();
+	mFile = std::fopen(filePath, "wb");
+	if (mFile == nullptr)
+		return false;
+
+	Write(InputLogMagic);
+	Write(InputLogVersion);
+	return true;
+}
+
+void InputRecorder::Close()
+{
+	if (mFile != nullptr)
+	{
+		std::fclose(mFile);
+		mFile = nullptr;
+	}
+}
+
+void InputRecorder::WriteMessage(const g2d::Message& message, unsigned int timeStamp)
+{
+	Write(InputRecordType::Message);
+	Write(static_cast<uint32_t>(timeStamp));
+	Write(static_cast<uint8_t>(message.Event));
+	Write(static_cast<uint8_t>(message.Source));
+	Write(static_cast<uint8_t>(message.MouseButton));
+	Write(static_cast<uint16_t>(message.Key));
+	Write(static_cast<int32_t>(message.CursorPositionX));
+	Write(static_cast<int32_t>(message.CursorPositionY));
+}
+
+void InputRecorder::WriteUpdate(unsigned int deltaTime)
+{
+	Write(InputRecordType::Update);
+	Write(static_cast<uint32_t>(deltaTime));
+}
+
+InputPlayer::~InputPlayer()
+{
+	Close();
+}
+
+bool InputPlayer::Open(const char* filePath)
+{
+	Close();
+	mFile = std::fopen(filePath, "rb");
+	if (mFile == nullptr)
+		return false;
+
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	if (!Read(magic) || !Read(version) || magic != InputLogMagic || version != InputLogVersion)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void InputPlayer::Close()
+{
+	if (mFile != nullptr)
+	{
+		std::fclose(mFile);
+		mFile = nullptr;
+	}
+}
+
+g2d::Message InputPlayer::ReadMessage(unsigned int& timeStamp, bool& success)
+{
+	uint32_t stamp = 0;
+	uint8_t event = 0;
+	uint8_t source = 0;
+	uint8_t button = 0;
+	uint16_t key = 0;
+	int32_t x = 0;
+	int32_t y = 0;
+	success = Read(stamp) && Read(event) && Read(source) &&
+		Read(button) && Read(key) && Read(x) && Read(y);
+
+	timeStamp = stamp;
+	auto ev = static_cast<g2d::MessageEvent>(event);
+	auto src = static_cast<g2d::MessageSource>(source);
+	if (src == g2d::MessageSource::Mouse)
+	{
+		return g2d::Message(ev, static_cast<g2d::MouseButton>(button), static_cast<unsigned int>(x), static_cast<unsigned int>(y));
+	}
+	else if (src == g2d::MessageSource::Keyboard)
+	{
+		return g2d::Message(ev, static_cast<g2d::KeyCode>(key));
+	}
+	else
+	{
+		return g2d::Message(ev, src);
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <cinttypes>
+#include <cstdio>
+#include "g2dmessage.h"
+
+// binary log of input, written by InputRecorder and read by InputPlayer.
+// a log starts with a header, followed by records of messages and
+// updates, messages between two updates belong to the latter frame.
+enum class InputRecordType : uint8_t
+{
+	Message = 0,
+	Update = 1,
+};
+
+class InputRecorder
+{
+public:
+	~InputRecorder();
+
+	bool Open(const char* filePath);
+
+	void Close();
+
+	bool IsOpen() const { return mFile != nullptr; }
+
+	void WriteMessage(const g2d::Message& message, unsigned int timeStamp);
+
+	void WriteUpdate(unsigned int deltaTime);
+
+private:
+	template<typename T> void Write(T value)
+	{
+		std::fwrite(&value, sizeof(T), 1, mFile);
+	}
+
+	std::FILE* mFile = nullptr;
+};
+
+class InputPlayer
+{
+public:
+	~InputPlayer();
+
+	bool Open(const char* filePath);
+
+	void Close();
+
+	bool IsOpen() const { return mFile != nullptr; }
+
+	// pass messages of next frame to the function,
+	// return false if the log ends before an update.
+	template<typename TFUNC> bool ReadFrame(unsigned int& deltaTime, TFUNC func)
+	{
+		InputRecordType type;
+		while (Read(type))
+		{
+			if (type == InputRecordType::Update)
+			{
+				return Read(deltaTime);
+			}
+			else if (type == InputRecordType::Message)
+			{
+				unsigned int timeStamp = 0;
+				bool success = false;
+				g2d::Message message = ReadMessage(timeStamp, success);
+				if (!success)
+					return false;
+
+				func(message, timeStamp);
+			}
+			else
+			{
+				// broken log.
+				return false;
+			}
+		}
+		return false;
+	}
+
+private:
+	g2d::Message ReadMessage(unsigned int& timeStamp, bool& success);
+
+	template<typename T> bool Read(T& value)
+	{
+		return std::fread(&value, sizeof(T), 1, mFile) == 1;
+	}
+
+	std::FILE* mFile = nullptr;
+};
@@ -0,0 +1,5 @@
+#include "g2dmessage.h"
+
+// no system keys can be polled without a window system,
+// keyboard state only comes from messages.
+bool AltDownWin32() { return false; }
@@ -0,0 +1,177 @@
+#include "job_system.h"
+
+namespace
+{
+	thread_local bool tlsIsInJob = false;
+}
+
+JobSystem::~JobSystem()
+{
+	Destroy();
+}
+
+bool JobSystem::Create(unsigned int workerCount)
+{
+	Destroy();
+
+	mIsExiting = false;
+	mPendingTaskCount = 0;
+	for (unsigned int i = 0; i <= workerCount; i++)
+	{
+		mQueues.push_back(new TaskQueue());
+	}
+
+	for (unsigned int i = 1; i <= workerCount; i++)
+	{
+		mWorkers.emplace_back([this, i] { WorkerMain(i); });
+	}
+	return true;
+}
+
+void JobSystem::Destroy()
+{
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		mIsExiting = true;
+	}
+	mWakeCondition.notify_all();
+
+	for (std::thread& worker : mWorkers)
+	{
+		worker.join();
+	}
+	mWorkers.clear();
+
+	for (TaskQueue* queue : mQueues)
+	{
+		delete queue;
+	}
+	mQueues.clear();
+}
+
+void JobSystem::ParallelFor(unsigned int count, unsigned int grainSize, const RangeFunction& func)
+{
+	if (count == 0)
+		return;
+
+	if (grainSize == 0)
+	{
+		grainSize = 1;
+	}
+
+	if (mWorkers.empty() || tlsIsInJob || count <= grainSize)
+	{
+		bool isInJob = tlsIsInJob;
+		tlsIsInJob = true;
+		func(0, count);
+		tlsIsInJob = isInJob;
+		return;
+	}
+
+	mFunction = &func;
+	unsigned int numTasks = (count + grainSize - 1) / grainSize;
+	unsigned int numQueues = static_cast<unsigned int>(mQueues.size());
+	mPendingTaskCount.store(numTasks, std::memory_order_relaxed);
+
+	// deal continuous ranges to each queue, neighbouring
+	// elements are likely to be processed by the same core.
+	for (unsigned int q = 0; q < numQueues; q++)
+	{
+		unsigned int taskBegin = static_cast<unsigned int>(static_cast<unsigned long long>(numTasks) * q / numQueues);
+		unsigned int taskEnd = static_cast<unsigned int>(static_cast<unsigned long long>(numTasks) * (q + 1) / numQueues);
+
+		std::lock_guard<std::mutex> lock(mQueues[q]->Mutex);
+		for (unsigned int t = taskBegin; t < taskEnd; t++)
+		{
+			unsigned int begin = t * grainSize;
+			unsigned int end = (count - begin > grainSize) ? begin + grainSize : count;
+			mQueues[q]->Tasks.push_back({ begin, end });
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		mJobGeneration++;
+	}
+	mWakeCondition.notify_all();
+
+	// all tasks are queued already, when no one is left to
+	// pop or steal, sleep until the running ones finished.
+	ExecuteTasks(0);
+	{
+		std::unique_lock<std::mutex> lock(mDoneMutex);
+		mDoneCondition.wait(lock, [this] { return mPendingTaskCount.load(std::memory_order_acquire) == 0; });
+	}
+	mFunction = nullptr;
+}
+
+bool JobSystem::IsInJob()
+{
+	return tlsIsInJob;
+}
+
+void JobSystem::WorkerMain(unsigned int queueIndex)
+{
+	unsigned int generation = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mWakeMutex);
+			mWakeCondition.wait(lock, [&] { return mIsExiting || mJobGeneration != generation; });
+			if (mIsExiting)
+				return;
+
+			generation = mJobGeneration;
+		}
+		ExecuteTasks(queueIndex);
+	}
+}
+
+bool JobSystem::ExecuteTasks(unsigned int queueIndex)
+{
+	bool executed = false;
+	Task task;
+	while (PopTask(queueIndex, task) || StealTask(queueIndex, task))
+	{
+		tlsIsInJob = true;
+		(*mFunction)(task.Begin, task.End);
+		tlsIsInJob = false;
+
+		if (mPendingTaskCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			std::lock_guard<std::mutex> lock(mDoneMutex);
+			mDoneCondition.notify_one();
+		}
+		executed = true;
+	}
+	return executed;
+}
+
+bool JobSystem::PopTask(unsigned int queueIndex, Task& task)
+{
+	TaskQueue* queue = mQueues[queueIndex];
+	std::lock_guard<std::mutex> lock(queue->Mutex);
+	if (queue->Tasks.empty())
+		return false;
+
+	task = queue->Tasks.back();
+	queue->Tasks.pop_back();
+	return true;
+}
+
+bool JobSystem::StealTask(unsigned int queueIndex, Task& task)
+{
+	unsigned int numQueues = static_cast<unsigned int>(mQueues.size());
+	for (unsigned int i = 1; i < numQueues; i++)
+	{
+		TaskQueue* victim = mQueues[(queueIndex + i) % numQueues];
+		std::lock_guard<std::mutex> lock(victim->Mutex);
+		if (!victim->Tasks.empty())
+		{
+			task = victim->Tasks.front();
+			victim->Tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
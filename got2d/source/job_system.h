@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+*	Work-stealing thread pool for fork-join jobs.
+*	ParallelFor splits a range into tasks and spreads them
+*	over the queues of all workers, every worker pops tasks
+*	from the back of its own queue and steals from the front
+*	of others' when it runs out. The calling thread takes
+*	part in the work, stealing like the workers, then sleeps
+*	until the last task finished.
+*
+*	ParallelFor can only be called from one thread at a time,
+*	nested calls inside a job are executed inline.
+*/
+class JobSystem
+{
+public:
+	using RangeFunction = std::function<void(unsigned int begin, unsigned int end)>;
+
+	~JobSystem();
+
+	// 0 worker means all jobs run inline in the calling thread.
+	bool Create(unsigned int workerCount);
+
+	void Destroy();
+
+	unsigned int GetWorkerCount() const { return static_cast<unsigned int>(mWorkers.size()); }
+
+	void ParallelFor(unsigned int count, unsigned int grainSize, const RangeFunction& func);
+
+	// true if the calling thread is executing a job body.
+	static bool IsInJob();
+
+private:
+	struct Task
+	{
+		unsigned int Begin;
+		unsigned int End;
+	};
+
+	struct TaskQueue
+	{
+		std::mutex Mutex;
+		std::deque<Task> Tasks;
+	};
+
+	void WorkerMain(unsigned int queueIndex);
+
+	// execute tasks until no one can be found,
+	// return false if nothing has been executed.
+	bool ExecuteTasks(unsigned int queueIndex);
+
+	bool PopTask(unsigned int queueIndex, Task& task);
+
+	bool StealTask(unsigned int queueIndex, Task& task);
+
+	// queue 0 belongs to the calling thread.
+	std::vector<TaskQueue*> mQueues;
+	std::vector<std::thread> mWorkers;
+
+	const RangeFunction* mFunction = nullptr;
+	std::atomic<unsigned int> mPendingTaskCount;
+
+	// the calling thread waits here for the last task.
+	std::mutex mDoneMutex;
+	std::condition_variable mDoneCondition;
+
+	std::mutex mWakeMutex;
+	std::condition_variable mWakeCondition;
+	unsigned int mJobGeneration = 0;
+	bool mIsExiting = false;
+};
@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <cstring>
+#include "compositor.h"
+
+Compositor::~Compositor()
+{
+	Clear();
+}
+
+bool Compositor::DeclareTarget(const char* name, float scale, const cxx::color4f& clearColor, bool persistent)
+{
+	if (name == nullptr || strlen(name) == 0 || FindTarget(name) != InvalidIndex || scale <= 0.0f)
+		return false;
+
+	mTargets.emplace_back();
+	Target& target = mTargets.back();
+	target.Name = name;
+	target.Scale = scale;
+	target.ClearColor = clearColor;
+	target.IsPersistent = persistent;
+	mIsDirty = true;
+	mVersion++;
+	return true;
+}
+
+bool Compositor::AddPass(const char* output, const char** inputs, unsigned int inputCount, g2d::Material* material)
+{
+	if (material == nullptr)
+		return false;
+
+	CompositePass pass;
+	pass.Output = FindTarget(output);
+	if (output != nullptr && pass.Output == InvalidIndex)
+		return false;
+
+	for (unsigned int i = 0; i < inputCount; i++)
+	{
+		unsigned int input = FindTarget(inputs[i]);
+		if (input == InvalidIndex || input == pass.Output)
+			return false;
+
+		// output of the pass is already consumed by the input.
+		if (pass.Output != InvalidIndex && IsReachable(pass.Output, input))
+			return false;
+
+		pass.Inputs.push_back(input);
+	}
+
+	material->AddRef();
+	pass.MaterialPtr = material;
+	mPasses.push_back(pass);
+	mIsDirty = true;
+	return true;
+}
+
+void Compositor::Clear()
+{
+	for (auto& pass : mPasses)
+	{
+		pass.MaterialPtr->Release();
+	}
+	mPasses.clear();
+	mTargets.clear();
+	mPassOrder.clear();
+	mPhysicalIndices.clear();
+	mIsDirty = true;
+	mVersion++;
+}
+
+unsigned int Compositor::FindTarget(const char* name) const
+{
+	if (name == nullptr)
+		return InvalidIndex;
+
+	for (unsigned int i = 0, n = GetTargetCount(); i < n; i++)
+	{
+		if (mTargets[i].Name == name)
+			return i;
+	}
+	return InvalidIndex;
+}
+
+void Compositor::MarkCameraTarget(unsigned int target)
+{
+	if (!mTargets[target].IsCameraTarget)
+	{
+		mTargets[target].IsCameraTarget = true;
+		mIsDirty = true;
+	}
+}
+
+void Compositor::Compile()
+{
+	if (!mIsDirty)
+		return;
+
+	mIsDirty = false;
+	SortPasses();
+	AssignPhysicalSlots();
+}
+
+void Compositor::SortPasses()
+{
+	// a pass runs after all passes writing its inputs, passes
+	// without dependency between them keep the adding order.
+	auto numPasses = static_cast<unsigned int>(mPasses.size());
+	std::vector<unsigned int> dependencyCount(numPasses, 0);
+	for (unsigned int reader = 0; reader < numPasses; reader++)
+	{
+		for (unsigned int writer = 0; writer < numPasses; writer++)
+		{
+			auto& inputs = mPasses[reader].Inputs;
+			if (writer != reader && mPasses[writer].Output != InvalidIndex &&
+				std::find(inputs.begin(), inputs.end(), mPasses[writer].Output) != inputs.end())
+			{
+				dependencyCount[reader]++;
+			}
+		}
+	}
+
+	mPassOrder.clear();
+	std::vector<bool> isSorted(numPasses, false);
+	while (mPassOrder.size() < numPasses)
+	{
+		unsigned int next = 0;
+		while (isSorted[next] || dependencyCount[next] > 0)
+		{
+			next++;
+		}
+		isSorted[next] = true;
+		mPassOrder.push_back(next);
+
+		if (mPasses[next].Output == InvalidIndex)
+			continue;
+
+		for (unsigned int reader = 0; reader < numPasses; reader++)
+		{
+			auto& inputs = mPasses[reader].Inputs;
+			if (reader != next && std::find(inputs.begin(), inputs.end(), mPasses[next].Output) != inputs.end())
+			{
+				dependencyCount[reader]--;
+			}
+		}
+	}
+}
+
+void Compositor::AssignPhysicalSlots()
+{
+	// lifetime in steps, cameras render at step 0,
+	// the pass at order i runs at step i + 1.
+	auto numTargets = GetTargetCount();
+	std::vector<unsigned int> firstStep(numTargets, InvalidIndex);
+	std::vector<unsigned int> lastStep(numTargets, 0);
+	for (unsigned int t = 0; t < numTargets; t++)
+	{
+		if (mTargets[t].IsCameraTarget)
+		{
+			firstStep[t] = 0;
+		}
+	}
+
+	for (unsigned int i = 0, n = static_cast<unsigned int>(mPassOrder.size()); i < n; i++)
+	{
+		auto& pass = mPasses[mPassOrder[i]];
+		unsigned int step = i + 1;
+		if (pass.Output != InvalidIndex)
+		{
+			firstStep[pass.Output] = std::min(firstStep[pass.Output], step);
+			lastStep[pass.Output] = std::max(lastStep[pass.Output], step);
+		}
+		for (unsigned int input : pass.Inputs)
+		{
+			lastStep[input] = std::max(lastStep[input], step);
+		}
+	}
+
+	std::vector<unsigned int> sortedTargets(numTargets);
+	for (unsigned int t = 0; t < numTargets; t++)
+	{
+		// targets never written are read as cleared ones.
+		if (firstStep[t] == InvalidIndex)
+		{
+			firstStep[t] = 0;
+		}
+		lastStep[t] = std::max(lastStep[t], firstStep[t]);
+		sortedTargets[t] = t;
+	}
+	std::stable_sort(sortedTargets.begin(), sortedTargets.end(), [&](unsigned int a, unsigned int b)
+	{
+		return firstStep[a] < firstStep[b];
+	});
+
+	// greedy interval allocation, only targets of the same scale share slots.
+	struct Slot
+	{
+		float Scale;
+		unsigned int LastStep;
+	};
+	std::vector<Slot> slots;
+	mPhysicalIndices.assign(numTargets, InvalidIndex);
+
+	// persistent targets own their slots, in the order of declaration,
+	// so the slots do not move when passes are added.
+	for (unsigned int t = 0; t < numTargets; t++)
+	{
+		if (mTargets[t].IsPersistent)
+		{
+			mPhysicalIndices[t] = static_cast<unsigned int>(slots.size());
+			slots.push_back({ mTargets[t].Scale, InvalidIndex });
+		}
+	}
+
+	for (unsigned int t : sortedTargets)
+	{
+		if (mTargets[t].IsPersistent)
+			continue;
+
+		for (unsigned int s = 0, n = static_cast<unsigned int>(slots.size()); s < n; s++)
+		{
+			if (slots[s].Scale == mTargets[t].Scale && slots[s].LastStep < firstStep[t])
+			{
+				mPhysicalIndices[t] = s;
+				slots[s].LastStep = lastStep[t];
+				break;
+			}
+		}
+
+		if (mPhysicalIndices[t] == InvalidIndex)
+		{
+			mPhysicalIndices[t] = static_cast<unsigned int>(slots.size());
+			slots.push_back({ mTargets[t].Scale, lastStep[t] });
+		}
+	}
+}
+
+bool Compositor::IsReachable(unsigned int from, unsigned int to) const
+{
+	if (from == to)
+		return true;
+
+	for (auto& pass : mPasses)
+	{
+		if (pass.Output != InvalidIndex &&
+			std::find(pass.Inputs.begin(), pass.Inputs.end(), from) != pass.Inputs.end() &&
+			IsReachable(pass.Output, to))
+		{
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "g2drender.h"
+
+/**
+*	Graph of off-screen targets and compositing passes.
+*	Targets are written by cameras during Scene::Render and
+*	by passes at EndRender, passes run in dependency order.
+*	Logical targets are mapped to physical slots, targets
+*	whose lifetimes do not overlap share one slot, so video
+*	memory is reused between passes.
+*
+*	It is compiled on the recording thread, physical slots
+*	are created by the thread executing frame packets.
+*/
+class Compositor
+{
+public:
+	constexpr static unsigned int InvalidIndex = 0xFFFFFFFF;
+
+	struct Target
+	{
+		std::string Name;
+		float Scale = 1.0f;
+		cxx::color4f ClearColor;
+		bool IsPersistent = false;
+		bool IsCameraTarget = false;
+	};
+
+	struct CompositePass
+	{
+		unsigned int Output = InvalidIndex;	//back buffer if invalid.
+		std::vector<unsigned int> Inputs;
+		g2d::Material* MaterialPtr = nullptr;
+	};
+
+	~Compositor();
+
+	bool DeclareTarget(const char* name, float scale, const cxx::color4f& clearColor, bool persistent);
+
+	// return false if a target is not declared, or a cycle is made.
+	bool AddPass(const char* output, const char** inputs, unsigned int inputCount, g2d::Material* material);
+
+	void Clear();
+
+	// InvalidIndex for nullptr and names not declared.
+	unsigned int FindTarget(const char* name) const;
+
+	// targets rendered by cameras are alive from the beginning of frames.
+	void MarkCameraTarget(unsigned int target);
+
+	unsigned int GetTargetCount() const { return static_cast<unsigned int>(mTargets.size()); }
+
+	const Target& GetTarget(unsigned int index) const { return mTargets[index]; }
+
+	unsigned int GetPassCount() const { return static_cast<unsigned int>(mPasses.size()); }
+
+	const CompositePass& GetPass(unsigned int index) const { return mPasses[index]; }
+
+	// indices of passes in executing order.
+	const std::vector<unsigned int>& GetPassOrder() { Compile(); return mPassOrder; }
+
+	unsigned int GetPhysicalIndex(unsigned int target) { Compile(); return mPhysicalIndices[target]; }
+
+	// changed when targets are declared or cleared,
+	// contents of persistent targets are lost then.
+	unsigned int GetVersion() const { return mVersion; }
+
+private:
+	void Compile();
+
+	void SortPasses();
+
+	void AssignPhysicalSlots();
+
+	// true if data flows from the target to the other one through passes.
+	bool IsReachable(unsigned int from, unsigned int to) const;
+
+	bool mIsDirty = true;
+	unsigned int mVersion = 0;
+	std::vector<Target> mTargets;
+	std::vector<CompositePass> mPasses;
+	std::vector<unsigned int> mPassOrder;
+	std::vector<unsigned int> mPhysicalIndices;
+};
@@ -0,0 +1,69 @@
+#include <cstring>
+#include "constant_ring.h"
+#include "../scope_utility.h"
+
+namespace
+{
+	constexpr unsigned int MinRingLength = 64 * 1024;
+}
+
+ConstantRing::~ConstantRing()
+{
+	Destroy();
+}
+
+void ConstantRing::Destroy()
+{
+	ENSURE(mMappedData == nullptr);
+	if (mBuffer != nullptr)
+	{
+		mBuffer->Release();
+		mBuffer = nullptr;
+	}
+}
+
+bool ConstantRing::Begin(rhi::Device* device, rhi::Context* context, unsigned int length)
+{
+	ENSURE(mMappedData == nullptr);
+	if (mBuffer == nullptr || mBuffer->GetLength() < length)
+	{
+		unsigned int newLength = (mBuffer == nullptr) ? MinRingLength : mBuffer->GetLength();
+		while (newLength < length)
+		{
+			newLength *= 2;
+		}
+
+		Destroy();
+		mBuffer = device->CreateBuffer(rhi::BufferBinding::Constant, rhi::ResourceUsage::Dynamic, newLength);
+		if (mBuffer == nullptr)
+			return false;
+	}
+
+	auto mappedData = context->Map(mBuffer);
+	if (!mappedData.success)
+		return false;
+
+	mMappedData = reinterpret_cast<uint8_t*>(mappedData.data);
+	return true;
+}
+
+void ConstantRing::Write(unsigned int offset, const void* data, unsigned int dataLength, unsigned int rangeLength)
+{
+	ENSURE(mMappedData != nullptr && dataLength <= rangeLength);
+	ENSURE(offset + rangeLength <= mBuffer->GetLength());
+
+	memcpy(mMappedData + offset, data, dataLength);
+	memset(mMappedData + offset + dataLength, 0, rangeLength - dataLength);
+}
+
+void ConstantRing::End(rhi::Context* context)
+{
+	ENSURE(mMappedData != nullptr);
+	context->Unmap(mBuffer);
+	mMappedData = nullptr;
+}
+
+unsigned int ConstantRing::Align(unsigned int length)
+{
+	return (length + rhi::ConstantBufferAlignment - 1) / rhi::ConstantBufferAlignment * rhi::ConstantBufferAlignment;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include "../RHI/RHI.h"
+
+/**
+*	One dynamic constant buffer suballocated by all passes
+*	of a frame packet. It is mapped with discard once when
+*	the packet starts executing, so the driver renames it
+*	while former frames are still in flight, and drawcalls
+*	bind their constants by offset instead of mapping a
+*	buffer for each pass.
+*/
+class ConstantRing
+{
+public:
+	~ConstantRing();
+
+	void Destroy();
+
+	// buffer grows if it is shorter than length.
+	bool Begin(rhi::Device* device, rhi::Context* context, unsigned int length);
+
+	// range is zero-filled after the data.
+	void Write(unsigned int offset, const void* data, unsigned int dataLength, unsigned int rangeLength);
+
+	void End(rhi::Context* context);
+
+	rhi::Buffer* GetBuffer() const { return mBuffer; }
+
+	static unsigned int Align(unsigned int length);
+
+private:
+	rhi::Buffer* mBuffer = nullptr;
+	uint8_t* mMappedData = nullptr;
+};
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cmath>
+#include "fill_counter.h"
+
+void FillCounter::Reset(unsigned int width, unsigned int height)
+{
+	mWidth = width;
+	mHeight = height;
+	mCellCountX = (width + CellSize - 1) / CellSize;
+	mCellCountY = (height + CellSize - 1) / CellSize;
+	mCellDepths.assign(mCellCountX * mCellCountY, 1.0f);
+	SetClipRect(nullptr);
+
+	mStatistics = g2d::FillStatistics();
+	mStatistics.ScreenPixels = static_cast<unsigned long long>(width) * height;
+}
+
+void FillCounter::SetClipRect(const rhi::Rect* rect)
+{
+	mClipRect.Left = 0;
+	mClipRect.Top = 0;
+	mClipRect.Right = static_cast<int>(mWidth);
+	mClipRect.Bottom = static_cast<int>(mHeight);
+	if (rect != nullptr)
+	{
+		mClipRect.Left = std::max(mClipRect.Left, rect->Left);
+		mClipRect.Top = std::max(mClipRect.Top, rect->Top);
+		mClipRect.Right = std::min(mClipRect.Right, rect->Right);
+		mClipRect.Bottom = std::min(mClipRect.Bottom, rect->Bottom);
+	}
+}
+
+void FillCounter::Draw(const std::vector<g2d::GeometryVertex>& vertices, const std::vector<unsigned int>& indices,
+	const FramePacket::DrawCall& drawCall, const cxx::float2x3& viewMatrix,
+	float depth, bool depthTest, bool depthWrite)
+{
+	mStatistics.DrawCount++;
+	if (drawCall.IsOpaque)
+	{
+		mStatistics.OpaqueDrawCount++;
+	}
+
+	if (drawCall.StartIndex + drawCall.IndexCount > indices.size())
+		return;
+
+	float halfWidth = mWidth * 0.5f;
+	float halfHeight = mHeight * 0.5f;
+	for (unsigned int i = 0; i + 2 < drawCall.IndexCount; i += 3)
+	{
+		cxx::float2 screen[3];
+		bool isValid = true;
+		for (unsigned int v = 0; v < 3; v++)
+		{
+			unsigned int vertexIndex = indices[drawCall.StartIndex + i + v] + drawCall.BaseVertex;
+			if (vertexIndex >= vertices.size())
+			{
+				isValid = false;
+				break;
+			}
+
+			// view space has its origin at the center with y up.
+			auto view = transform(viewMatrix, cxx::point2d<float>(vertices[vertexIndex].Position));
+			screen[v] = cxx::float2(view.x + halfWidth, halfHeight - view.y);
+		}
+
+		if (isValid)
+		{
+			RasterizeTriangle(screen, drawCall.PassCount, depth, depthTest, depthWrite);
+		}
+	}
+}
+
+void FillCounter::RasterizeTriangle(const cxx::float2* screen, unsigned int passCount, float depth, bool depthTest, bool depthWrite)
+{
+	auto edge = [](const cxx::float2& a, const cxx::float2& b, float x, float y)
+	{
+		return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+	};
+
+	float area = edge(screen[0], screen[1], screen[2].x, screen[2].y);
+	if (area == 0.0f)
+		return;
+
+	float minX = std::min({ screen[0].x, screen[1].x, screen[2].x });
+	float maxX = std::max({ screen[0].x, screen[1].x, screen[2].x });
+	float minY = std::min({ screen[0].y, screen[1].y, screen[2].y });
+	float maxY = std::max({ screen[0].y, screen[1].y, screen[2].y });
+
+	int cellLeft = std::max(static_cast<int>(std::floor(std::max(minX, static_cast<float>(mClipRect.Left)) / CellSize)), 0);
+	int cellTop = std::max(static_cast<int>(std::floor(std::max(minY, static_cast<float>(mClipRect.Top)) / CellSize)), 0);
+	int cellRight = std::min(static_cast<int>(std::ceil(std::min(maxX, static_cast<float>(mClipRect.Right)) / CellSize)), static_cast<int>(mCellCountX));
+	int cellBottom = std::min(static_cast<int>(std::ceil(std::min(maxY, static_cast<float>(mClipRect.Bottom)) / CellSize)), static_cast<int>(mCellCountY));
+
+	for (int cy = cellTop; cy < cellBottom; cy++)
+	{
+		float y = (cy + 0.5f) * CellSize;
+		if (y < mClipRect.Top || y >= mClipRect.Bottom)
+			continue;
+
+		for (int cx = cellLeft; cx < cellRight; cx++)
+		{
+			float x = (cx + 0.5f) * CellSize;
+			if (x < mClipRect.Left || x >= mClipRect.Right)
+				continue;
+
+			// inside if all edges have the same side as the triangle.
+			float w0 = edge(screen[1], screen[2], x, y) * area;
+			float w1 = edge(screen[2], screen[0], x, y) * area;
+			float w2 = edge(screen[0], screen[1], x, y) * area;
+			if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+				continue;
+
+			// cells on the right and bottom borders are partial.
+			unsigned int cellWidth = std::min(CellSize, mWidth - cx * CellSize);
+			unsigned int cellHeight = std::min(CellSize, mHeight - cy * CellSize);
+			unsigned long long pixels = static_cast<unsigned long long>(cellWidth) * cellHeight * passCount;
+
+			float& cellDepth = mCellDepths[cy * mCellCountX + cx];
+			if (depthTest && depth > cellDepth)
+			{
+				mStatistics.RejectedPixels += pixels;
+				continue;
+			}
+
+			mStatistics.ShadedPixels += pixels;
+			if (depthWrite)
+			{
+				cellDepth = depth;
+			}
+		}
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include "g2drender.h"
+#include "frame_packet.h"
+
+/**
+*	Estimates pixels shaded in the back buffer by rasterizing
+*	drawcalls in cells of CellSize pixels on CPU. A cell is
+*	covered if its center is inside a triangle, and it keeps
+*	the nearest depth written by opaque drawcalls to count
+*	the pixels rejected by the depth test. Drawcalls should
+*	be fed in the order they are executed by the GPU.
+*/
+class FillCounter
+{
+public:
+	// all cells are cleared to the farthest depth.
+	void Reset(unsigned int width, unsigned int height);
+
+	// nullptr to count the whole buffer.
+	void SetClipRect(const rhi::Rect* rect);
+
+	void Draw(const std::vector<g2d::GeometryVertex>& vertices, const std::vector<unsigned int>& indices,
+		const FramePacket::DrawCall& drawCall, const cxx::float2x3& viewMatrix,
+		float depth, bool depthTest, bool depthWrite);
+
+	const g2d::FillStatistics& GetStatistics() const { return mStatistics; }
+
+private:
+	constexpr static unsigned int CellSize = 4;
+
+	void RasterizeTriangle(const cxx::float2* screen, unsigned int passCount, float depth, bool depthTest, bool depthWrite);
+
+	unsigned int mWidth = 0;
+	unsigned int mHeight = 0;
+	unsigned int mCellCountX = 0;
+	unsigned int mCellCountY = 0;
+	std::vector<float> mCellDepths;
+	rhi::Rect mClipRect;
+	g2d::FillStatistics mStatistics;
+};
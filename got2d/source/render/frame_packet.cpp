@@ -0,0 +1,259 @@
+#include <algorithm>
+#include "frame_packet.h"
+#include "sprite_table.h"
+#include "texture.h"
+
+void ApplyDrawParameters(g2d::GeometryVertex& vertex, const g2d::DrawParameters& params)
+{
+	for (int c = 0; c < 4; c++)
+	{
+		vertex.VertexColor.value.v[c] *= params.Tint.value.v[c];
+	}
+	vertex.Texcoord.x = vertex.Texcoord.x * params.TexcoordScale.x + params.TexcoordOffset.x;
+	vertex.Texcoord.y = vertex.Texcoord.y * params.TexcoordScale.y + params.TexcoordOffset.y;
+}
+
+Geometry& RetainedGeometry::GetGeometry()
+{
+	if (!mIsUploaded && !Indices.empty())
+	{
+		mIsUploaded = true;
+		auto numVertices = static_cast<unsigned int>(Vertices.size());
+		auto numIndices = static_cast<unsigned int>(Indices.size());
+		mGeometry.SetVertexFormat(SelectVertexFormat(mVertexFormat, &(Vertices[0]), numVertices));
+		if (mGeometry.MakeEnoughVertexArray(numVertices) &&
+			mGeometry.MakeEnoughIndexArray(numIndices))
+		{
+			mGeometry.UploadVertices(0, &(Vertices[0]), numVertices);
+			mGeometry.UploadIndices(0, &(Indices[0]), numIndices);
+		}
+	}
+	return mGeometry;
+}
+
+void FramePacket::Reset(VertexFormat format)
+{
+	mVertexFormat = format;
+	mCommands.clear();
+	mDrawCalls.clear();
+	mTargetSlots.clear();
+	mPassCount = 0;
+	mVertices.clear();
+	mIndices.clear();
+	mPendingBaseVertex = 0;
+	mPendingStartIndex = 0;
+}
+
+void FramePacket::Clear(const cxx::color4f& color)
+{
+	PushCommand(CommandType::Clear);
+	mCommands.back().Color = color;
+}
+
+void FramePacket::SetViewMatrix(const cxx::float2x3& viewMatrix)
+{
+	PushCommand(CommandType::SetViewMatrix);
+	mCommands.back().Matrix = viewMatrix;
+}
+
+bool FramePacket::Merge(const g2d::Mesh& mesh, const cxx::float2x3& t, const g2d::DrawParameters& params)
+{
+	auto numVertex = static_cast<unsigned int>(mVertices.size());
+	auto pendingVertex = numVertex - mPendingBaseVertex;
+	if (pendingVertex + mesh.GetVertexCount() > ::Mesh::MaxBatchVertexCount)
+	{
+		return false;
+	}
+
+	auto vertices = mesh.GetRawVertices();
+	for (unsigned int i = 0, n = mesh.GetVertexCount(); i < n; i++)
+	{
+		mVertices.push_back(vertices[i]);
+		auto& p = mVertices.back().Position;
+		p = transform(t, cxx::point2d<float>(p));
+		ApplyDrawParameters(mVertices.back(), params);
+	}
+
+	auto indices = mesh.GetRawIndices();
+	for (unsigned int i = 0, n = mesh.GetIndexCount(); i < n; i++)
+	{
+		mIndices.push_back(indices[i] + pendingVertex);
+	}
+	return true;
+}
+
+bool FramePacket::MergeSprite(const SpriteTable& table, unsigned int sprite, const cxx::float2x3& transform)
+{
+	auto numVertex = static_cast<unsigned int>(mVertices.size());
+	auto pendingVertex = numVertex - mPendingBaseVertex;
+	if (pendingVertex + 4 > ::Mesh::MaxBatchVertexCount)
+	{
+		return false;
+	}
+
+	mVertices.resize(numVertex + 4);
+	table.Expand(sprite, transform, &(mVertices[numVertex]));
+
+	// same as indices of the unit quad mesh.
+	static const unsigned int sQuadIndices[] = { 0, 2, 1, 0, 3, 2 };
+	for (unsigned int index : sQuadIndices)
+	{
+		mIndices.push_back(index + pendingVertex);
+	}
+	return true;
+}
+
+void FramePacket::FlushDraw(g2d::Material& material, const std::vector<unsigned int>* targetInputs)
+{
+	auto numIndices = static_cast<unsigned int>(mIndices.size());
+	if (numIndices > mPendingStartIndex)
+	{
+		DrawCall drawCall;
+		drawCall.FirstPass = SnapshotMaterial(material, targetInputs);
+		drawCall.PassCount = material.GetPassCount();
+		drawCall.BaseVertex = mPendingBaseVertex;
+		drawCall.StartIndex = mPendingStartIndex;
+		drawCall.IndexCount = numIndices - mPendingStartIndex;
+		drawCall.IsOpaque = IsOpaque(drawCall);
+		mDrawCalls.push_back(drawCall);
+
+		PushCommand(CommandType::Draw);
+		mCommands.back().DrawIndex = static_cast<unsigned int>(mDrawCalls.size() - 1);
+	}
+	mPendingBaseVertex = static_cast<unsigned int>(mVertices.size());
+	mPendingStartIndex = numIndices;
+}
+
+void FramePacket::DrawRetained(const std::shared_ptr<RetainedGeometry>& geometry, g2d::Material& material,
+	unsigned int startIndex, unsigned int indexCount, unsigned int baseVertex, const cxx::float2x3& worldMatrix)
+{
+	DrawCall drawCall;
+	drawCall.FirstPass = SnapshotMaterial(material, nullptr);
+	drawCall.PassCount = material.GetPassCount();
+	drawCall.BaseVertex = baseVertex;
+	drawCall.StartIndex = startIndex;
+	drawCall.IndexCount = indexCount;
+	drawCall.Retained = geometry;
+	drawCall.WorldMatrix = worldMatrix;
+	drawCall.IsOpaque = IsOpaque(drawCall);
+	mDrawCalls.push_back(drawCall);
+
+	PushCommand(CommandType::Draw);
+	mCommands.back().DrawIndex = static_cast<unsigned int>(mDrawCalls.size() - 1);
+}
+
+void FramePacket::SetRenderTarget(unsigned int target, bool clear, const cxx::color4f& color)
+{
+	PushCommand(CommandType::SetRenderTarget);
+	mCommands.back().TargetIndex = target;
+	mCommands.back().ClearTarget = clear;
+	mCommands.back().Color = color;
+}
+
+void FramePacket::SetScissorRect(const rhi::Rect* rect)
+{
+	PushCommand(CommandType::SetScissor);
+	mCommands.back().EnableScissor = (rect != nullptr);
+	if (rect != nullptr)
+	{
+		mCommands.back().ScissorRect = *rect;
+	}
+}
+
+void FramePacket::Present()
+{
+	PushCommand(CommandType::Present);
+}
+
+unsigned int FramePacket::SnapshotMaterial(g2d::Material& material, const std::vector<unsigned int>* targetInputs)
+{
+	unsigned int firstPass = mPassCount;
+	mPassCount += material.GetPassCount();
+	if (mPasses.size() < mPassCount)
+	{
+		mPasses.resize(mPassCount);
+	}
+
+	for (unsigned int i = 0; i < material.GetPassCount(); i++)
+	{
+		g2d::Pass* pass = material.GetPassByIndex(i);
+		PassSnapshot& snapshot = mPasses[firstPass + i];
+		snapshot.VsName = pass->GetVertexShaderName();
+		snapshot.PsName = pass->GetPixelShaderName();
+		snapshot.BlendMode = pass->GetBlendMode();
+
+		snapshot.Textures.resize(pass->GetTextureCount());
+		snapshot.Samplers.resize(pass->GetTextureCount());
+		for (unsigned int t = 0; t < pass->GetTextureCount(); t++)
+		{
+			snapshot.Samplers[t] = pass->GetSampler(t);
+			auto timpl = reinterpret_cast<::Texture*>(pass->GetTextureByIndex(t));
+			if (timpl != nullptr)
+			{
+				snapshot.Textures[t] = timpl->GetResourceName();
+			}
+			else
+			{
+				snapshot.Textures[t].clear();
+			}
+		}
+
+		snapshot.TargetInputs.assign(snapshot.Textures.size(), InvalidTarget);
+		if (targetInputs != nullptr)
+		{
+			if (targetInputs->size() > snapshot.Textures.size())
+			{
+				snapshot.Textures.resize(targetInputs->size());
+				snapshot.Samplers.resize(targetInputs->size());
+				snapshot.TargetInputs.resize(targetInputs->size(), InvalidTarget);
+			}
+			std::copy(targetInputs->begin(), targetInputs->end(), snapshot.TargetInputs.begin());
+		}
+
+		// the slot may keep the same constants since the last frame.
+		if (snapshot.ConstantVersion == pass->GetConstantVersion() &&
+			snapshot.VsConstants.size() * sizeof(cxx::float4) == pass->GetVSConstantLength() &&
+			snapshot.PsConstants.size() * sizeof(cxx::float4) == pass->GetPSConstantLength())
+		{
+			continue;
+		}
+		snapshot.ConstantVersion = pass->GetConstantVersion();
+
+		snapshot.VsConstants.resize(pass->GetVSConstantLength() / sizeof(cxx::float4));
+		if (!snapshot.VsConstants.empty())
+		{
+			memcpy(&(snapshot.VsConstants[0]), pass->GetVSConstant(), pass->GetVSConstantLength());
+		}
+
+		snapshot.PsConstants.resize(pass->GetPSConstantLength() / sizeof(cxx::float4));
+		if (!snapshot.PsConstants.empty())
+		{
+			memcpy(&(snapshot.PsConstants[0]), pass->GetPSConstant(), pass->GetPSConstantLength());
+		}
+	}
+	return firstPass;
+}
+
+bool FramePacket::IsOpaque(const DrawCall& drawCall) const
+{
+	if (drawCall.PassCount == 0)
+		return false;
+
+	// shaders have no alpha test, passes without blending cover every pixel.
+	for (unsigned int i = 0; i < drawCall.PassCount; i++)
+	{
+		if (mPasses[drawCall.FirstPass + i].BlendMode != g2d::BlendMode::None)
+			return false;
+	}
+	return true;
+}
+
+void FramePacket::PushCommand(CommandType type)
+{
+	mCommands.emplace_back();
+	mCommands.back().Type = type;
+	mCommands.back().DrawIndex = 0;
+	mCommands.back().TargetIndex = InvalidTarget;
+	mCommands.back().ClearTarget = false;
+	mCommands.back().EnableScissor = false;
+}
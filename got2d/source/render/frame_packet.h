@@ -0,0 +1,176 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "g2drender.h"
+#include "mesh.h"
+
+class SpriteTable;
+
+/**
+*	Merged geometry with its own video memory, shared
+*	by a static batch and the frame packets referring it.
+*	Content is immutable after building, it is uploaded
+*	lazily by the thread executing frame packets.
+*/
+class RetainedGeometry
+{
+public:
+	RetainedGeometry(VertexFormat format) : mVertexFormat(format) { }
+
+	~RetainedGeometry() { mGeometry.Destroy(); }
+
+	Geometry& GetGeometry();
+
+	std::vector<g2d::GeometryVertex> Vertices;
+	std::vector<unsigned int> Indices;
+
+private:
+	const VertexFormat mVertexFormat;
+	bool mIsUploaded = false;
+	Geometry mGeometry;
+};
+
+// tint and texcoord transform of a merged vertex.
+void ApplyDrawParameters(g2d::GeometryVertex& vertex, const g2d::DrawParameters& params);
+
+/**
+*	Immutable (after submitting) record of one frame.
+*	RenderSystem fills it in calling thread, and executes
+*	it in the render thread, or immediately at EndRender
+*	if the render thread is disabled. Nothing in a packet
+*	refers to the scene, meshes or materials.
+*/
+class FramePacket
+{
+public:
+	struct PassSnapshot
+	{
+		std::string VsName;
+		std::string PsName;
+		g2d::BlendMode BlendMode = g2d::BlendMode::None;
+		std::vector<std::string> Textures;	//empty name for default texture.
+		std::vector<g2d::SamplerDesc> Samplers;	//one for each texture.
+		std::vector<unsigned int> TargetInputs;	//render target replacing the texture, or InvalidTarget.
+		std::vector<cxx::float4> VsConstants;
+		std::vector<cxx::float4> PsConstants;
+		unsigned int ConstantVersion = 0;
+	};
+
+	struct DrawCall
+	{
+		unsigned int FirstPass = 0;
+		unsigned int PassCount = 0;
+		unsigned int BaseVertex = 0;
+		unsigned int StartIndex = 0;
+		unsigned int IndexCount = 0;
+		bool IsOpaque = false;	//all passes are drawn without blending.
+		std::shared_ptr<RetainedGeometry> Retained;	//null for geometry of the packet.
+		cxx::float2x3 WorldMatrix = cxx::float2x3::identity();	//geometry of the packet is in world space.
+	};
+
+	// the back buffer, or no target.
+	constexpr static unsigned int InvalidTarget = 0xFFFFFFFF;
+
+	// physical target of a compositor target in this frame.
+	struct TargetSlot
+	{
+		unsigned int PhysicalIndex = 0;
+		float Scale = 1.0f;
+	};
+
+	enum class CommandType : int
+	{
+		Clear,
+		SetViewMatrix,
+		Draw,
+		SetRenderTarget,
+		SetScissor,
+		Present,
+	};
+
+	struct Command
+	{
+		CommandType Type;
+		cxx::color4f Color;
+		cxx::float2x3 Matrix;
+		unsigned int DrawIndex;
+		unsigned int TargetIndex;
+		bool ClearTarget;
+		rhi::Rect ScissorRect;
+		bool EnableScissor;
+	};
+
+	void Reset(VertexFormat format);
+
+	void Clear(const cxx::color4f& color);
+
+	void SetViewMatrix(const cxx::float2x3& viewMatrix);
+
+	// return false if the pending draw call is full,
+	// call FlushDraw and try again.
+	bool Merge(const g2d::Mesh& mesh, const cxx::float2x3& transform, const g2d::DrawParameters& params);
+
+	// same as Merge, without going through a mesh.
+	bool MergeSprite(const SpriteTable& table, unsigned int sprite, const cxx::float2x3& transform);
+
+	// close the pending draw call with the material, textures
+	// of slots can be replaced by targets for compositing.
+	void FlushDraw(g2d::Material& material, const std::vector<unsigned int>* targetInputs = nullptr);
+
+	// target is the index of compositor targets, it is cleared by the color if required.
+	void SetRenderTarget(unsigned int target, bool clear, const cxx::color4f& color);
+
+	// clip drawing into the back buffer, nullptr to disable.
+	void SetScissorRect(const rhi::Rect* rect);
+
+	// called after all targets are set, slots are indexed by compositor targets.
+	void SetTargetSlots(const std::vector<TargetSlot>& slots) { mTargetSlots = slots; }
+
+	// nullptr if the target was removed while recording.
+	const TargetSlot* GetTargetSlot(unsigned int target) const { return (target < mTargetSlots.size()) ? &(mTargetSlots[target]) : nullptr; }
+
+	// the geometry is transformed by the matrix when drawing.
+	void DrawRetained(const std::shared_ptr<RetainedGeometry>& geometry, g2d::Material& material,
+		unsigned int startIndex, unsigned int indexCount, unsigned int baseVertex, const cxx::float2x3& worldMatrix);
+
+	void Present();
+
+	VertexFormat GetVertexFormat() const { return mVertexFormat; }
+
+	const std::vector<Command>& GetCommands() const { return mCommands; }
+
+	const DrawCall& GetDrawCall(unsigned int index) const { return mDrawCalls[index]; }
+
+	unsigned int GetDrawCallCount() const { return static_cast<unsigned int>(mDrawCalls.size()); }
+
+	const PassSnapshot& GetPass(unsigned int index) const { return mPasses[index]; }
+
+	unsigned int GetPassCount() const { return mPassCount; }
+
+	const std::vector<g2d::GeometryVertex>& GetVertices() const { return mVertices; }
+
+	const std::vector<unsigned int>& GetIndices() const { return mIndices; }
+
+private:
+	unsigned int SnapshotMaterial(g2d::Material& material, const std::vector<unsigned int>* targetInputs);
+
+	bool IsOpaque(const DrawCall& drawCall) const;
+
+	void PushCommand(CommandType type);
+
+	VertexFormat mVertexFormat = VertexFormat::Standard;
+	std::vector<Command> mCommands;
+	std::vector<DrawCall> mDrawCalls;
+	std::vector<TargetSlot> mTargetSlots;
+
+	// snapshots are reused between frames to keep the
+	// capacity of strings and vectors, count is the used part.
+	std::vector<PassSnapshot> mPasses;
+	unsigned int mPassCount = 0;
+
+	std::vector<g2d::GeometryVertex> mVertices;
+	std::vector<unsigned int> mIndices;
+	unsigned int mPendingBaseVertex = 0;
+	unsigned int mPendingStartIndex = 0;
+};
@@ -46,7 +46,15 @@ g2d::Material* Material::Clone() const
 
 void Material::Release()
 {
-	delete this;
+	if (--mRefCount == 0)
+	{
+		delete this;
+	}
+}
+
+void Material::AddRef()
+{
+	mRefCount++;
 }
 
 //===================================================================
@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include <vector>
 #include "g2drender.h"
 
@@ -19,6 +20,8 @@ public:
 
 	virtual void Release()  override;
 
+	virtual void AddRef() override;
+
 public:
 	Material(unsigned int passCount);
 
@@ -30,4 +33,7 @@ public:
 
 private:
 	std::vector<::Pass*> mPasses;
+
+	// shared materials may be referenced by components created in jobs.
+	std::atomic<int> mRefCount{ 1 };
 };
\ No newline at end of file
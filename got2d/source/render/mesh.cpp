@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "render_system.h"
 
 g2d::Mesh* g2d::Mesh::Create(unsigned int vertexCount, unsigned int indexCount)
@@ -11,9 +12,8 @@ Mesh::Mesh(unsigned int vertexCount, unsigned int indexCount)
 
 bool Mesh::Merge(const g2d::Mesh& other, const cxx::float2x3& t)
 {
-	constexpr const int NUMVERTEX_LIMITED = 32768;
 	auto numVertex = GetVertexCount();
-	if (numVertex + other.GetVertexCount() > NUMVERTEX_LIMITED)
+	if (numVertex + other.GetVertexCount() > MaxBatchVertexCount)
 	{
 		return false;
 	}
@@ -114,6 +114,23 @@ bool Geometry::Create(unsigned int vertexCount, unsigned int indexCount)
 	return true;
 }
 
+void Geometry::SetVertexFormat(VertexFormat format)
+{
+	if (mVertexFormat != format)
+	{
+		mVertexFormat = format;
+		cxx::safe_release(mVertexBuffer);
+		mNumVertices = 0;
+	}
+}
+
+unsigned int Geometry::GetVertexStride() const
+{
+	return (mVertexFormat == VertexFormat::Compact)
+		? sizeof(CompactGeometryVertex)
+		: sizeof(g2d::GeometryVertex);
+}
+
 bool Geometry::MakeEnoughVertexArray(unsigned int numVertices)
 {
 	if (mNumVertices >= numVertices)
@@ -121,13 +138,14 @@ bool Geometry::MakeEnoughVertexArray(unsigned int numVertices)
 		return true;
 	}
 
-	auto vertexBuffer = GetRenderSystem().GetDevice()->CreateBuffer(rhi::BufferBinding::Vertex, rhi::ResourceUsage::Dynamic, sizeof(g2d::GeometryVertex) * numVertices);
+	auto vertexBuffer = GetRenderSystem().GetDevice()->CreateBuffer(rhi::BufferBinding::Vertex, rhi::ResourceUsage::Dynamic, GetVertexStride() * numVertices);
 	if (vertexBuffer == nullptr)
 	{
 		return  false;
 	}
 	else
 	{
+		cxx::safe_release(mVertexBuffer);
 		mNumVertices = numVertices;
 		mVertexBuffer = vertexBuffer;
 		return true;
@@ -141,43 +159,93 @@ bool Geometry::MakeEnoughIndexArray(unsigned int numIndices)
 		return true;
 	}
 
-	auto indexBuffer = GetRenderSystem().GetDevice()->CreateBuffer(rhi::BufferBinding::Index, rhi::ResourceUsage::Dynamic, sizeof(unsigned int) * numIndices);
+	auto indexBuffer = GetRenderSystem().GetDevice()->CreateBuffer(rhi::BufferBinding::Index, rhi::ResourceUsage::Dynamic, sizeof(uint16_t) * numIndices);
 	if (indexBuffer == nullptr)
 	{
 		return false;
 	}
 	else
 	{
+		cxx::safe_release(mIndexBuffer);
 		mNumIndices = numIndices;
 		mIndexBuffer = indexBuffer;
 		return true;
 	}
 }
 
-void Geometry::UploadVertices(unsigned int offset, g2d::GeometryVertex* vertices, unsigned int count)
+VertexFormat SelectVertexFormat(VertexFormat preferred, const g2d::GeometryVertex* vertices, unsigned int count)
+{
+	if (preferred != VertexFormat::Compact)
+		return preferred;
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		auto& texcoord = vertices[i].Texcoord;
+		if (texcoord.x < 0.0f || texcoord.x > 1.0f || texcoord.y < 0.0f || texcoord.y > 1.0f)
+		{
+			return VertexFormat::Standard;
+		}
+	}
+	return preferred;
+}
+
+inline uint16_t QuantizeUNorm16(float value)
+{
+	value = (value < 0.0f) ? 0.0f : (value > 1.0f) ? 1.0f : value;
+	return static_cast<uint16_t>(value * 65535.0f + 0.5f);
+}
+
+inline uint8_t QuantizeUNorm8(float value)
+{
+	value = (value < 0.0f) ? 0.0f : (value > 1.0f) ? 1.0f : value;
+	return static_cast<uint8_t>(value * 255.0f + 0.5f);
+}
+
+void Geometry::UploadVertices(unsigned int offset, const g2d::GeometryVertex* vertices, unsigned int count)
 {
 	ENSURE(vertices != nullptr && mVertexBuffer != nullptr);
 
 	auto mappedResource = GetRenderSystem().GetContext()->Map(mVertexBuffer);
 	if (mappedResource.success)
 	{
-		count = __min(mNumVertices - offset, count);
-		auto data = reinterpret_cast<g2d::GeometryVertex*>(mappedResource.data);
-		memcpy(data + offset, vertices, sizeof(g2d::GeometryVertex) * count);
+		count = std::min(mNumVertices - offset, count);
+		if (mVertexFormat == VertexFormat::Compact)
+		{
+			auto data = reinterpret_cast<CompactGeometryVertex*>(mappedResource.data) + offset;
+			for (unsigned int i = 0; i < count; i++)
+			{
+				const g2d::GeometryVertex& src = vertices[i];
+				data[i].Position = src.Position;
+				data[i].Texcoord[0] = QuantizeUNorm16(src.Texcoord.x);
+				data[i].Texcoord[1] = QuantizeUNorm16(src.Texcoord.y);
+				for (int c = 0; c < 4; c++)
+				{
+					data[i].VertexColor[c] = QuantizeUNorm8(src.VertexColor.value.v[c]);
+				}
+			}
+		}
+		else
+		{
+			auto data = reinterpret_cast<g2d::GeometryVertex*>(mappedResource.data);
+			memcpy(data + offset, vertices, sizeof(g2d::GeometryVertex) * count);
+		}
 		GetRenderSystem().GetContext()->Unmap(mVertexBuffer);
 	}
 }
 
-void Geometry::UploadIndices(unsigned int offset, unsigned int* indices, unsigned int count)
+void Geometry::UploadIndices(unsigned int offset, const unsigned int* indices, unsigned int count)
 {
 	ENSURE(indices != nullptr && mIndexBuffer != nullptr);
 
 	auto mappedResource = GetRenderSystem().GetContext()->Map(mIndexBuffer);
 	if (mappedResource.success)
 	{
-		count = __min(mNumIndices - offset, count);
-		auto data = reinterpret_cast<unsigned int*>(mappedResource.data);
-		memcpy(data + offset, indices, sizeof(unsigned int) * count);
+		count = std::min(mNumIndices - offset, count);
+		auto data = reinterpret_cast<uint16_t*>(mappedResource.data) + offset;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			data[i] = static_cast<uint16_t>(indices[i]);
+		}
 		GetRenderSystem().GetContext()->Unmap(mIndexBuffer);
 	}
 }
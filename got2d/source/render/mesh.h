@@ -3,18 +3,52 @@
 #include "g2drender.h"
 #include "../RHI/RHI.h"
 
+enum class VertexFormat : int
+{
+	Standard = 0,	// g2d::GeometryVertex, 32 bytes.
+	Compact = 1,	// CompactGeometryVertex, 16 bytes.
+};
+
+/**
+*	Quantized layout of g2d::GeometryVertex,
+*	texcoord is unorm16 in [0,1],
+*	color is unorm8 in RGBA order.
+*/
+struct CompactGeometryVertex
+{
+	cxx::point2d<float> Position;
+	uint16_t Texcoord[2];
+	uint8_t VertexColor[4];
+};
+
+// texcoord out of [0,1] can not be kept by the compact
+// format, such vertices are uploaded in the standard one.
+VertexFormat SelectVertexFormat(VertexFormat preferred, const g2d::GeometryVertex* vertices, unsigned int count);
+
+/**
+*	indices are always uploaded as 16-bit, batches
+*	never exceed Mesh::MaxBatchVertexCount vertices,
+*	and draw calls offset them by base vertex.
+*/
 class Geometry
 {
 public:
 	bool Create(unsigned int vertexCount, unsigned int indexCount);
 
+	// vertex buffer will be recreated if the format changed.
+	void SetVertexFormat(VertexFormat format);
+
+	VertexFormat GetVertexFormat() const { return mVertexFormat; }
+
+	unsigned int GetVertexStride() const;
+
 	bool MakeEnoughVertexArray(unsigned int numVertices);
 
 	bool MakeEnoughIndexArray(unsigned int numIndices);
 
-	void UploadVertices(unsigned int offset, g2d::GeometryVertex*, unsigned int count);
+	void UploadVertices(unsigned int offset, const g2d::GeometryVertex*, unsigned int count);
 
-	void UploadIndices(unsigned int offset, unsigned int* indices, unsigned int count);
+	void UploadIndices(unsigned int offset, const unsigned int* indices, unsigned int count);
 
 	void Destroy();
 
@@ -22,12 +56,17 @@ public:
 	rhi::Buffer* mIndexBuffer = nullptr;
 	unsigned int mNumVertices = 0;
 	unsigned int mNumIndices = 0;
+
+private:
+	VertexFormat mVertexFormat = VertexFormat::Standard;
 };
 
 class Mesh : public g2d::Mesh
 {
 	RTTI_IMPL;
 public:
+	constexpr static unsigned int MaxBatchVertexCount = 32768;
+
 	Mesh(unsigned int vertexCount, unsigned int indexCount);
 
 	void Clear();
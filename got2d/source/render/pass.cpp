@@ -1,6 +1,17 @@
+#include <atomic>
 #include "pass.h"
 #include "../scope_utility.h"
 
+namespace
+{
+	std::atomic<unsigned int> sConstantVersion{ 0 };
+	std::atomic<unsigned int> sStateVersion{ 0 };
+
+	unsigned int NewConstantVersion()
+	{
+		return ++sConstantVersion;
+	}
+}
 
 //===================================================================
 //	overrides
@@ -12,7 +23,7 @@ bool Pass::IsSame(g2d::Pass* other) const
 	if (!IsSameType(other))
 		return false;
 
-	auto p = reinterpret_cast<Pass*>(&other);
+	auto p = reinterpret_cast<Pass*>(other);
 
 	if (this == p)
 		return true;
@@ -31,21 +42,37 @@ bool Pass::IsSame(g2d::Pass* other) const
 
 	for (size_t i = 0, n = mTextures.size(); i < n; i++)
 	{
-		if (!mTextures[i]->IsSame(p->mTextures[i]))
+		if (GetSampler(static_cast<unsigned int>(i)) != p->GetSampler(static_cast<unsigned int>(i)))
+			return false;
+	}
+
+	bool isSameConstants = (mConstantVersion == p->mConstantVersion);
+
+	for (size_t i = 0, n = mTextures.size(); i < n; i++)
+	{
+		if (mTextures[i] == nullptr || p->mTextures[i] == nullptr)
+		{
+			if (mTextures[i] != p->mTextures[i])
+				return false;
+		}
+		else if (!mTextures[i]->IsSame(p->mTextures[i]))
 		{
 			return false;
 		}
 	}
 
+	if (isSameConstants)
+		return true;
+
 	//we have no idea how to deal with floats.
 	if (mVsConstants.size() > 0 &&
-		0 != memcmp(&(mVsConstants[0]), &(p->mVsConstants[0]), mVsConstants.size() * sizeof(float)))
+		0 != memcmp(&(mVsConstants[0]), &(p->mVsConstants[0]), GetVSConstantLength()))
 	{
 		return  false;
 	}
 
 	if (mPsConstants.size() > 0 &&
-		0 != memcmp(&(mPsConstants[0]), &(p->mPsConstants[0]), mPsConstants.size() * sizeof(float)))
+		0 != memcmp(&(mPsConstants[0]), &(p->mPsConstants[0]), GetPSConstantLength()))
 	{
 		return false;
 	}
@@ -73,6 +100,23 @@ void Pass::SetTexture(unsigned int index, g2d::Texture* tex, bool autoRelease)
 	{
 		mTextures[index]->AddRef();
 	}
+	mStateVersion = NewStateVersion();
+}
+
+void Pass::SetSampler(unsigned int index, const g2d::SamplerDesc& desc)
+{
+	if (index >= mSamplers.size())
+	{
+		mSamplers.resize(index + 1);
+	}
+	mSamplers[index] = desc;
+	mStateVersion = NewStateVersion();
+}
+
+const g2d::SamplerDesc& Pass::GetSampler(unsigned int index) const
+{
+	static const g2d::SamplerDesc sDefaultSampler;
+	return (index < mSamplers.size()) ? mSamplers[index] : sDefaultSampler;
 }
 
 void Pass::SetVSConstant(unsigned int index, float* data, unsigned int size, unsigned int count)
@@ -89,6 +133,8 @@ void Pass::SetVSConstant(unsigned int index, float* data, unsigned int size, uns
 	{
 		memcpy(&(mVsConstants[index + i]), data + i * size, size);
 	}
+	mConstantVersion = NewConstantVersion();
+	mStateVersion = NewStateVersion();
 }
 
 void Pass::SetPSConstant(unsigned int index, float* data, unsigned int size, unsigned int count)
@@ -105,6 +151,14 @@ void Pass::SetPSConstant(unsigned int index, float* data, unsigned int size, uns
 	{
 		memcpy(&(mPsConstants[index + i]), data + i * size, size);
 	}
+	mConstantVersion = NewConstantVersion();
+	mStateVersion = NewStateVersion();
+}
+
+void Pass::SetBlendMode(g2d::BlendMode blendMode)
+{
+	mBlendMode = blendMode;
+	mStateVersion = NewStateVersion();
 }
 
 //===================================================================
@@ -114,9 +168,11 @@ Pass::Pass(const Pass& other)
 	: mVsName(other.mVsName)
 	, mPsName(other.mPsName)
 	, mTextures(other.mTextures.size())
+	, mSamplers(other.mSamplers)
 	, mVsConstants(other.mVsConstants.size())
 	, mPsConstants(other.mPsConstants.size())
 	, mBlendMode(other.mBlendMode)
+	, mConstantVersion(other.mConstantVersion)
 {
 	for (size_t i = 0, n = mTextures.size(); i < n; i++)
 	{
@@ -147,3 +203,8 @@ Pass* Pass::Clone()
 {
 	return new Pass(*this);
 }
+
+unsigned int Pass::NewStateVersion()
+{
+	return ++sStateVersion;
+}
@@ -15,11 +15,15 @@ public:
 
 	virtual void SetTexture(unsigned int index, g2d::Texture*, bool autoRelease) override;
 
+	virtual void SetSampler(unsigned int index, const g2d::SamplerDesc& desc) override;
+
+	virtual const g2d::SamplerDesc& GetSampler(unsigned int index) const override;
+
 	virtual void SetVSConstant(unsigned int index, float* data, unsigned int size, unsigned int count) override;
 
 	virtual void SetPSConstant(unsigned int index, float* data, unsigned int size, unsigned int count) override;
 
-	virtual void SetBlendMode(g2d::BlendMode blendMode) override { mBlendMode = blendMode; }
+	virtual void SetBlendMode(g2d::BlendMode blendMode) override;
 
 	virtual g2d::Texture* GetTextureByIndex(unsigned int index) const override { return mTextures.at(index); }
 
@@ -35,6 +39,10 @@ public:
 
 	virtual g2d::BlendMode GetBlendMode() const override { return mBlendMode; }
 
+	virtual unsigned int GetConstantVersion() const override { return mConstantVersion; }
+
+	virtual unsigned int GetStateVersion() const override { return mStateVersion; }
+
 public:
 	Pass(const std::string& vsName, const std::string& psName)
 		: mVsName(vsName)
@@ -50,12 +58,21 @@ public:
 	void Release() { delete this; }
 
 private:
+	static unsigned int NewStateVersion();
+
 	g2d::BlendMode mBlendMode = g2d::BlendMode::None;
 
 	std::string mVsName = "";
 	std::string mPsName = "";
 
 	std::vector<g2d::Texture*>	mTextures;
+	std::vector<g2d::SamplerDesc>	mSamplers;
 	std::vector<cxx::float4>	mVsConstants;
 	std::vector<cxx::float4>	mPsConstants;
+
+	// unique among all passes, 0 means no constant is set.
+	unsigned int mConstantVersion = 0;
+
+	// a new pass, cloned ones included, always has a newer version.
+	unsigned int mStateVersion = NewStateVersion();
 };
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include "render_queue.h"
+
+namespace
+{
+	std::atomic<unsigned int> sQueueIDGenerator(0);
+
+	// a thread may outlive the queue, so the buffer
+	// is bound to the id of the queue instead of pointer.
+	thread_local unsigned int tlsQueueID = 0;
+	thread_local void* tlsThreadBuffer = nullptr;
+
+	bool RequestOrderSorter(const RenderRequest* a, const RenderRequest* b)
+	{
+		if (a->Layer != b->Layer)
+		{
+			return a->Layer < b->Layer;
+		}
+		if (a->Order != b->Order)
+		{
+			return a->Order < b->Order;
+		}
+		if (a->Sequence != b->Sequence)
+		{
+			return a->Sequence < b->Sequence;
+		}
+		return a->Producer < b->Producer;
+	}
+}
+
+RenderQueue::ThreadBuffer::~ThreadBuffer()
+{
+	for (Chunk* chunk : Chunks)
+	{
+		delete chunk;
+	}
+	Chunks.clear();
+}
+
+RenderRequest& RenderQueue::ThreadBuffer::Alloc()
+{
+	if (CurrentChunk < Chunks.size() && Chunks[CurrentChunk]->Count == ChunkSize)
+	{
+		CurrentChunk++;
+	}
+
+	if (CurrentChunk == Chunks.size())
+	{
+		Chunks.push_back(new Chunk());
+	}
+
+	Chunk* chunk = Chunks[CurrentChunk];
+	return chunk->Requests[chunk->Count++];
+}
+
+RenderQueue::RenderQueue()
+	: mQueueID(++sQueueIDGenerator)
+	, mBufferHead(nullptr)
+	, mBufferCount(0)
+{
+
+}
+
+RenderQueue::~RenderQueue()
+{
+	ThreadBuffer* buffer = mBufferHead.load();
+	while (buffer != nullptr)
+	{
+		ThreadBuffer* next = buffer->Next;
+		delete buffer;
+		buffer = next;
+	}
+	mBufferHead = nullptr;
+}
+
+RenderQueue::ThreadBuffer* RenderQueue::GetThreadBuffer()
+{
+	if (tlsQueueID != mQueueID)
+	{
+		ThreadBuffer* buffer = new ThreadBuffer();
+		buffer->Index = mBufferCount++;
+		buffer->Next = mBufferHead.load(std::memory_order_relaxed);
+		while (!mBufferHead.compare_exchange_weak(buffer->Next, buffer,
+			std::memory_order_release, std::memory_order_relaxed));
+
+		tlsQueueID = mQueueID;
+		tlsThreadBuffer = buffer;
+	}
+	return reinterpret_cast<ThreadBuffer*>(tlsThreadBuffer);
+}
+
+void RenderQueue::Push(const RenderRequest& request)
+{
+	ThreadBuffer* buffer = GetThreadBuffer();
+	RenderRequest& allocated = buffer->Alloc();
+	allocated = request;
+	allocated.Producer = buffer->Index;
+}
+
+const std::vector<const RenderRequest*>& RenderQueue::Drain()
+{
+	mSortedRequests.clear();
+
+	// buffers are linked in reversed registration order.
+	std::vector<ThreadBuffer*> buffers;
+	for (ThreadBuffer* buffer = mBufferHead.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->Next)
+	{
+		buffers.push_back(buffer);
+	}
+
+	for (auto it = buffers.rbegin(); it != buffers.rend(); it++)
+	{
+		ThreadBuffer* buffer = *it;
+		for (unsigned int c = 0, n = static_cast<unsigned int>(buffer->Chunks.size()); c < n && c <= buffer->CurrentChunk; c++)
+		{
+			Chunk* chunk = buffer->Chunks[c];
+			for (unsigned int i = 0; i < chunk->Count; i++)
+			{
+				mSortedRequests.push_back(&(chunk->Requests[i]));
+			}
+		}
+	}
+
+	// requests of single-threaded submitting are almost in order.
+	if (!std::is_sorted(mSortedRequests.begin(), mSortedRequests.end(), RequestOrderSorter))
+	{
+		std::stable_sort(mSortedRequests.begin(), mSortedRequests.end(), RequestOrderSorter);
+	}
+	return mSortedRequests;
+}
+
+void RenderQueue::Reset()
+{
+	mSortedRequests.clear();
+	for (ThreadBuffer* buffer = mBufferHead.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->Next)
+	{
+		for (Chunk* chunk : buffer->Chunks)
+		{
+			chunk->Count = 0;
+		}
+		buffer->CurrentChunk = 0;
+	}
+}
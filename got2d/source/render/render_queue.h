@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include "g2drender.h"
+#include "../scene/static_batch.h"
+#include "sprite_table.h"
+
+struct RenderRequest
+{
+	unsigned int Layer = 0;
+	unsigned int Order = 0;
+	unsigned int Sequence = 0;	//among threads submitting in the same order.
+	g2d::Mesh* Mesh = nullptr;
+	unsigned int Sprite = SpriteTable::InvalidSprite;	//drawn instead of the mesh.
+	g2d::Material* Material = nullptr;
+	cxx::float2x3 WorldMatrix = cxx::float2x3::identity();
+	g2d::DrawParameters Params;
+	StaticBatch* Batch = nullptr;
+	const StaticBatch::Run* BatchRun = nullptr;
+	unsigned int BatchStartIndex = 0;	//part of the run.
+	unsigned int BatchIndexCount = 0;
+	const std::shared_ptr<RetainedGeometry>* Retained = nullptr;	//kept by the owner until flushed.
+	unsigned int RetainedIndexCount = 0;
+	unsigned int Producer = 0;	//registration index of the submitting thread, set by Push.
+};
+
+/**
+*	Multi-producer queue of render requests.
+*	Each producer thread appends to its own chunked buffer
+*	without any lock, buffers are registered lock-free at
+*	the first push of the thread. Draining is NOT allowed
+*	while producers are pushing, it is done by FlushRequests
+*	after all OnRender works finished.
+*/
+class RenderQueue
+{
+public:
+	RenderQueue();
+
+	~RenderQueue();
+
+	void Push(const RenderRequest& request);
+
+	// requests are sorted by (layer, order, sequence, producer),
+	// keeping the submitting order inside one thread. ties between
+	// threads are broken by the registration index of producers.
+	const std::vector<const RenderRequest*>& Drain();
+
+	// release requests returned by Drain.
+	void Reset();
+
+private:
+	constexpr static unsigned int ChunkSize = 256;
+
+	struct Chunk
+	{
+		RenderRequest Requests[ChunkSize];
+		unsigned int Count = 0;
+	};
+
+	struct ThreadBuffer
+	{
+		~ThreadBuffer();
+		RenderRequest& Alloc();
+
+		std::vector<Chunk*> Chunks;
+		unsigned int CurrentChunk = 0;
+		unsigned int Index = 0;
+		ThreadBuffer* Next = nullptr;
+	};
+
+	ThreadBuffer* GetThreadBuffer();
+
+	const unsigned int mQueueID;
+	std::atomic<ThreadBuffer*> mBufferHead;
+	std::atomic<unsigned int> mBufferCount;
+	std::vector<const RenderRequest*> mSortedRequests;
+};
@@ -1,7 +1,12 @@
+#include <algorithm>
 #include <string>
 #include "render_system.h"
 #include "shader.h"
 
+// rendering order of requests submitted by this thread.
+thread_local unsigned int tlsSubmissionOrder = 0;
+thread_local unsigned int tlsSubmissionSequence = 0;
+
 Texture* RenderSystem::CreateTextureFromFile(const char* resPath)
 {
 	return new Texture(resPath);
@@ -31,29 +36,98 @@ bool RenderSystem::CreateBlendModes()
 	return true;
 }
 
+bool RenderSystem::CreateDepthStencilStates()
+{
+	mDepthDisabledState = mDevice->CreateDepthStencilState(false, false);
+	if (mDepthDisabledState == nullptr)
+		return false;
+
+	mDepthTestState = mDevice->CreateDepthStencilState(true, false);
+	if (mDepthTestState == nullptr)
+		return false;
+
+	mDepthWriteState = mDevice->CreateDepthStencilState(true, true);
+	if (mDepthWriteState == nullptr)
+		return false;
+
+	return true;
+}
+
 //===================================================================
 //	overrides
 //===================================================================
 
 void RenderSystem::BeginRender()
 {
-	Clear();
+	// wait for a free packet, frames in flight
+	// will not exceed the count of packets.
+	if (mRenderThread.joinable())
+	{
+		std::unique_lock<std::mutex> lock(mPacketMutex);
+		mCompletedCondition.wait(lock, [&] {
+			return mSubmittedFence - mCompletedFence < mPackets.size();
+		});
+	}
+	mRecordingPacket = mPackets[mSubmittedFence % mPackets.size()];
+	mRecordingPacket->Reset(mVertexFormat);
+	mCurrentTarget = FramePacket::InvalidTarget;
+	mWrittenTargets.assign(mCompositor.GetTargetCount(), false);
+	mIsRedrawn = false;
+
+	// scenes clear the regions they redraw.
+	if (!mIsPartialRedraw)
+	{
+		Clear();
+	}
 }
 
 void RenderSystem::EndRender()
 {
 	FlushRequests();
-	Present();
+	RecordComposites();
+	if (!mIsPartialRedraw || mIsRedrawn)
+	{
+		Present();
+	}
+	SubmitPacket();
 }
 
 void RenderSystem::RenderMesh(unsigned int layer, g2d::Mesh* mesh, g2d::Material* material, const cxx::float2x3& worldMatrix)
 {
-	if (mRenderRequests.count(layer) == 0)
+	static const g2d::DrawParameters sDefaultParameters;
+	RenderMesh(layer, mesh, material, worldMatrix, sDefaultParameters);
+}
+
+void RenderSystem::RenderMesh(unsigned int layer, g2d::Mesh* mesh, g2d::Material* material, const cxx::float2x3& worldMatrix, const g2d::DrawParameters& params)
+{
+	// capturing only happens in culling, when
+	// no other thread is submitting.
+	if (mCaptureBatch != nullptr)
 	{
-		mRenderRequests[layer] = new RenderRequestList();
+		mCaptureBatch->Capture(layer, *mesh, *material, worldMatrix, params);
+		return;
 	}
-	RenderRequestList* list = mRenderRequests[layer];
-	list->push_back({ *mesh, *material, worldMatrix });
+
+	RenderRequest request;
+	request.Layer = layer;
+	request.Order = tlsSubmissionOrder;
+	request.Sequence = tlsSubmissionSequence;
+	request.Mesh = mesh;
+	request.Material = material;
+	request.WorldMatrix = worldMatrix;
+	request.Params = params;
+	mRenderQueue.Push(request);
+}
+
+void RenderSystem::SetSubmissionOrder(unsigned int order, unsigned int sequence)
+{
+	tlsSubmissionOrder = order;
+	tlsSubmissionSequence = sequence;
+}
+
+unsigned int RenderSystem::GetSubmissionOrder() const
+{
+	return tlsSubmissionOrder;
 }
 
 unsigned int RenderSystem::GetWindowWidth() const
@@ -84,11 +158,40 @@ cxx::point2d<int> RenderSystem::ViewToScreen(const cxx::point2d<float> & view) c
 	return { x, y };
 }
 
+void RenderSystem::SetCompactVertexFormat(bool compact)
+{
+	mVertexFormat = compact ? VertexFormat::Compact : VertexFormat::Standard;
+}
+
+bool RenderSystem::IsCompactVertexFormat() const
+{
+	return mVertexFormat == VertexFormat::Compact;
+}
+
+unsigned int RenderSystem::GetFrameFence() const
+{
+	return mSubmittedFence;
+}
+
+bool RenderSystem::IsFenceCompleted(unsigned int fence) const
+{
+	std::lock_guard<std::mutex> lock(mPacketMutex);
+	return mCompletedFence >= fence;
+}
+
+void RenderSystem::WaitForFence(unsigned int fence)
+{
+	std::unique_lock<std::mutex> lock(mPacketMutex);
+	mCompletedCondition.wait(lock, [&] {
+		return mCompletedFence >= fence;
+	});
+}
+
 
 //===================================================================
 //	functions
 //===================================================================
-bool RenderSystem::Create(void* nativeWindow)
+bool RenderSystem::Create(void* nativeWindow, unsigned int frameLatency, const char* shaderCachePath, bool partialRedraw)
 {
 	mViewport.LTPosition = cxx::float2::zero();
 	mViewport.MinMaxZ = cxx::float2(0.0f, 1.0f);
@@ -97,7 +200,7 @@ bool RenderSystem::Create(void* nativeWindow)
 		Destroy();
 	});
 
-	rhi::RHICreationResult rhiResult = rhi::CreateRHI();
+	rhi::RHICreationResult rhiResult = rhi::CreateRHI(frameLatency > 0);
 	if (!rhiResult.Success)
 	{
 		return false;
@@ -106,11 +209,13 @@ bool RenderSystem::Create(void* nativeWindow)
 	mDevice = rhiResult.DevicePtr;
 	mContext = rhiResult.ContextPtr;
 
-	mSwapChain = mDevice->CreateSwapChain(nativeWindow, false, 0, 0);
+	// depth of the back buffer is used to reject pixels behind opaque drawcalls.
+	mSwapChain = mDevice->CreateSwapChain(nativeWindow, true, partialRedraw, 0, 0);
 	if (mSwapChain == nullptr)
 	{
 		return false;
 	}
+	mIsPartialRedraw = partialRedraw;
 
 	mSceneConstBuffer = mDevice->CreateBuffer(rhi::BufferBinding::Constant,
 		rhi::ResourceUsage::Dynamic,
@@ -133,6 +238,11 @@ bool RenderSystem::Create(void* nativeWindow)
 
 	SetBlendMode(g2d::BlendMode::None);
 
+	if (!CreateDepthStencilStates())
+	{
+		return false;
+	}
+
 	//all creation using RenderSystem should be start here.
 	if (!mTexPool.CreateDefaultTexture())
 	{
@@ -140,6 +250,28 @@ bool RenderSystem::Create(void* nativeWindow)
 	}
 
 	mShaderlib = new ShaderLib();
+	if (shaderCachePath != nullptr)
+	{
+		mShaderlib->LoadCache(shaderCachePath);
+	}
+
+	// compile shaders missing in the cache now, not in the first frame drawing them.
+	// failures are reported by the lib, those shaders are retried when drawing.
+	mShaderlib->WarmUp();
+
+	// one packet is recording while the
+	// others are waiting for executing.
+	unsigned int packetCount = (frameLatency > 0) ? frameLatency + 1 : 1;
+	for (unsigned int i = 0; i < packetCount; i++)
+	{
+		mPackets.push_back(new FramePacket());
+	}
+	mRecordingPacket = mPackets[0];
+
+	if (frameLatency > 0)
+	{
+		mRenderThread = std::thread([this] { RenderThreadMain(); });
+	}
 	failGuard.dismiss();
 
 	return true;
@@ -147,11 +279,32 @@ bool RenderSystem::Create(void* nativeWindow)
 
 void RenderSystem::Destroy()
 {
-	for (auto& list : mRenderRequests)
+	if (mRenderThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mPacketMutex);
+			mIsRenderThreadExiting = true;
+		}
+		mPendingCondition.notify_all();
+		mRenderThread.join();
+	}
+
+	for (auto& packet : mPackets)
+	{
+		delete packet;
+	}
+	mPackets.clear();
+	mRecordingPacket = nullptr;
+
+	mRenderQueue.Reset();
+
+	cxx::safe_release(mRedrawMaterial);
+	for (auto& shared : mSharedMaterials)
 	{
-		delete list.second;
+		shared.second->Release();
 	}
-	mRenderRequests.clear();
+	mSharedMaterials.clear();
+	cxx::safe_release(mQuadMesh);
 
 	for (auto& blendMode : mBlendModes)
 	{
@@ -162,13 +315,37 @@ void RenderSystem::Destroy()
 	}
 	mBlendModes.clear();
 
+	cxx::safe_release(mDepthDisabledState);
+	cxx::safe_release(mDepthTestState);
+	cxx::safe_release(mDepthWriteState);
+
 	mGeometry.Destroy();
 	mTexPool.Destroy();
 
+	mConstantRing.Destroy();
+
+	for (auto& sampler : mSamplerStates)
+	{
+		if (sampler.second)
+		{
+			sampler.second->Release();
+		}
+	}
+	mSamplerStates.clear();
+	mBoundSamplers.clear();
+
+	mCompositor.Clear();
+	for (auto& renderTarget : mTargetPool)
+	{
+		cxx::safe_release(renderTarget);
+	}
+	mTargetPool.clear();
+	mPassConstantRanges.clear();
+	mUploadedConstantVersions.clear();
+
 	mBackBufferRT = nullptr;
 	cxx::safe_delete(mShaderlib);
 	cxx::safe_release(mSceneConstBuffer);
-	cxx::safe_release(mRenderTarget);
 	cxx::safe_release(mSwapChain);
 	cxx::safe_release(mDevice);
 	cxx::safe_release(mContext);
@@ -177,52 +354,86 @@ void RenderSystem::Destroy()
 
 void RenderSystem::Clear()
 {
-	mContext->ClearRenderTarget(mBackBufferRT, mBkColor);
+	mRecordingPacket->Clear(mBkColor);
 }
 
 void RenderSystem::FlushRequests()
 {
-	if (mRenderRequests.size() == 0)
+	auto& requests = mRenderQueue.Drain();
+	if (requests.size() == 0)
 		return;
 
-	Mesh batchMesh(0, 0);
+	FramePacket& packet = *mRecordingPacket;
 	g2d::Material* material = nullptr;
-	for (auto& reqList : mRenderRequests)
+	for (size_t i = 0, n = requests.size(); i < n; i++)
 	{
-		RenderRequestList& list = *(reqList.second);
-		if (list.size() == 0)
-			continue;
-
-		for (auto& request : list)
+		const RenderRequest* request = requests[i];
+		if (request->Batch != nullptr)
 		{
-			if (material == nullptr)
+			//static geometry is already merged,
+			//flush the pending batch to keep the order.
+			if (material != nullptr)
 			{
-				material = &(request.material);
+				packet.FlushDraw(*material);
+				material = nullptr;
 			}
-			else if (!request.material.IsSame(material))//material may be nullptr.
+
+			//spans of a run split by other layers become adjacent again.
+			unsigned int indexCount = request->BatchIndexCount;
+			while (i + 1 < n && requests[i + 1]->BatchRun == request->BatchRun &&
+				requests[i + 1]->BatchStartIndex == request->BatchStartIndex + indexCount)
 			{
-				FlushBatch(batchMesh, *material);
-				material = &(request.material);
+				indexCount += requests[++i]->BatchIndexCount;
 			}
+			packet.DrawRetained(request->Batch->GetGeometry(), *(request->Material), request->BatchStartIndex, indexCount, request->BatchRun->BaseVertex, cxx::float2x3::identity());
+			continue;
+		}
 
-			if (!batchMesh.Merge(request.mesh, request.worldMatrix))
+		if (request->Retained != nullptr)
+		{
+			if (material != nullptr)
 			{
-				FlushBatch(batchMesh, *material);
-				//de factor, no need to Merge when there is only ONE MESH each drawcall.
-				batchMesh.Merge(request.mesh, request.worldMatrix);
+				packet.FlushDraw(*material);
+				material = nullptr;
 			}
+			packet.DrawRetained(*(request->Retained), *(request->Material), 0, request->RetainedIndexCount, 0, request->WorldMatrix);
+			continue;
+		}
+
+		if (material == nullptr)
+		{
+			material = request->Material;
+		}
+		else if (!request->Material->IsSame(material))//material may be nullptr.
+		{
+			packet.FlushDraw(*material);
+			material = request->Material;
+		}
+
+		auto merge = [&]
+		{
+			return (request->Sprite != SpriteTable::InvalidSprite)
+				? packet.MergeSprite(mSpriteTable, request->Sprite, request->WorldMatrix)
+				: packet.Merge(*(request->Mesh), request->WorldMatrix, request->Params);
+		};
+
+		if (!merge())
+		{
+			packet.FlushDraw(*material);
+			//de factor, no need to Merge when there is only ONE MESH each drawcall.
+			merge();
 		}
-		list.clear();
 	}
 	if (material != nullptr)
 	{
-		FlushBatch(batchMesh, *material);
+		packet.FlushDraw(*material);
 	}
+	mRenderQueue.Reset();
 }
 
 void RenderSystem::Present()
 {
-	mSwapChain->Present();
+	mRecordingPacket->Present();
 }
 
 void RenderSystem::SetBlendMode(g2d::BlendMode blendMode)
@@ -235,11 +446,149 @@ void RenderSystem::SetBlendMode(g2d::BlendMode blendMode)
 
 void RenderSystem::SetViewMatrix(const cxx::float2x3& viewMatrix)
 {
-	if (viewMatrix != mMatrixView)
+	mRecordingPacket->SetViewMatrix(viewMatrix);
+}
+
+void RenderSystem::BindCameraTarget(const char* name)
+{
+	unsigned int target = mCompositor.FindTarget(name);
+	if (target != Compositor::InvalidIndex)
 	{
-		mMatrixView = viewMatrix;
-		mMatrixConstBufferDirty = true;
+		mCompositor.MarkCameraTarget(target);
 	}
+	BindTarget(target);
+}
+
+bool RenderSystem::IsPersistentTarget(const char* name) const
+{
+	unsigned int target = mCompositor.FindTarget(name);
+	return target != Compositor::InvalidIndex && mCompositor.GetTarget(target).IsPersistent;
+}
+
+bool RenderSystem::DeclareRenderTarget(const char* name, float scale, const cxx::color4f& clearColor, bool persistent)
+{
+	return mCompositor.DeclareTarget(name, scale, clearColor, persistent);
+}
+
+bool RenderSystem::AddCompositePass(const char* output, const char** inputs, unsigned int inputCount, g2d::Material* material)
+{
+	return mCompositor.AddPass(output, inputs, inputCount, material);
+}
+
+void RenderSystem::ClearCompositor()
+{
+	// commands recorded in this frame are dropped when executing.
+	if (mCurrentTarget != FramePacket::InvalidTarget)
+	{
+		BindTarget(FramePacket::InvalidTarget);
+	}
+	mCompositor.Clear();
+	mWrittenTargets.clear();
+}
+
+void RenderSystem::SetFillStatisticsEnabled(bool enabled)
+{
+	mIsFillStatisticsEnabled = enabled;
+	if (!enabled)
+	{
+		std::lock_guard<std::mutex> lock(mFillStatisticsMutex);
+		mFillStatistics = g2d::FillStatistics();
+	}
+}
+
+bool RenderSystem::IsFillStatisticsEnabled() const
+{
+	return mIsFillStatisticsEnabled;
+}
+
+g2d::FillStatistics RenderSystem::GetFillStatistics() const
+{
+	std::lock_guard<std::mutex> lock(mFillStatisticsMutex);
+	return mFillStatistics;
+}
+
+void RenderSystem::BindTarget(unsigned int target)
+{
+	if (target == mCurrentTarget)
+		return;
+
+	// pending requests belong to the former target.
+	FlushRequests();
+	mCurrentTarget = target;
+
+	bool clear = false;
+	cxx::color4f clearColor = mBkColor;
+	if (target != FramePacket::InvalidTarget)
+	{
+		if (mWrittenTargets.size() <= target)
+		{
+			mWrittenTargets.resize(target + 1, false);
+		}
+		clear = !mWrittenTargets[target];
+		clearColor = mCompositor.GetTarget(target).ClearColor;
+		mWrittenTargets[target] = true;
+	}
+	mRecordingPacket->SetRenderTarget(target, clear, clearColor);
+}
+
+void RenderSystem::BeginRedraw(const rhi::Rect* region)
+{
+	FlushRequests();
+	BindTarget(FramePacket::InvalidTarget);
+	mIsRedrawn = true;
+	if (region == nullptr)
+	{
+		Clear();
+		return;
+	}
+
+	// clearing ignores the scissor, fill the region
+	// with the background by a full-screen quad instead.
+	if (mRedrawMaterial == nullptr)
+	{
+		mRedrawMaterial = GetSharedMaterial("quad.simple_color", [] { return g2d::Material::CreateSimpleColor(); });
+	}
+	cxx::float2 windowSize(static_cast<float>(GetWindowWidth()), static_cast<float>(GetWindowHeight()));
+	auto screenMatrix = cxx::float2x3::trsp(cxx::point2d<float>::origin(), cxx::radian<float>(0), windowSize, cxx::float2::zero());
+	g2d::DrawParameters params;
+	params.Tint = mBkColor;
+
+	mRecordingPacket->SetScissorRect(region);
+	mRecordingPacket->SetViewMatrix(cxx::float2x3::identity());
+	mRecordingPacket->Merge(*GetQuadMesh(), screenMatrix, params);
+	mRecordingPacket->FlushDraw(*mRedrawMaterial);
+}
+
+void RenderSystem::EndRedraw()
+{
+	FlushRequests();
+	mRecordingPacket->SetScissorRect(nullptr);
+}
+
+void RenderSystem::RecordComposites()
+{
+	// full-screen quad with identity view matrix.
+	cxx::float2 windowSize(static_cast<float>(GetWindowWidth()), static_cast<float>(GetWindowHeight()));
+	auto screenMatrix = cxx::float2x3::trsp(cxx::point2d<float>::origin(), cxx::radian<float>(0), windowSize, cxx::float2::zero());
+	g2d::DrawParameters params;
+
+	for (unsigned int passIndex : mCompositor.GetPassOrder())
+	{
+		auto& pass = mCompositor.GetPass(passIndex);
+		BindTarget(pass.Output);
+		mRecordingPacket->SetViewMatrix(cxx::float2x3::identity());
+		mRecordingPacket->Merge(*GetQuadMesh(), screenMatrix, params);
+		mRecordingPacket->FlushDraw(*pass.MaterialPtr, &(pass.Inputs));
+	}
+	BindTarget(FramePacket::InvalidTarget);
+
+	mTargetSlots.resize(mCompositor.GetTargetCount());
+	for (unsigned int t = 0, n = mCompositor.GetTargetCount(); t < n; t++)
+	{
+		mTargetSlots[t].PhysicalIndex = mCompositor.GetPhysicalIndex(t);
+		mTargetSlots[t].Scale = mCompositor.GetTarget(t).Scale;
+	}
+	mRecordingPacket->SetTargetSlots(mTargetSlots);
 }
 
 const cxx::float4x4& RenderSystem::GetProjectionMatrix()
@@ -259,116 +608,644 @@ const cxx::float4x4& RenderSystem::GetProjectionMatrix()
 
 bool RenderSystem::OnResize(unsigned int width, unsigned int height)
 {
-	if (!mSwapChain->OnResize(width, height))
-	{
-		return false;
-	}
+	// swap chain can not be resized while rendering.
+	WaitForIdle();
 
-	//though we create an individual render target
-	//we do not use it for rendering, for now.
-	//it will be used when building Compositor System.
-	auto rtFormat = rhi::TextureFormat::BGRA;
-	mRenderTarget = mDevice->CreateRenderTarget(width, height, &rtFormat, 1, false);
-	if (mRenderTarget == nullptr)
+	if (!mSwapChain->OnResize(width, height))
 	{
 		return false;
 	}
 
+	//pooled targets are resized when they are used next time.
 	mBackBufferRT = mSwapChain->GetBackBuffer();
 
 	mMatrixProjDirty = true;
 	mMatrixConstBufferDirty = true;
 
 	mViewport.Size = cxx::float2((float)width, (float)height);
-	mContext->SetRenderTarget(mBackBufferRT);
-	mContext->SetViewport(mViewport);
+	ApplyRenderTarget(mBackBufferRT);
 
 	return true;
 }
 
-void RenderSystem::FlushBatch(Mesh& mesh, g2d::Material& material)
+void RenderSystem::BeginCapture(StaticBatch* batch)
+{
+	mCaptureBatch = batch;
+}
+
+void RenderSystem::EndCapture()
+{
+	mCaptureBatch = nullptr;
+}
+
+g2d::Material* RenderSystem::GetSharedMaterial(const std::string& name, const std::function<g2d::Material*()>& creator)
+{
+	std::lock_guard<std::mutex> lock(mSharedResourceMutex);
+	auto& material = mSharedMaterials[name];
+	if (material == nullptr)
+	{
+		material = creator();
+	}
+	material->AddRef();
+	return material;
+}
+
+g2d::Mesh* RenderSystem::GetQuadMesh()
+{
+	std::lock_guard<std::mutex> lock(mSharedResourceMutex);
+	if (mQuadMesh == nullptr)
+	{
+		mQuadMesh = g2d::Mesh::Create(4, 6);
+
+		unsigned int indices[] = { 0, 2, 1, 0, 3, 2 };
+		unsigned int* pIndexPtr = mQuadMesh->GetRawIndices();
+		for (int i = 0; i < 6; i++)
+		{
+			pIndexPtr[i] = indices[i];
+		}
+
+		g2d::GeometryVertex* vertices = mQuadMesh->GetRawVertices();
+		vertices[0].Position = cxx::float2(-0.5f, -0.5f);
+		vertices[3].Position = cxx::float2(-0.5f, +0.5f);
+		vertices[2].Position = cxx::float2(+0.5f, +0.5f);
+		vertices[1].Position = cxx::float2(+0.5f, -0.5f);
+
+		vertices[0].Texcoord = cxx::float2(0, 1);
+		vertices[3].Texcoord = cxx::float2(0, 0);
+		vertices[2].Texcoord = cxx::float2(1, 0);
+		vertices[1].Texcoord = cxx::float2(1, 1);
+
+		for (int i = 0; i < 4; i++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				vertices[i].VertexColor.value.v[c] = 1.0f;
+			}
+		}
+	}
+	return mQuadMesh;
+}
+
+void RenderSystem::RenderSprite(unsigned int layer, g2d::Material* material, const cxx::float2x3& worldMatrix, unsigned int sprite)
 {
-	if (mesh.GetIndexCount() == 0)
+	// batches merge meshes only.
+	if (mCaptureBatch != nullptr)
+	{
+		g2d::DrawParameters params;
+		params.Tint = mSpriteTable.GetColor(sprite);
+		params.TexcoordOffset = mSpriteTable.GetTexcoordOffset(sprite);
+		params.TexcoordScale = mSpriteTable.GetTexcoordScale(sprite);
+		mCaptureBatch->Capture(layer, *GetQuadMesh(), *material, worldMatrix * mSpriteTable.GetLocalMatrix(sprite), params);
 		return;
+	}
 
-	mGeometry.MakeEnoughVertexArray(mesh.GetVertexCount());
-	mGeometry.MakeEnoughIndexArray(mesh.GetIndexCount());
-	mGeometry.UploadVertices(0, mesh.GetRawVertices(), mesh.GetVertexCount());
-	mGeometry.UploadIndices(0, mesh.GetRawIndices(), mesh.GetIndexCount());
+	RenderRequest request;
+	request.Layer = layer;
+	request.Order = tlsSubmissionOrder;
+	request.Sequence = tlsSubmissionSequence;
+	request.Sprite = sprite;
+	request.Material = material;
+	request.WorldMatrix = worldMatrix;
+	mRenderQueue.Push(request);
+}
 
-	for (unsigned int i = 0; i < material.GetPassCount(); i++)
+void RenderSystem::RenderStaticBatch(StaticBatch& batch, unsigned int cameraVisibleMask, unsigned int firstComponent, unsigned int endComponent)
+{
+	unsigned int startIndex = batch.GetIndexStart(firstComponent);
+	unsigned int endIndex = batch.GetIndexStart(endComponent);
+	for (auto& run : batch.GetRuns())
+	{
+		unsigned int runStart = std::max(run.StartIndex, startIndex);
+		unsigned int runEnd = std::min(run.StartIndex + run.IndexCount, endIndex);
+		if (runStart >= runEnd || (run.CameraVisibleMask & cameraVisibleMask) == 0)
+			continue;
+
+		RenderRequest request;
+		request.Layer = run.Layer;
+		request.Order = batch.GetComponents()[firstComponent]->_GetRenderingOrder_Internal();
+		request.Material = run.MaterialPtr;
+		request.Batch = &batch;
+		request.BatchRun = &run;
+		request.BatchStartIndex = runStart;
+		request.BatchIndexCount = runEnd - runStart;
+		mRenderQueue.Push(request);
+	}
+}
+
+void RenderSystem::RenderRetained(unsigned int layer, g2d::Material* material, const std::shared_ptr<RetainedGeometry>& geometry, unsigned int indexCount, const cxx::float2x3& worldMatrix)
+{
+	// batches can not merge retained geometry, it is drawn by itself.
+	if (mCaptureBatch != nullptr || geometry == nullptr || indexCount == 0)
+		return;
+
+	RenderRequest request;
+	request.Layer = layer;
+	request.Order = tlsSubmissionOrder;
+	request.Sequence = tlsSubmissionSequence;
+	request.Material = material;
+	request.Retained = &geometry;
+	request.RetainedIndexCount = indexCount;
+	request.WorldMatrix = worldMatrix;
+	mRenderQueue.Push(request);
+}
+
+void RenderSystem::SubmitPacket()
+{
+	mSubmittedFence++;
+	if (mRenderThread.joinable())
 	{
-		auto pass = material.GetPassByIndex(i);
-		auto shader = mShaderlib->GetShaderByName(pass->GetVertexShaderName(), pass->GetPixelShaderName());
-		if (shader)
 		{
-			rhi::VertexBufferInfo info;
-			info.stride = sizeof(g2d::GeometryVertex);
-			info.offset = 0;
-			info.buffer = mGeometry.mVertexBuffer;
-			mContext->SetVertexBuffers(0, &info, 1);
-			mContext->SetIndexBuffer(mGeometry.mIndexBuffer, 0, rhi::IndexFormat::Int32);
-			mContext->SetShaderProgram(shader->GetShaderProgram());
-			UpdateSceneConstBuffer();
-			mContext->SetVertexShaderConstantBuffers(0, &mSceneConstBuffer, 1);
-			SetBlendMode(pass->GetBlendMode());
+			std::lock_guard<std::mutex> lock(mPacketMutex);
+			mPendingPackets.push_back(mRecordingPacket);
+		}
+		mPendingCondition.notify_one();
+	}
+	else
+	{
+		ExecutePacket(*mRecordingPacket);
+		mRecordingPacket->Reset(mVertexFormat);
+		std::lock_guard<std::mutex> lock(mPacketMutex);
+		mCompletedFence = mSubmittedFence;
+	}
+}
+
+void RenderSystem::WaitForIdle()
+{
+	WaitForFence(mSubmittedFence);
+}
 
-			auto vcb = shader->GetVertexConstBuffer();
-			if (vcb)
+void RenderSystem::RenderThreadMain()
+{
+	while (true)
+	{
+		FramePacket* packet = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(mPacketMutex);
+			mPendingCondition.wait(lock, [&] {
+				return !mPendingPackets.empty() || mIsRenderThreadExiting;
+			});
+
+			// finish pending frames before exiting.
+			if (mPendingPackets.empty())
+				break;
+
+			packet = mPendingPackets.front();
+			mPendingPackets.pop_front();
+		}
+
+		ExecutePacket(*packet);
+
+		{
+			std::lock_guard<std::mutex> lock(mPacketMutex);
+			mCompletedFence++;
+		}
+		mCompletedCondition.notify_all();
+	}
+}
+
+void RenderSystem::ExecutePacket(const FramePacket& packet)
+{
+	auto& vertices = packet.GetVertices();
+	auto& indices = packet.GetIndices();
+	if (!indices.empty())
+	{
+		auto numVertices = static_cast<unsigned int>(vertices.size());
+		auto numIndices = static_cast<unsigned int>(indices.size());
+		mGeometry.SetVertexFormat(SelectVertexFormat(packet.GetVertexFormat(), &(vertices[0]), numVertices));
+		if (!mGeometry.MakeEnoughVertexArray(numVertices) ||
+			!mGeometry.MakeEnoughIndexArray(numIndices))
+		{
+			return;
+		}
+		mGeometry.UploadVertices(0, &(vertices[0]), numVertices);
+		mGeometry.UploadIndices(0, &(indices[0]), numIndices);
+	}
+
+	mUseConstantRing = mContext->IsConstantBufferRangeSupported() && UploadPassConstants(packet);
+
+	mIsFillCounting = mIsFillStatisticsEnabled;
+	if (mIsFillCounting)
+	{
+		mFillCounter.Reset(mBackBufferRT->GetWidth(), mBackBufferRT->GetHeight());
+		mFillCounter.SetClipRect(mIsScissorEnabled ? &mScissorRect : nullptr);
+	}
+
+	// depth is derived from the order of drawcalls in this packet.
+	mContext->ClearDepthStencil(mBackBufferRT, 1.0f, 0);
+	mExecutingViewMatrix = mMatrixView;
+
+	for (auto& command : packet.GetCommands())
+	{
+		if (command.Type != FramePacket::CommandType::Draw &&
+			command.Type != FramePacket::CommandType::SetViewMatrix)
+		{
+			FlushPendingDraws(packet);
+		}
+
+		switch (command.Type)
+		{
+		case FramePacket::CommandType::Clear:
+			mContext->ClearRenderTarget(mBackBufferRT, command.Color);
+			break;
+
+		case FramePacket::CommandType::SetViewMatrix:
+			mExecutingViewMatrix = command.Matrix;
+			break;
+
+		case FramePacket::CommandType::Draw:
+			mPendingDraws.push_back({ command.DrawIndex, mExecutingViewMatrix });
+			break;
+
+		case FramePacket::CommandType::SetRenderTarget:
+		{
+			rhi::RenderTarget* renderTarget = mBackBufferRT;
+			if (command.TargetIndex != FramePacket::InvalidTarget)
 			{
-				auto length = (shader->GetVertexConstBuffer()->GetLength() > pass->GetVSConstantLength())
-					? pass->GetVSConstantLength()
-					: shader->GetVertexConstBuffer()->GetLength();
-				if (length > 0)
-				{
-					UpdateConstBuffer(vcb, pass->GetVSConstant(), length);
-					mContext->SetVertexShaderConstantBuffers(1, &vcb, 1);
-				}
+				auto slot = packet.GetTargetSlot(command.TargetIndex);
+				renderTarget = (slot != nullptr) ? GetPooledTarget(slot->PhysicalIndex, slot->Scale) : nullptr;
 			}
 
-			auto pcb = shader->GetPixelConstBuffer();
-			if (pcb)
+			if (renderTarget != nullptr)
 			{
-				auto length = (shader->GetPixelConstBuffer()->GetLength() > pass->GetPSConstantLength())
-					? pass->GetPSConstantLength()
-					: shader->GetPixelConstBuffer()->GetLength();
-				if (length > 0)
+				ApplyRenderTarget(renderTarget);
+				if (command.ClearTarget)
 				{
-					UpdateConstBuffer(pcb, pass->GetPSConstant(), length);
-					mContext->SetPixelShaderConstantBuffers(0, &pcb, 1);
+					mContext->ClearRenderTarget(renderTarget, command.Color);
 				}
 			}
+			break;
+		}
+
+		case FramePacket::CommandType::SetScissor:
+			mIsScissorEnabled = command.EnableScissor;
+			mScissorRect = command.ScissorRect;
+			if (mAppliedRT == mBackBufferRT)
+			{
+				mContext->SetScissorRect(mIsScissorEnabled ? &mScissorRect : nullptr);
+			}
+			if (mIsFillCounting)
+			{
+				mFillCounter.SetClipRect(mIsScissorEnabled ? &mScissorRect : nullptr);
+			}
+			break;
+
+		case FramePacket::CommandType::Present:
+			mSwapChain->Present();
+			break;
+		}
+	}
+	FlushPendingDraws(packet);
+
+	if (mIsFillCounting && mIsFillStatisticsEnabled)
+	{
+		std::lock_guard<std::mutex> lock(mFillStatisticsMutex);
+		mFillStatistics = mFillCounter.GetStatistics();
+	}
+}
+
+void RenderSystem::FlushPendingDraws(const FramePacket& packet)
+{
+	if (mPendingDraws.empty())
+		return;
+
+	// pooled targets have no depth buffer.
+	bool useDepth = false;
+	if (mAppliedRT == mBackBufferRT)
+	{
+		for (auto& pendingDraw : mPendingDraws)
+		{
+			if (packet.GetDrawCall(pendingDraw.DrawIndex).IsOpaque)
+			{
+				useDepth = true;
+				break;
+			}
+		}
+	}
+
+	if (useDepth)
+	{
+		// opaque drawcalls are drawn nearest first, pixels
+		// behind them are rejected before shading, then the
+		// blended ones are drawn in order, testing the depth.
+		mContext->SetDepthStencilState(mDepthWriteState);
+		for (auto it = mPendingDraws.rbegin(); it != mPendingDraws.rend(); it++)
+		{
+			if (packet.GetDrawCall(it->DrawIndex).IsOpaque)
+			{
+				ExecuteDraw(packet, *it, true);
+			}
+		}
+
+		mContext->SetDepthStencilState(mDepthTestState);
+		for (auto& pendingDraw : mPendingDraws)
+		{
+			if (!packet.GetDrawCall(pendingDraw.DrawIndex).IsOpaque)
+			{
+				ExecuteDraw(packet, pendingDraw, true);
+			}
+		}
+		mContext->SetViewport(mAppliedViewport);
+	}
+	else
+	{
+		// the default state of the device tests the depth.
+		mContext->SetDepthStencilState(mDepthDisabledState);
+		for (auto& pendingDraw : mPendingDraws)
+		{
+			ExecuteDraw(packet, pendingDraw, false);
+		}
+	}
+	mPendingDraws.clear();
+}
+
+void RenderSystem::ExecuteDraw(const FramePacket& packet, const PendingDraw& pendingDraw, bool useDepth)
+{
+	// retained geometry may be in the local space of its owner.
+	auto& drawCall = packet.GetDrawCall(pendingDraw.DrawIndex);
+	cxx::float2x3 viewMatrix = pendingDraw.ViewMatrix * drawCall.WorldMatrix;
+	if (viewMatrix != mMatrixView)
+	{
+		mMatrixView = viewMatrix;
+		mMatrixConstBufferDirty = true;
+	}
+
+	// vertex shaders output zero depth, the viewport maps it to the depth of the drawcall.
+	float depth = 1.0f - (pendingDraw.DrawIndex + 1.0f) / (packet.GetDrawCallCount() + 1.0f);
+	if (useDepth)
+	{
+		rhi::Viewport viewport = mAppliedViewport;
+		viewport.MinMaxZ = cxx::float2(depth, depth);
+		mContext->SetViewport(viewport);
+	}
+
+	Geometry& geometry = (drawCall.Retained != nullptr)
+		? drawCall.Retained->GetGeometry()
+		: mGeometry;
+	DrawGeometry(geometry, packet, drawCall);
+
+	if (mIsFillCounting && mAppliedRT == mBackBufferRT)
+	{
+		auto& vertices = (drawCall.Retained != nullptr) ? drawCall.Retained->Vertices : packet.GetVertices();
+		auto& indices = (drawCall.Retained != nullptr) ? drawCall.Retained->Indices : packet.GetIndices();
+		mFillCounter.Draw(vertices, indices, drawCall, viewMatrix,
+			depth, useDepth, useDepth && drawCall.IsOpaque);
+	}
+}
+
+void RenderSystem::DrawGeometry(Geometry& geometry, const FramePacket& packet, const FramePacket::DrawCall& drawCall)
+{
+	if (geometry.mVertexBuffer == nullptr || geometry.mIndexBuffer == nullptr)
+		return;
+
+	for (unsigned int i = 0; i < drawCall.PassCount; i++)
+	{
+		auto pass = &(packet.GetPass(drawCall.FirstPass + i));
+		auto shader = mShaderlib->GetShaderByName(pass->VsName, pass->PsName, geometry.GetVertexFormat());
+		if (shader)
+		{
+			rhi::VertexBufferInfo info;
+			info.stride = geometry.GetVertexStride();
+			info.offset = 0;
+			info.buffer = geometry.mVertexBuffer;
+			mContext->SetVertexBuffers(0, &info, 1);
+			mContext->SetIndexBuffer(geometry.mIndexBuffer, 0, rhi::IndexFormat::Int16);
+			mContext->SetShaderProgram(shader->GetShaderProgram());
+			UpdateSceneConstBuffer();
+			mContext->SetVertexShaderConstantBuffers(0, &mSceneConstBuffer, 1);
+			SetBlendMode(pass->BlendMode);
+			BindPassConstants(*shader, *pass, drawCall.FirstPass + i);
 
-			if (pass->GetTextureCount() > 0)
+			auto textureCount = static_cast<unsigned int>(pass->Textures.size());
+			if (textureCount > 0)
 			{
-				if (mTextures.size() < pass->GetTextureCount())
+				if (mTextures.size() < textureCount)
 				{
-					mTextures.resize(pass->GetTextureCount());
-					mTextureSamplers.resize(pass->GetTextureCount());
+					mTextures.resize(textureCount);
+					mTextureSamplers.resize(textureCount);
 				}
-				for (unsigned int t = 0; t < pass->GetTextureCount(); t++)
+				for (unsigned int t = 0; t < textureCount; t++)
 				{
-					auto timpl = reinterpret_cast<::Texture*>(pass->GetTextureByIndex(t));
-					if (timpl != nullptr)
+					if (pass->TargetInputs[t] != FramePacket::InvalidTarget)
 					{
-						mTextures[t] = mTexPool.GetTexture(timpl->GetResourceName());
+						auto slot = packet.GetTargetSlot(pass->TargetInputs[t]);
+						auto renderTarget = (slot != nullptr) ? GetPooledTarget(slot->PhysicalIndex, slot->Scale) : nullptr;
+						mTextures[t] = (renderTarget != nullptr)
+							? renderTarget->GetColorBufferByIndex(0)
+							: mTexPool.GetDefaultTexture();
+					}
+					else if (!pass->Textures[t].empty())
+					{
+						mTextures[t] = mTexPool.GetTexture(pass->Textures[t]);
 					}
 					else
 					{
 						mTextures[t] = mTexPool.GetDefaultTexture();
 					}
-					mTextureSamplers[t] = nullptr;
+					mTextureSamplers[t] = GetSamplerState(pass->Samplers[t]);
 				}
 
-				mContext->SetTextures(0, &(mTextures[0]), pass->GetTextureCount());
-				mContext->SetTextureSampler(0, &(mTextureSamplers[0]), pass->GetTextureCount());
+				mContext->SetTextures(0, &(mTextures[0]), textureCount);
+
+				// most passes share the sampling states, skip binding them again.
+				if (mBoundSamplers.size() < textureCount)
+				{
+					mBoundSamplers.resize(textureCount, nullptr);
+				}
+				if (!std::equal(mTextureSamplers.begin(), mTextureSamplers.begin() + textureCount, mBoundSamplers.begin()))
+				{
+					std::copy(mTextureSamplers.begin(), mTextureSamplers.begin() + textureCount, mBoundSamplers.begin());
+					mContext->SetTextureSampler(0, &(mTextureSamplers[0]), textureCount);
+				}
 			}
 
-			mContext->DrawIndexed(rhi::Primitive::TriangleList, mesh.GetIndexCount(), 0, 0);
+			mContext->DrawIndexed(rhi::Primitive::TriangleList, drawCall.IndexCount, drawCall.StartIndex, drawCall.BaseVertex);
 		}
 	}
+}
+
+void RenderSystem::ApplyRenderTarget(rhi::RenderTarget* renderTarget)
+{
+	rhi::Viewport viewport = mViewport;
+	viewport.Size = cxx::float2(static_cast<float>(renderTarget->GetWidth()), static_cast<float>(renderTarget->GetHeight()));
+	mContext->SetRenderTarget(renderTarget);
+	mContext->SetViewport(viewport);
+	mAppliedViewport = viewport;
+
+	// scissor rects are in pixels of the back buffer.
+	mAppliedRT = renderTarget;
+	mContext->SetScissorRect((renderTarget == mBackBufferRT && mIsScissorEnabled) ? &mScissorRect : nullptr);
+}
 
-	mesh.Clear();
+rhi::RenderTarget* RenderSystem::GetPooledTarget(unsigned int physicalIndex, float scale)
+{
+	if (mTargetPool.size() <= physicalIndex)
+	{
+		mTargetPool.resize(physicalIndex + 1, nullptr);
+	}
+
+	auto width = static_cast<unsigned int>(GetWindowWidth() * scale);
+	auto height = static_cast<unsigned int>(GetWindowHeight() * scale);
+	width = (width > 0) ? width : 1;
+	height = (height > 0) ? height : 1;
+
+	auto& renderTarget = mTargetPool[physicalIndex];
+	if (renderTarget != nullptr && (renderTarget->GetWidth() != width || renderTarget->GetHeight() != height))
+	{
+		cxx::safe_release(renderTarget);
+	}
+
+	if (renderTarget == nullptr)
+	{
+		auto rtFormat = rhi::TextureFormat::BGRA;
+		renderTarget = mDevice->CreateRenderTarget(width, height, &rtFormat, 1, false);
+	}
+	return renderTarget;
+}
+
+rhi::TextureSampler* RenderSystem::GetSamplerState(const g2d::SamplerDesc& desc)
+{
+	unsigned int key = static_cast<unsigned int>(desc.Filter)
+		| (static_cast<unsigned int>(desc.AddressU) << 8)
+		| (static_cast<unsigned int>(desc.AddressV) << 16);
+
+	auto& sampler = mSamplerStates[key];
+	if (sampler == nullptr)
+	{
+		auto filter = (desc.Filter == g2d::TextureFilter::Point)
+			? rhi::SamplerFilter::MinMagMipPoint
+			: rhi::SamplerFilter::MinMagMipLinear;
+
+		auto address = [](g2d::TextureAddress a)
+		{
+			switch (a)
+			{
+			case g2d::TextureAddress::Repeat: return rhi::TextureAddress::Repeat;
+			case g2d::TextureAddress::Mirror: return rhi::TextureAddress::Mirror;
+			default: return rhi::TextureAddress::Clamp;
+			}
+		};
+		sampler = mDevice->CreateTextureSampler(filter, address(desc.AddressU), address(desc.AddressV));
+	}
+	return sampler;
+}
+
+bool RenderSystem::UploadPassConstants(const FramePacket& packet)
+{
+	unsigned int passCount = packet.GetPassCount();
+	mPassConstantRanges.assign(passCount, PassConstantRange());
+	mVersionPassIndices.clear();
+
+	// lay out all ranges first, so that the ring is mapped only once.
+	unsigned int totalLength = 0;
+	for (unsigned int i = 0; i < passCount; i++)
+	{
+		auto& pass = packet.GetPass(i);
+		if (pass.ConstantVersion == 0)
+			continue;
+
+		// same version, same constants.
+		auto it = mVersionPassIndices.find(pass.ConstantVersion);
+		if (it != mVersionPassIndices.end())
+		{
+			mPassConstantRanges[i] = mPassConstantRanges[it->second];
+			continue;
+		}
+		mVersionPassIndices[pass.ConstantVersion] = i;
+
+		auto& range = mPassConstantRanges[i];
+		if (!pass.VsConstants.empty())
+		{
+			range.VsOffset = totalLength;
+			range.VsLength = ConstantRing::Align(mShaderlib->GetVSConstantLength(pass.VsName));
+			totalLength += range.VsLength;
+		}
+		if (!pass.PsConstants.empty())
+		{
+			range.PsOffset = totalLength;
+			range.PsLength = ConstantRing::Align(mShaderlib->GetPSConstantLength(pass.PsName));
+			totalLength += range.PsLength;
+		}
+	}
+
+	if (totalLength == 0)
+		return true;
+
+	if (!mConstantRing.Begin(mDevice, mContext, totalLength))
+		return false;
+
+	for (auto& versionPass : mVersionPassIndices)
+	{
+		auto& pass = packet.GetPass(versionPass.second);
+		auto& range = mPassConstantRanges[versionPass.second];
+		if (range.VsLength > 0)
+		{
+			auto length = static_cast<unsigned int>(pass.VsConstants.size() * sizeof(cxx::float4));
+			mConstantRing.Write(range.VsOffset, &(pass.VsConstants[0]), (length > range.VsLength) ? range.VsLength : length, range.VsLength);
+		}
+		if (range.PsLength > 0)
+		{
+			auto length = static_cast<unsigned int>(pass.PsConstants.size() * sizeof(cxx::float4));
+			mConstantRing.Write(range.PsOffset, &(pass.PsConstants[0]), (length > range.PsLength) ? range.PsLength : length, range.PsLength);
+		}
+	}
+	mConstantRing.End(mContext);
+	return true;
+}
+
+void RenderSystem::BindPassConstants(Shader& shader, const FramePacket::PassSnapshot& pass, unsigned int passIndex)
+{
+	if (mUseConstantRing)
+	{
+		auto& range = mPassConstantRanges[passIndex];
+		if (range.VsLength > 0)
+		{
+			mContext->SetVertexShaderConstantBufferRange(1, mConstantRing.GetBuffer(), range.VsOffset, range.VsLength);
+		}
+		if (range.PsLength > 0)
+		{
+			mContext->SetPixelShaderConstantBufferRange(0, mConstantRing.GetBuffer(), range.PsOffset, range.PsLength);
+		}
+		return;
+	}
+
+	// buffers of shaders keep the constants uploaded last time.
+	auto vcb = shader.GetVertexConstBuffer();
+	if (vcb)
+	{
+		auto vsConstantLength = static_cast<unsigned int>(pass.VsConstants.size() * sizeof(cxx::float4));
+		auto length = (vcb->GetLength() > vsConstantLength)
+			? vsConstantLength
+			: vcb->GetLength();
+		if (length > 0)
+		{
+			auto& version = mUploadedConstantVersions[vcb];
+			if (version != pass.ConstantVersion)
+			{
+				UpdateConstBuffer(vcb, &(pass.VsConstants[0]), length);
+				version = pass.ConstantVersion;
+			}
+			mContext->SetVertexShaderConstantBuffers(1, &vcb, 1);
+		}
+	}
+
+	auto pcb = shader.GetPixelConstBuffer();
+	if (pcb)
+	{
+		auto psConstantLength = static_cast<unsigned int>(pass.PsConstants.size() * sizeof(cxx::float4));
+		auto length = (pcb->GetLength() > psConstantLength)
+			? psConstantLength
+			: pcb->GetLength();
+		if (length > 0)
+		{
+			auto& version = mUploadedConstantVersions[pcb];
+			if (version != pass.ConstantVersion)
+			{
+				UpdateConstBuffer(pcb, &(pass.PsConstants[0]), length);
+				version = pass.ConstantVersion;
+			}
+			mContext->SetPixelShaderConstantBuffers(0, &pcb, 1);
+		}
+	}
 }
 
 void RenderSystem::UpdateConstBuffer(rhi::Buffer* cbuffer, const void* data, unsigned int length)
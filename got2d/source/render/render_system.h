@@ -1,6 +1,14 @@
 #pragma once
+#include <atomic>
+#include <functional>
 #include <map>
+#include <string>
+#include <unordered_map>
 #include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 #include "g2drender.h"
 #include "../inner_utility.h"
 #include "../scope_utility.h"
@@ -10,8 +18,16 @@
 #include "../system_blackboard.h"
 #include "mesh.h"
 #include "texture.h"
+#include "frame_packet.h"
+#include "constant_ring.h"
+#include "compositor.h"
+#include "fill_counter.h"
+#include "sprite_table.h"
+#include "render_queue.h"
+#include "../scene/static_batch.h"
 
 class Pass;
+class Shader;
 class ShaderLib;
 
 class RenderSystem : public g2d::RenderSystem
@@ -24,6 +40,12 @@ public:
 
 	virtual void RenderMesh(unsigned int layer, g2d::Mesh*, g2d::Material*, const cxx::float2x3&) override;
 
+	virtual void RenderMesh(unsigned int layer, g2d::Mesh*, g2d::Material*, const cxx::float2x3&, const g2d::DrawParameters&) override;
+
+	virtual void SetSubmissionOrder(unsigned int order, unsigned int sequence = 0) override;
+
+	virtual unsigned int GetSubmissionOrder() const override;
+
 	virtual unsigned int GetWindowWidth() const override;
 
 	virtual unsigned int GetWindowHeight() const override;
@@ -32,8 +54,31 @@ public:
 
 	virtual cxx::point2d<int> ViewToScreen(const cxx::point2d<float> & view) const override;
 
+	virtual void SetCompactVertexFormat(bool compact) override;
+
+	virtual bool IsCompactVertexFormat() const override;
+
+	virtual unsigned int GetFrameFence() const override;
+
+	virtual bool IsFenceCompleted(unsigned int fence) const override;
+
+	virtual void WaitForFence(unsigned int fence) override;
+
+	virtual bool DeclareRenderTarget(const char* name, float scale, const cxx::color4f& clearColor, bool persistent) override;
+
+	virtual bool AddCompositePass(const char* output, const char** inputs, unsigned int inputCount, g2d::Material* material) override;
+
+	virtual void ClearCompositor() override;
+
+	virtual void SetFillStatisticsEnabled(bool enabled) override;
+
+	virtual bool IsFillStatisticsEnabled() const override;
+
+	virtual g2d::FillStatistics GetFillStatistics() const override;
+
 public:
-	bool Create(void* nativeWindow);
+	// frameLatency = 0 means executing frames in calling thread.
+	bool Create(void* nativeWindow, unsigned int frameLatency, const char* shaderCachePath, bool partialRedraw);
 
 	void Destroy();
 
@@ -43,11 +88,32 @@ public:
 
 	void Present();
 
-	void SetBlendMode(g2d::BlendMode blendMode);
-
 	void SetViewMatrix(const cxx::float2x3& viewMatrix);
 
-	const cxx::float4x4& GetProjectionMatrix();
+	// requests from now on are drawn into the target of the
+	// compositor, nullptr or undeclared names for the back buffer.
+	void BindCameraTarget(const char* name);
+
+	bool IsPersistentTarget(const char* name) const;
+
+	// false for nullptr and names not declared.
+	bool IsDeclaredTarget(const char* name) const { return mCompositor.FindTarget(name) != Compositor::InvalidIndex; }
+
+	bool HasCompositePasses() const { return mCompositor.GetPassCount() > 0; }
+
+	// the back buffer keeps contents between frames,
+	// only regions redrawn by scenes are updated.
+	bool IsPartialRedraw() const { return mIsPartialRedraw; }
+
+	// clear the region of the back buffer and clip drawing into
+	// it until EndRedraw, nullptr for the whole buffer. frames
+	// without redrawing are not presented in partial redraw.
+	void BeginRedraw(const rhi::Rect* region);
+
+	void EndRedraw();
+
+	// cached contents of persistent targets are lost if changed.
+	unsigned int GetCompositorVersion() const { return mCompositor.GetVersion(); }
 
 	rhi::Device* GetDevice() { return mDevice; }
 
@@ -55,13 +121,89 @@ public:
 
 	bool OnResize(unsigned int width, unsigned int height);
 
+	// RenderMesh requests will be captured by the batch
+	// instead of being queued until EndCapture.
+	void BeginCapture(StaticBatch* batch);
+
+	void EndCapture();
+
+	// only draws the geometry of components [firstComponent, endComponent).
+	void RenderStaticBatch(StaticBatch& batch, unsigned int cameraVisibleMask, unsigned int firstComponent, unsigned int endComponent);
+
+	// draw the whole geometry built by the caller in its local space, the
+	// caller keeps the pointer valid until requests are flushed.
+	void RenderRetained(unsigned int layer, g2d::Material* material, const std::shared_ptr<RetainedGeometry>& geometry, unsigned int indexCount, const cxx::float2x3& worldMatrix);
+
+	// format used for geometries uploaded from now on.
+	VertexFormat GetVertexFormat() const { return mVertexFormat; }
+
+	// material shared by name, created by the creator at the first time.
+	// reference count is increased, caller should release it.
+	g2d::Material* GetSharedMaterial(const std::string& name, const std::function<g2d::Material*()>& creator);
+
+	// unit quad centered at origin with white vertex color, owned by render system.
+	g2d::Mesh* GetQuadMesh();
+
+	SpriteTable& GetSpriteTable() { return mSpriteTable; }
+
+	// same as rendering the unit quad mesh, the sprite
+	// is read from the table when requests are flushed.
+	void RenderSprite(unsigned int layer, g2d::Material* material, const cxx::float2x3& worldMatrix, unsigned int sprite);
+
 public:
 	Texture* CreateTextureFromFile(const char* resPath);
 
 private:
 	bool CreateBlendModes();
 
-	void FlushBatch(Mesh& mesh, g2d::Material&);
+	bool CreateDepthStencilStates();
+
+	void SubmitPacket();
+
+	// target is the index in compositor.
+	void BindTarget(unsigned int target);
+
+	void RecordComposites();
+
+	void WaitForIdle();
+
+	void RenderThreadMain();
+
+	//functions below are called by the thread executing packets.
+	void ExecutePacket(const FramePacket& packet);
+
+	struct PendingDraw
+	{
+		unsigned int DrawIndex;
+		cxx::float2x3 ViewMatrix;
+	};
+
+	// execute consecutive drawcalls, opaque ones in the back
+	// buffer are reordered to be drawn front-to-back first.
+	void FlushPendingDraws(const FramePacket& packet);
+
+	// depth of the drawcall is given by the viewport, later drawcalls are nearer.
+	void ExecuteDraw(const FramePacket& packet, const PendingDraw& pendingDraw, bool useDepth);
+
+	void DrawGeometry(Geometry& geometry, const FramePacket& packet, const FramePacket::DrawCall& drawCall);
+
+	// write constants of all passes in the packet to the ring,
+	// return false if the ring can not be used.
+	bool UploadPassConstants(const FramePacket& packet);
+
+	void BindPassConstants(Shader& shader, const FramePacket::PassSnapshot& pass, unsigned int passIndex);
+
+	void SetBlendMode(g2d::BlendMode blendMode);
+
+	void ApplyRenderTarget(rhi::RenderTarget* renderTarget);
+
+	// created or resized on demand, nullptr if failed.
+	rhi::RenderTarget* GetPooledTarget(unsigned int physicalIndex, float scale);
+
+	// states are created at the first use and shared by all passes.
+	rhi::TextureSampler* GetSamplerState(const g2d::SamplerDesc& desc);
+
+	const cxx::float4x4& GetProjectionMatrix();
 
 	void UpdateConstBuffer(rhi::Buffer* cbuffer, const void* data, unsigned int length);
 
@@ -70,34 +212,98 @@ private:
 	rhi::Device*		mDevice = nullptr;
 	rhi::Context*		mContext = nullptr;
 	rhi::SwapChain*		mSwapChain = nullptr;
-	rhi::RenderTarget*	mRenderTarget = nullptr;
 	rhi::Buffer*		mSceneConstBuffer = nullptr;
 	rhi::RenderTarget*	mBackBufferRT = nullptr;
 
 	ShaderLib*	mShaderlib = nullptr;
 
+	struct PassConstantRange
+	{
+		unsigned int VsOffset = 0;
+		unsigned int VsLength = 0;
+		unsigned int PsOffset = 0;
+		unsigned int PsLength = 0;
+	};
+
+	//constants of the executing packet.
+	ConstantRing mConstantRing;
+	bool mUseConstantRing = false;
+	std::vector<PassConstantRange> mPassConstantRanges;
+	std::unordered_map<unsigned int, unsigned int> mVersionPassIndices;
+
+	//constant version in each shader buffer, used when ranges are not supported.
+	std::unordered_map<rhi::Buffer*, unsigned int> mUploadedConstantVersions;
+
 	rhi::Viewport mViewport;
 	std::map<g2d::BlendMode, rhi::BlendState*> mBlendModes;
 	std::vector<rhi::TextureSampler*> mTextureSamplers;
+	std::vector<rhi::TextureSampler*> mBoundSamplers;
+	std::unordered_map<unsigned int, rhi::TextureSampler*> mSamplerStates;
 	std::vector<rhi::Texture2D*> mTextures;
 
 	cxx::color4f mBkColor = cxx::color4f::blue();
 
-	//render request
-	struct RenderRequest {
-		RenderRequest(g2d::Mesh& inMesh, g2d::Material& inMaterial, const cxx::float2x3& inWorldMatrix)
-			: mesh(inMesh), material(inMaterial), worldMatrix(inWorldMatrix)
-		{	}
-		g2d::Mesh& mesh;
-		g2d::Material& material;
-		cxx::float2x3 worldMatrix = cxx::float2x3::identity();
-	};
+	//partial redraw
+	bool mIsPartialRedraw = false;
+	bool mIsRedrawn = false;
+	g2d::Material* mRedrawMaterial = nullptr;
+
+	//scissor of the back buffer, executing side.
+	rhi::RenderTarget* mAppliedRT = nullptr;
+	rhi::Viewport mAppliedViewport;
+	bool mIsScissorEnabled = false;
+	rhi::Rect mScissorRect;
+
+	//depth ordering of the back buffer, executing side.
+	rhi::DepthStencilState* mDepthDisabledState = nullptr;
+	rhi::DepthStencilState* mDepthTestState = nullptr;
+	rhi::DepthStencilState* mDepthWriteState = nullptr;
+	std::vector<PendingDraw> mPendingDraws;
+	cxx::float2x3 mExecutingViewMatrix = cxx::float2x3::identity();
+
+	//fill statistics, counted by the executing side.
+	std::atomic<bool> mIsFillStatisticsEnabled{ false };
+	bool mIsFillCounting = false;
+	FillCounter mFillCounter;
+	mutable std::mutex mFillStatisticsMutex;
+	g2d::FillStatistics mFillStatistics;
 
-	typedef std::vector<RenderRequest> RenderRequestList;
-	std::map<unsigned int, RenderRequestList*> mRenderRequests;
+	//render request
+	RenderQueue mRenderQueue;
 
 	Geometry mGeometry;
 	TexturePool mTexPool;
+	StaticBatch* mCaptureBatch = nullptr;
+
+	//compositor, recording side.
+	Compositor mCompositor;
+	unsigned int mCurrentTarget = FramePacket::InvalidTarget;
+	std::vector<bool> mWrittenTargets;
+	std::vector<FramePacket::TargetSlot> mTargetSlots;
+
+	//physical targets, executing side.
+	std::vector<rhi::RenderTarget*> mTargetPool;
+	VertexFormat mVertexFormat = VertexFormat::Standard;
+
+	//shared resources, components may be created in jobs.
+	std::mutex mSharedResourceMutex;
+	std::map<std::string, g2d::Material*> mSharedMaterials;
+	g2d::Mesh* mQuadMesh = nullptr;
+	SpriteTable mSpriteTable;
+
+	//frame packets
+	std::vector<FramePacket*> mPackets;
+	FramePacket* mRecordingPacket = nullptr;
+	unsigned int mSubmittedFence = 0;
+	unsigned int mCompletedFence = 0;
+
+	//render thread, all guarded by mPacketMutex.
+	std::thread mRenderThread;
+	mutable std::mutex mPacketMutex;
+	std::condition_variable mPendingCondition;
+	std::condition_variable mCompletedCondition;
+	std::deque<FramePacket*> mPendingPackets;
+	bool mIsRenderThreadExiting = false;
 	
 	cxx::float2x3 mMatrixView = cxx::float2x3::identity();
 	cxx::float4x4 mMatProj = cxx::float4x4::identity();
@@ -1,18 +1,28 @@
+#include <cstdio>
 #include "shader.h"
 #include "../system_blackboard.h"
 #include "render_system.h"
 
-bool Shader::Create(const std::string& vsCode, unsigned int vcbLength, const std::string& psCode, unsigned int pcbLength)
+namespace
 {
+	const char* const VSEntry = "VSMain";
+	const char* const PSEntry = "PSMain";
+}
+
+bool Shader::Create(const std::vector<uint8_t>& vsBytecode, unsigned int vcbLength, const std::vector<uint8_t>& psBytecode, unsigned int pcbLength, VertexFormat vertexFormat)
+{
+	bool isCompact = (vertexFormat == VertexFormat::Compact);
 	rhi::Semantic layouts[3] =
 	{
 		{ "POSITION", 0, 0, 0xFFFFFFFF, rhi::InputFormat::Float2, false, 0 },
-		{ "TEXCOORD", 0, 0, 0xFFFFFFFF, rhi::InputFormat::Float2, false, 0 },
-		{ "COLOR",    0, 0, 0xFFFFFFFF, rhi::InputFormat::Float4, false, 0 },
+		{ "TEXCOORD", 0, 0, 0xFFFFFFFF, isCompact ? rhi::InputFormat::UNorm16x2 : rhi::InputFormat::Float2, false, 0 },
+		{ "COLOR",    0, 0, 0xFFFFFFFF, isCompact ? rhi::InputFormat::UNorm8x4 : rhi::InputFormat::Float4, false, 0 },
 	};
 
-	rhi::VertexShader* vertexShader = GetRenderSystem().GetDevice()->CreateVertexShader(vsCode.c_str(), "VSMain", layouts, 3);
-	rhi::PixelShader* pixelShader = GetRenderSystem().GetDevice()->CreatePixelShader(psCode.c_str(), "PSMain");
+	rhi::VertexShader* vertexShader = GetRenderSystem().GetDevice()->CreateVertexShaderFromBytecode(
+		vsBytecode.data(), static_cast<unsigned int>(vsBytecode.size()), layouts, 3);
+	rhi::PixelShader* pixelShader = GetRenderSystem().GetDevice()->CreatePixelShaderFromBytecode(
+		psBytecode.data(), static_cast<unsigned int>(psBytecode.size()));
 
 	if (vertexShader == nullptr || pixelShader == nullptr)
 		return false;
@@ -206,17 +216,21 @@ ShaderLib::~ShaderLib()
 
 }
 
-std::string ShaderLib::GetEffectName(const std::string& vsName, const std::string& psName)
+std::string ShaderLib::GetEffectName(const std::string& vsName, const std::string& psName, VertexFormat vertexFormat)
 {
+	if (vertexFormat == VertexFormat::Compact)
+	{
+		return std::move(vsName + psName + ".compact");
+	}
 	return std::move(vsName + psName);
 }
 
-Shader* ShaderLib::GetShaderByName(const std::string& vsName, const std::string& psName)
+Shader* ShaderLib::GetShaderByName(const std::string& vsName, const std::string& psName, VertexFormat vertexFormat)
 {
-	std::string effectName = GetEffectName(vsName, psName);
+	std::string effectName = GetEffectName(vsName, psName, vertexFormat);
 	if (!mShaders.count(effectName))
 	{
-		if (!BuildShader(effectName, vsName, psName))
+		if (!BuildShader(effectName, vsName, psName, vertexFormat))
 		{
 			return nullptr;
 		}
@@ -224,17 +238,36 @@ Shader* ShaderLib::GetShaderByName(const std::string& vsName, const std::string&
 	return mShaders.at(effectName);
 }
 
-bool ShaderLib::BuildShader(const std::string& effectName, const std::string& vsName, const std::string& psName)
+unsigned int ShaderLib::GetVSConstantLength(const std::string& vsName)
+{
+	auto it = mVsSources.find(vsName);
+	return (it == mVsSources.end()) ? 0 : it->second->GetConstBufferLength();
+}
+
+unsigned int ShaderLib::GetPSConstantLength(const std::string& psName)
+{
+	auto it = mPsSources.find(psName);
+	return (it == mPsSources.end()) ? 0 : it->second->GetConstBufferLength();
+}
+
+bool ShaderLib::BuildShader(const std::string& effectName, const std::string& vsName, const std::string& psName, VertexFormat vertexFormat)
 {
 	auto vsData = mVsSources[vsName];
 	auto psData = mPsSources[psName];
 	if (vsData == nullptr || psData == nullptr)
 		return false;
 
+	rhi::Device* device = GetRenderSystem().GetDevice();
+	const std::vector<uint8_t>* vsBytecode = GetBytecode(device, vsData->GetCode(), rhi::ShaderStage::Vertex);
+	const std::vector<uint8_t>* psBytecode = GetBytecode(device, psData->GetCode(), rhi::ShaderStage::Pixel);
+	if (vsBytecode == nullptr || psBytecode == nullptr)
+		return false;
+
 	Shader* shader = new Shader();
 	if (shader->Create(
-		vsData->GetCode(), vsData->GetConstBufferLength(),
-		psData->GetCode(), psData->GetConstBufferLength()))
+		*vsBytecode, vsData->GetConstBufferLength(),
+		*psBytecode, psData->GetConstBufferLength(),
+		vertexFormat))
 	{
 		mShaders[effectName] = shader;
 		return true;
@@ -242,3 +275,57 @@ bool ShaderLib::BuildShader(const std::string& effectName, const std::string& vs
 	delete shader;
 	return false;
 }
+
+bool ShaderLib::CompileSources(rhi::Device* device)
+{
+	for (auto& vsd : mVsSources)
+	{
+		if (GetBytecode(device, vsd.second->GetCode(), rhi::ShaderStage::Vertex) == nullptr)
+			return false;
+	}
+
+	for (auto& psd : mPsSources)
+	{
+		if (GetBytecode(device, psd.second->GetCode(), rhi::ShaderStage::Pixel) == nullptr)
+			return false;
+	}
+	return true;
+}
+
+bool ShaderLib::WarmUp()
+{
+	const VertexFormat vertexFormats[] = { VertexFormat::Standard, VertexFormat::Compact };
+	bool succeeded = true;
+	for (auto& vsd : mVsSources)
+	{
+		for (auto& psd : mPsSources)
+		{
+			for (VertexFormat vertexFormat : vertexFormats)
+			{
+				if (GetShaderByName(vsd.first, psd.first, vertexFormat) == nullptr)
+				{
+					std::fprintf(stderr, "warming up shader %s failed.\n", GetEffectName(vsd.first, psd.first, vertexFormat).c_str());
+					succeeded = false;
+				}
+			}
+		}
+	}
+	return succeeded;
+}
+
+const std::vector<uint8_t>* ShaderLib::GetBytecode(rhi::Device* device, const char* source, rhi::ShaderStage stage)
+{
+	const char* entry = (stage == rhi::ShaderStage::Vertex) ? VSEntry : PSEntry;
+	uint64_t key = ShaderCache::GetSourceKey(source, entry, stage);
+	const std::vector<uint8_t>* bytecode = mCache.Find(key);
+	if (bytecode == nullptr)
+	{
+		std::vector<uint8_t> compiled;
+		if (!device->CompileShader(source, entry, stage, compiled))
+			return nullptr;
+
+		mCache.Add(key, std::move(compiled));
+		bytecode = mCache.Find(key);
+	}
+	return bytecode;
+}
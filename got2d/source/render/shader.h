@@ -3,6 +3,8 @@
 #include <vector>
 #include "g2drender.h"
 #include "../RHI/RHI.h"
+#include "mesh.h"
+#include "shader_cache.h"
 
 
 class VSData
@@ -32,7 +34,7 @@ public:
 class Shader
 {
 public:
-	bool Create(const std::string& vsCode, unsigned int vcbLength, const std::string& psCode, unsigned int pcbLength);
+	bool Create(const std::vector<uint8_t>& vsBytecode, unsigned int vcbLength, const std::vector<uint8_t>& psBytecode, unsigned int pcbLength, VertexFormat vertexFormat);
 
 	void Destroy();
 
@@ -55,14 +57,39 @@ public:
 
 	~ShaderLib();
 
-	Shader* GetShaderByName(const std::string& vsName, const std::string& psName);
+	// shaders of different vertex formats share the same code,
+	// only the input layouts are different.
+	Shader* GetShaderByName(const std::string& vsName, const std::string& psName, VertexFormat vertexFormat);
+
+	// shaders missing in the cache are compiled at runtime.
+	bool LoadCache(const std::string& filePath) { return mCache.Load(filePath); }
+
+	bool SaveCache(const std::string& filePath) const { return mCache.Save(filePath); }
+
+	// compile all sources into the cache without creating
+	// shaders, used by building the cache offline.
+	bool CompileSources(rhi::Device* device);
+
+	// create shaders of all sources and vertex formats, so that nothing
+	// is compiled in the middle of frames. failed ones are reported and
+	// skipped, they are built again when drawing with them.
+	bool WarmUp();
+
+	// declared length of constant buffers, 0 if the shader does not exist.
+	unsigned int GetVSConstantLength(const std::string& vsName);
+
+	unsigned int GetPSConstantLength(const std::string& psName);
 
 private:
-	bool BuildShader(const std::string& effectName, const std::string& vsName, const std::string& psName);
+	bool BuildShader(const std::string& effectName, const std::string& vsName, const std::string& psName, VertexFormat vertexFormat);
+
+	// return nullptr if it is not in the cache and failed to compile.
+	const std::vector<uint8_t>* GetBytecode(rhi::Device* device, const char* source, rhi::ShaderStage stage);
 
-	std::string GetEffectName(const std::string& vsName, const std::string& psName);
+	std::string GetEffectName(const std::string& vsName, const std::string& psName, VertexFormat vertexFormat);
 
 	std::map<std::string, VSData*> mVsSources;
 	std::map<std::string, PSData*> mPsSources;
 	std::map<std::string, Shader*> mShaders;
+	ShaderCache mCache;
 };
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include <cstdio>
+#include <cstring>
+#include "shader_cache.h"
+
+namespace
+{
+	constexpr uint32_t ShaderCacheMagic = 0x43443247;	// "G2DC"
+	constexpr uint32_t ShaderCacheVersion = 1;
+
+	// FNV-1a
+	constexpr uint64_t HashOffsetBasis = 0xCBF29CE484222325ull;
+	constexpr uint64_t HashPrime = 0x100000001B3ull;
+
+	uint64_t HashBytes(uint64_t hash, const void* data, size_t length)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < length; i++)
+		{
+			hash = (hash ^ bytes[i]) * HashPrime;
+		}
+		return hash;
+	}
+
+	template<typename T> bool ReadValue(std::FILE* file, T& value)
+	{
+		return std::fread(&value, sizeof(T), 1, file) == 1;
+	}
+
+	template<typename T> bool WriteValue(std::FILE* file, const T& value)
+	{
+		return std::fwrite(&value, sizeof(T), 1, file) == 1;
+	}
+}
+
+uint64_t ShaderCache::GetSourceKey(const char* source, const char* entry, rhi::ShaderStage stage)
+{
+	// terminators are hashed as separators.
+	uint64_t hash = HashOffsetBasis;
+	hash = HashBytes(hash, source, std::strlen(source) + 1);
+	hash = HashBytes(hash, entry, std::strlen(entry) + 1);
+
+	int stageValue = static_cast<int>(stage);
+	return HashBytes(hash, &stageValue, sizeof(stageValue));
+}
+
+bool ShaderCache::Load(const std::string& filePath)
+{
+	mBytecodes.clear();
+	std::FILE* file = std::fopen(filePath.c_str(), "rb");
+	if (file == nullptr)
+		return false;
+
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	uint32_t count = 0;
+	bool success = ReadValue(file, magic) && ReadValue(file, version) && ReadValue(file, count) &&
+		magic == ShaderCacheMagic && version == ShaderCacheVersion;
+
+	for (uint32_t i = 0; i < count && success; i++)
+	{
+		uint64_t key = 0;
+		uint32_t length = 0;
+		success = ReadValue(file, key) && ReadValue(file, length) && length > 0;
+		if (success)
+		{
+			std::vector<uint8_t> bytecode(length);
+			success = std::fread(bytecode.data(), 1, length, file) == length;
+			mBytecodes[key] = std::move(bytecode);
+		}
+	}
+	std::fclose(file);
+
+	if (!success)
+	{
+		mBytecodes.clear();
+	}
+	return success;
+}
+
+bool ShaderCache::Save(const std::string& filePath) const
+{
+	std::FILE* file = std::fopen(filePath.c_str(), "wb");
+	if (file == nullptr)
+		return false;
+
+	bool success = WriteValue(file, ShaderCacheMagic) &&
+		WriteValue(file, ShaderCacheVersion) &&
+		WriteValue(file, static_cast<uint32_t>(mBytecodes.size()));
+
+	for (auto& entry : mBytecodes)
+	{
+		if (!success)
+			break;
+
+		success = WriteValue(file, entry.first) &&
+			WriteValue(file, static_cast<uint32_t>(entry.second.size())) &&
+			std::fwrite(entry.second.data(), 1, entry.second.size(), file) == entry.second.size();
+	}
+	std::fclose(file);
+	return success;
+}
+
+const std::vector<uint8_t>* ShaderCache::Find(uint64_t key) const
+{
+	auto itFound = mBytecodes.find(key);
+	return (itFound != mBytecodes.end()) ? &(itFound->second) : nullptr;
+}
+
+void ShaderCache::Add(uint64_t key, std::vector<uint8_t>&& bytecode)
+{
+	mBytecodes[key] = std::move(bytecode);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../RHI/RHI.h"
+
+// compiled shaders keyed by the hash of source code, entry and stage.
+// the file is built offline by g2dshaderc, and consumed by all
+// backends, those without compiler only create shaders in it.
+class ShaderCache
+{
+public:
+	static uint64_t GetSourceKey(const char* source, const char* entry, rhi::ShaderStage stage);
+
+	// the cache is left empty if the file is broken or out of date.
+	bool Load(const std::string& filePath);
+
+	bool Save(const std::string& filePath) const;
+
+	const std::vector<uint8_t>* Find(uint64_t key) const;
+
+	void Add(uint64_t key, std::vector<uint8_t>&& bytecode);
+
+	unsigned int GetCount() const { return static_cast<unsigned int>(mBytecodes.size()); }
+
+private:
+	std::unordered_map<uint64_t, std::vector<uint8_t>> mBytecodes;
+};
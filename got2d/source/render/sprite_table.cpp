@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <new>
+#include "sprite_table.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define SPRITE_TABLE_SSE
+#endif
+
+SpriteTable::SpriteTable()
+	: mChunks(nullptr)
+{
+
+}
+
+SpriteTable::~SpriteTable()
+{
+	Chunk** chunks = mChunks.load();
+	for (unsigned int i = 0; i < mChunkCount; i++)
+	{
+		delete chunks[i];
+	}
+	mChunks = nullptr;
+	mChunkCount = 0;
+	mChunkCapacity = 0;
+	mDirectories.clear();
+	mFreeSprites.clear();
+}
+
+unsigned int SpriteTable::Alloc()
+{
+	unsigned int sprite = InvalidSprite;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mFreeSprites.empty())
+		{
+			if (mChunkCount == MaxChunkCount)
+				throw std::bad_alloc();
+
+			// readers may still hold the old directory, it is not released.
+			Chunk** chunks = mChunks.load(std::memory_order_relaxed);
+			if (mChunkCount == mChunkCapacity)
+			{
+				unsigned int capacity = (mChunkCapacity > 0) ? std::min(mChunkCapacity * 2, MaxChunkCount) : InitialChunkCapacity;
+				Chunk** directory = new Chunk*[capacity];
+				std::copy(chunks, chunks + mChunkCount, directory);
+				mDirectories.emplace_back(directory);
+				mChunks.store(directory, std::memory_order_release);
+				mChunkCapacity = capacity;
+				chunks = directory;
+			}
+			chunks[mChunkCount] = new Chunk();
+
+			// lower index first.
+			for (unsigned int i = ChunkSize; i > 0; i--)
+			{
+				mFreeSprites.push_back(mChunkCount * ChunkSize + i - 1);
+			}
+			mChunkCount++;
+		}
+		sprite = mFreeSprites.back();
+		mFreeSprites.pop_back();
+	}
+
+	SetSize(sprite, cxx::float2::one());
+	SetPivot(sprite, cxx::float2(0.5f, 0.5f));
+	SetTexcoordRect(sprite, cxx::float2::zero(), cxx::float2::one());
+	SetColor(sprite, g2d::DrawParameters().Tint);
+	return sprite;
+}
+
+void SpriteTable::Free(unsigned int sprite)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mFreeSprites.push_back(sprite);
+}
+
+void SpriteTable::SetTexcoordRect(unsigned int sprite, const cxx::float2& offset, const cxx::float2& scale)
+{
+	Chunk& chunk = GetChunk(sprite);
+	chunk.TexcoordOffsets[sprite % ChunkSize] = offset;
+	chunk.TexcoordScales[sprite % ChunkSize] = scale;
+}
+
+void SpriteTable::Expand(unsigned int sprite, const cxx::float2x3& worldMatrix, g2d::GeometryVertex* vertices) const
+{
+	const Chunk& chunk = GetChunk(sprite);
+	unsigned int i = sprite % ChunkSize;
+	const cxx::float2& size = chunk.Sizes[i];
+	const cxx::float2& pivot = chunk.Pivots[i];
+	const cxx::float2& uvOffset = chunk.TexcoordOffsets[i];
+	const cxx::float2& uvScale = chunk.TexcoordScales[i];
+
+	float left = -pivot.x * size.x;
+	float bottom = -pivot.y * size.y;
+	float right = left + size.x;
+	float top = bottom + size.y;
+
+	float uvLeft = uvOffset.x;
+	float uvRight = uvOffset.x + uvScale.x;
+	float uvTop = uvOffset.y;
+	float uvBottom = uvOffset.y + uvScale.y;
+
+#ifdef SPRITE_TABLE_SSE
+	// four corners are transformed at once, x and y in separated
+	// registers, then interleaved into positions of the vertices.
+	const cxx::float3& r0 = worldMatrix.r[0];
+	const cxx::float3& r1 = worldMatrix.r[1];
+	__m128 cornerX = _mm_setr_ps(left, right, right, left);
+	__m128 cornerY = _mm_setr_ps(bottom, bottom, top, top);
+	__m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(r0.x), cornerX), _mm_mul_ps(_mm_set1_ps(r0.y), cornerY)), _mm_set1_ps(r0.z));
+	__m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(r1.x), cornerX), _mm_mul_ps(_mm_set1_ps(r1.y), cornerY)), _mm_set1_ps(r1.z));
+	__m128 position01 = _mm_unpacklo_ps(x, y);
+	__m128 position23 = _mm_unpackhi_ps(x, y);
+	_mm_storel_pi(reinterpret_cast<__m64*>(&(vertices[0].Position)), position01);
+	_mm_storeh_pi(reinterpret_cast<__m64*>(&(vertices[1].Position)), position01);
+	_mm_storel_pi(reinterpret_cast<__m64*>(&(vertices[2].Position)), position23);
+	_mm_storeh_pi(reinterpret_cast<__m64*>(&(vertices[3].Position)), position23);
+
+	__m128 texcoord01 = _mm_setr_ps(uvLeft, uvBottom, uvRight, uvBottom);
+	__m128 texcoord23 = _mm_setr_ps(uvRight, uvTop, uvLeft, uvTop);
+	_mm_storel_pi(reinterpret_cast<__m64*>(&(vertices[0].Texcoord)), texcoord01);
+	_mm_storeh_pi(reinterpret_cast<__m64*>(&(vertices[1].Texcoord)), texcoord01);
+	_mm_storel_pi(reinterpret_cast<__m64*>(&(vertices[2].Texcoord)), texcoord23);
+	_mm_storeh_pi(reinterpret_cast<__m64*>(&(vertices[3].Texcoord)), texcoord23);
+
+	__m128 color = _mm_loadu_ps(chunk.Colors[i].value.v);
+	for (int v = 0; v < 4; v++)
+	{
+		_mm_storeu_ps(vertices[v].VertexColor.value.v, color);
+	}
+#else
+	// the matrix is affine, the fourth corner is
+	// given by the others without transforming.
+	auto p0 = transform(worldMatrix, cxx::point2d<float>(left, bottom));
+	auto p1 = transform(worldMatrix, cxx::point2d<float>(right, bottom));
+	auto p3 = transform(worldMatrix, cxx::point2d<float>(left, top));
+
+	vertices[0].Position = p0;
+	vertices[1].Position = p1;
+	vertices[2].Position = cxx::point2d<float>(p1.x + p3.x - p0.x, p1.y + p3.y - p0.y);
+	vertices[3].Position = p3;
+
+	vertices[0].Texcoord = cxx::point2d<float>(uvLeft, uvBottom);
+	vertices[1].Texcoord = cxx::point2d<float>(uvRight, uvBottom);
+	vertices[2].Texcoord = cxx::point2d<float>(uvRight, uvTop);
+	vertices[3].Texcoord = cxx::point2d<float>(uvLeft, uvTop);
+
+	for (int v = 0; v < 4; v++)
+	{
+		vertices[v].VertexColor = chunk.Colors[i];
+	}
+#endif
+}
+
+cxx::float2x3 SpriteTable::GetLocalMatrix(unsigned int sprite) const
+{
+	const cxx::float2& size = GetSize(sprite);
+	const cxx::float2& pivot = GetPivot(sprite);
+	cxx::point2d<float> position((0.5f - pivot.x) * size.x, (0.5f - pivot.y) * size.y);
+	return cxx::float2x3::trsp(position, cxx::radian<float>(0), size, cxx::float2::zero());
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "g2drender.h"
+
+/**
+*	Per-sprite data of quads in chunks of structure-of-arrays,
+*	48 bytes for each sprite. Sprites are expanded into four
+*	vertices when merging, without meshes and index lookups.
+*	Chunks never move, and directories of chunks replaced by
+*	larger ones are kept until destruction, so sprites can be
+*	read and written while others are being allocated. Alloc
+*	and Free are thread-safe, a sprite should be accessed by
+*	one thread.
+*/
+class SpriteTable
+{
+public:
+	constexpr static unsigned int InvalidSprite = 0xFFFFFFFF;
+
+	SpriteTable();
+
+	~SpriteTable();
+
+	// centered unit size, full texcoord and white color.
+	// throw std::bad_alloc if all sprite indices are used.
+	unsigned int Alloc();
+
+	void Free(unsigned int sprite);
+
+	// pivot is normalized in the size, (0.5, 0.5) for the center.
+	const cxx::float2& GetSize(unsigned int sprite) const { return GetChunk(sprite).Sizes[sprite % ChunkSize]; }
+
+	const cxx::float2& GetPivot(unsigned int sprite) const { return GetChunk(sprite).Pivots[sprite % ChunkSize]; }
+
+	const cxx::float2& GetTexcoordOffset(unsigned int sprite) const { return GetChunk(sprite).TexcoordOffsets[sprite % ChunkSize]; }
+
+	const cxx::float2& GetTexcoordScale(unsigned int sprite) const { return GetChunk(sprite).TexcoordScales[sprite % ChunkSize]; }
+
+	const cxx::color4f& GetColor(unsigned int sprite) const { return GetChunk(sprite).Colors[sprite % ChunkSize]; }
+
+	void SetSize(unsigned int sprite, const cxx::float2& size) { GetChunk(sprite).Sizes[sprite % ChunkSize] = size; }
+
+	void SetPivot(unsigned int sprite, const cxx::float2& pivot) { GetChunk(sprite).Pivots[sprite % ChunkSize] = pivot; }
+
+	void SetTexcoordRect(unsigned int sprite, const cxx::float2& offset, const cxx::float2& scale);
+
+	void SetColor(unsigned int sprite, const cxx::color4f& color) { GetChunk(sprite).Colors[sprite % ChunkSize] = color; }
+
+	// write the four corners of the sprite, in the order of RenderSystem::GetQuadMesh.
+	void Expand(unsigned int sprite, const cxx::float2x3& worldMatrix, g2d::GeometryVertex* vertices) const;
+
+	// matrix scaling the unit quad mesh to the sprite.
+	cxx::float2x3 GetLocalMatrix(unsigned int sprite) const;
+
+private:
+	constexpr static unsigned int ChunkSize = 256;
+	constexpr static unsigned int InitialChunkCapacity = 64;
+
+	// the last sprite index is kept for InvalidSprite.
+	constexpr static unsigned int MaxChunkCount = InvalidSprite / ChunkSize;
+
+	struct Chunk
+	{
+		cxx::float2 Sizes[ChunkSize];
+		cxx::float2 Pivots[ChunkSize];
+		cxx::float2 TexcoordOffsets[ChunkSize];
+		cxx::float2 TexcoordScales[ChunkSize];
+		cxx::color4f Colors[ChunkSize];
+	};
+
+	Chunk& GetChunk(unsigned int sprite) const { return *(mChunks.load(std::memory_order_acquire)[sprite / ChunkSize]); }
+
+	std::mutex mMutex;
+	std::atomic<Chunk**> mChunks;
+	unsigned int mChunkCount = 0;
+	unsigned int mChunkCapacity = 0;
+	std::vector<std::unique_ptr<Chunk*[]>> mDirectories;
+	std::vector<unsigned int> mFreeSprites;
+};
@@ -19,7 +19,7 @@ void Camera::OnPostUpdateTransformChanged()
 	cxx::radian<float> rotation = GetSceneNodeRotation();
 
 	mMatrixView = cxx::float2x3::trs_inversed(pos, rotation, scale);
-	mMatrixViewInverse = cxx::inversed(cxx::to_matrix3x3(mMatrixView));
+	mMatrixViewInverse = InverseAffine(mMatrixView);
 
 	cxx::float2 halfWindowSize(
 		GetRenderSystem().GetWindowWidth() * 0.5f,
@@ -35,6 +35,9 @@ void Camera::OnPostUpdateTransformChanged()
 		{-halfWindowSize.x, +halfWindowSize.y }
 	};
 
+	// moved, or the window is resized.
+	mIsCacheValid = false;
+
 	cxx::float2x2 rotateMatrix = cxx::float2x2::rotate(rotation);
 	mAABB.clear();
 	for (cxx::float2& point : p)
@@ -46,7 +49,7 @@ void Camera::OnPostUpdateTransformChanged()
 
 void Camera::Release()
 {
-	delete this;
+	GetPool().Destroy(this);
 }
 
 unsigned int Camera::GetIndex() const
@@ -86,6 +89,7 @@ int Camera::GetRenderingOrder() const
 void Camera::SetCameraVisibleMask(unsigned int mask)
 {
 	mCameraVisibleMask = mask;
+	mIsCacheValid = false;
 }
 
 unsigned int Camera::GetCameraVisibleMask() const
@@ -93,9 +97,26 @@ unsigned int Camera::GetCameraVisibleMask() const
 	return mCameraVisibleMask;
 }
 
+void Camera::SetRenderTarget(const char* name)
+{
+	mRenderTargetName = (name != nullptr) ? name : "";
+	mIsCacheValid = false;
+}
+
+void Camera::SetCached(bool cached)
+{
+	if (mIsCached != cached)
+	{
+		mScene->OnCameraCachedChanged(cached);
+	}
+	mIsCached = cached;
+	mIsCacheValid = false;
+}
+
 void Camera::SetActivity(bool activity)
 {
 	mIsActive = activity;
+	mIsCacheValid = false;
 }
 
 const cxx::float2x3 & Camera::GetViewMatrix() const
@@ -138,6 +159,12 @@ cxx::point2d<int> Camera::WorldToScreen(const cxx::point2d<float>& pos) const
 	return GetRenderSystem().ViewToScreen(viewPos);
 }
 
+g2d::ComponentPool<::Camera>& Camera::GetPool()
+{
+	static g2d::ComponentPool<::Camera> sPool;
+	return sPool;
+}
+
 Camera::Camera(::Scene* scene, unsigned int index)
 	: mScene(scene)
 	, mIndex(index)
@@ -151,21 +178,7 @@ void Camera::SetID(unsigned int index)
 
 g2d::Component* Camera::FindNearestComponent(const cxx::float2& worldPosition)
 {
-	auto itCur = mVisibleComponents.rbegin();
-	auto itEnd = mVisibleComponents.rend();
-	for (; itCur != itEnd; itCur++)
-	{
-		Component* component = *itCur;
-		if (!component->GetSceneNode()->IsRemoved())
-		{
-			cxx::point2d<float> localPos = component->GetSceneNode()->WorldToLocal(worldPosition);
-			if (component->GetLocalAABB().contains(localPos))
-			{
-				return component;
-			}
-		}
-	}
-	return nullptr;
+	return mScene->GetSpatialGraph().FindNearestComponent(this, worldPosition);
 }
 
 void Camera::OnRemoveSceneNode(::SceneNode* pNode)
@@ -179,6 +192,24 @@ void Camera::OnRemoveSceneNode(::SceneNode* pNode)
 	mVisibleComponents.erase(newEnd, oldEnd);
 }
 
+bool Camera::IsLastImageValid() const
+{
+	return mIsCacheValid && mCacheVersion == GetRenderSystem().GetCompositorVersion();
+}
+
+bool Camera::IsCacheValid(unsigned int dirtyLayerMask) const
+{
+	return mIsCached && IsLastImageValid()
+		&& !IsMatchCameraVisibleMask(dirtyLayerMask)
+		&& GetRenderSystem().IsPersistentTarget(GetRenderTargetName());
+}
+
+void Camera::ValidateCache()
+{
+	mIsCacheValid = true;
+	mCacheVersion = GetRenderSystem().GetCompositorVersion();
+}
+
 bool Camera::IsMatchCameraVisibleMask(unsigned int mask) const
 {
 	return (mCameraVisibleMask & mask) != 0;
@@ -1,10 +1,13 @@
 #pragma once
+#include <string>
 #include <vector>
 #include "g2dscene.h"
 #include "g2drender.h"
+#include "g2dpool.h"
 
 class Scene;
 class SceneNode;
+class StaticBatch;
 
 class Camera : public g2d::Camera
 {
@@ -12,6 +15,8 @@ class Camera : public g2d::Camera
 public:	//g2d::Component
 	virtual const cxx::aabb2d<float>& GetLocalAABB() const override;
 
+	virtual unsigned int GetSubscribedEvents() const override { return g2d::BroadcastEvent::None; }
+
 	virtual void OnPostUpdateTransformChanged() override;
 
 	virtual void Release() override;
@@ -37,6 +42,16 @@ public:	//g2d::camera
 
 	virtual const cxx::float2x3& GetViewMatrix() const override;
 
+	virtual void SetRenderTarget(const char* name) override;
+
+	virtual const char* GetRenderTargetName() const override { return mRenderTargetName.empty() ? nullptr : mRenderTargetName.c_str(); }
+
+	virtual void SetCached(bool cached) override;
+
+	virtual bool IsCached() const override { return mIsCached; }
+
+	virtual void Invalidate() override { mIsCacheValid = false; }
+
 	virtual bool TestVisible(const cxx::aabb2d<float>& bounding) const override;
 
 	virtual bool TestVisible(g2d::Component* component) const override;
@@ -48,6 +63,8 @@ public:	//g2d::camera
 	virtual cxx::point2d<int> WorldToScreen(const cxx::point2d<float> & pos) const override;
 
 public:
+	static g2d::ComponentPool<::Camera>& GetPool();
+
 	Camera(Scene* scene, unsigned int index);
 
 	void SetID(unsigned int index);
@@ -58,15 +75,32 @@ public:
 
 	std::vector<Component*> mVisibleComponents;
 
-private:
+	std::vector<StaticBatch*> mVisibleStaticBatches;
+
 	bool IsMatchCameraVisibleMask(unsigned int mask) const;
 
+	// false if the camera is changed since the last rendering.
+	bool IsLastImageValid() const;
+
+	// true if the target still keeps the image,
+	// layers in the mask have been changed if dirty.
+	bool IsCacheValid(unsigned int dirtyLayerMask) const;
+
+	// called after rendering, or skipping the camera.
+	void ValidateCache();
+
+private:
+
 	::Scene* mScene = nullptr;
 	unsigned int mIndex = 0;
 	unsigned int mCameraVisibleMask = g2d::DefaultCameraVisibkeMask;
 	int mRenderingOrder = 0;
 	bool mIsActive = true;
 	cxx::float2x3 mMatrixView;
-	cxx::float3x3 mMatrixViewInverse;
+	cxx::float2x3 mMatrixViewInverse;
 	cxx::aabb2d<float> mAABB;
+	std::string mRenderTargetName;
+	bool mIsCached = false;
+	bool mIsCacheValid = false;
+	unsigned int mCacheVersion = 0;
 };
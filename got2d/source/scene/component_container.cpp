@@ -249,22 +249,15 @@ void ComponentContainer::OnPostUpdateTransformChanged()
 	DestroyRemovedComponents();
 }
 
-void ComponentContainer::OnMessage(const g2d::Message & message)
+void ComponentContainer::OnUpdate(unsigned int deltaTime, bool scheduled)
 {
 	CacheComponentsForTraversal();
-	for (g2d::Component* c : mCacheComponentsForTraversal)
-	{
-		c->OnMessage(message);
-	}
-	DestroyRemovedComponents();
-}
-
-void ComponentContainer::OnUpdate(unsigned int deltaTime)
-{
-	CacheComponentsForTraversal();
-	for (g2d::Component* c : mCacheComponentsForTraversal)
+	if (!scheduled)
 	{
-		c->OnUpdate(deltaTime);
+		for (ComponentRecord& c : mCacheComponentsForUpdate)
+		{
+			c.ComponentPtr->OnUpdate(deltaTime);
+		}
 	}
 	DestroyRemovedComponents();
 }
@@ -509,46 +502,6 @@ void ComponentContainer::OnMDropTo(::SceneNode * dropped)
 	DestroyRemovedComponents();
 }
 
-void ComponentContainer::OnKeyPress(g2d::KeyCode key)
-{
-	CacheComponentsForTraversal();
-	for (g2d::Component* c : mCacheComponentsForTraversal)
-	{
-		c->OnKeyPress(key, GetMouse(), GetKeyboard());
-	}
-	DestroyRemovedComponents();
-}
-
-void ComponentContainer::OnKeyPressingBegin(g2d::KeyCode key)
-{
-	CacheComponentsForTraversal();
-	for (g2d::Component* c : mCacheComponentsForTraversal)
-	{
-		c->OnKeyPressingBegin(key, GetMouse(), GetKeyboard());
-	}
-	DestroyRemovedComponents();
-}
-
-void ComponentContainer::OnKeyPressing(g2d::KeyCode key)
-{
-	CacheComponentsForTraversal();
-	for (g2d::Component* c : mCacheComponentsForTraversal)
-	{
-		c->OnKeyPressing(key, GetMouse(), GetKeyboard());
-	}
-	DestroyRemovedComponents();
-}
-
-void ComponentContainer::OnKeyPressingEnd(g2d::KeyCode key)
-{
-	CacheComponentsForTraversal();
-	for (g2d::Component* c : mCacheComponentsForTraversal)
-	{
-		c->OnKeyPressingEnd(key, GetMouse(), GetKeyboard());
-	}
-	DestroyRemovedComponents();
-}
-
 
 void ComponentContainer::CacheComponentsForTraversal()
 {
@@ -557,9 +510,14 @@ void ComponentContainer::CacheComponentsForTraversal()
 		DestroyRemovedComponents();
 
 		mCacheComponentsForTraversal.clear();
+		mCacheComponentsForUpdate.clear();
 		for (ComponentRecord& c : mComponents)
 		{
 			mCacheComponentsForTraversal.push_back(c.ComponentPtr);
+			if (c.SubscribedEvents & g2d::BroadcastEvent::Update)
+			{
+				mCacheComponentsForUpdate.push_back(c);
+			}
 		}
 
 		mCachedComponentsChanged = false;
@@ -15,10 +15,12 @@ public:
 		ComponentRecord(g2d::Component* c, bool ar)
 			: ComponentPtr(c)
 			, AutoRelease(ar)
+			, SubscribedEvents(c->GetSubscribedEvents())
 		{ }
 
 		g2d::Component* ComponentPtr = nullptr;
 		bool AutoRelease = false;
+		unsigned int SubscribedEvents = g2d::BroadcastEvent::All;
 	};
 
 public:
@@ -66,9 +68,8 @@ public:
 
 	void OnPostUpdateTransformChanged();
 
-	void OnMessage(const g2d::Message& message);
-
-	void OnUpdate(unsigned int deltaTime);
+	// components have been updated by UpdateScheduler if scheduled.
+	void OnUpdate(unsigned int deltaTime, bool scheduled);
 
 	void OnCursorEnterFrom(::SceneNode* adjacency);
 
@@ -118,14 +119,6 @@ public:
 
 	void OnMDropTo(::SceneNode* dropped);
 
-	void OnKeyPress(g2d::KeyCode key);
-
-	void OnKeyPressingBegin(g2d::KeyCode key);
-
-	void OnKeyPressing(g2d::KeyCode key);
-
-	void OnKeyPressingEnd(g2d::KeyCode key);
-
 private:
 	void CacheComponentsForTraversal();
 
@@ -134,5 +127,6 @@ private:
 	std::vector<ComponentRecord> mComponents;
 	std::vector<ComponentRecord> mRemovedComponents;
 	std::vector<g2d::Component*> mCacheComponentsForTraversal;
+	std::vector<ComponentRecord> mCacheComponentsForUpdate;
 	bool mCachedComponentsChanged = true;
 };
\ No newline at end of file
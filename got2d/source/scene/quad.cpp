@@ -1,37 +1,87 @@
 #include "cxx_common.h"
 #include "../system_blackboard.h"
 #include "../render/render_system.h"
+#include "g2dserialize.h"
 #include "quad.h"
+#include "scene_node.h"
+#include "scene.h"
 
-Quad::Quad()
+namespace
 {
-	mMesh = g2d::Mesh::Create(4, 6);
-
-	unsigned int indices[] = { 0, 2, 1, 0, 3, 2 };
-	unsigned int* pIndexPtr = mMesh->GetRawIndices();
-
-	for (int i = 0; i < 6; i++)
+	class QuadSerializer : public g2d::ComponentSerializer
 	{
-		pIndexPtr[i] = indices[i];
-	}
-
-	g2d::GeometryVertex* vertices = mMesh->GetRawVertices();
-
-	vertices[0].Position = cxx::float2(-0.5f, -0.5f);
-	vertices[3].Position = cxx::float2(-0.5f, +0.5f);
-	vertices[2].Position = cxx::float2(+0.5f, +0.5f);
-	vertices[1].Position = cxx::float2(+0.5f, -0.5f);
-
-	vertices[0].Texcoord = cxx::float2(0, 1);
-	vertices[3].Texcoord = cxx::float2(0, 0);
-	vertices[2].Texcoord = cxx::float2(1, 0);
-	vertices[1].Texcoord = cxx::float2(1, 1);
+	public:
+		QuadSerializer() { g2d::RegisterComponentSerializer(this); }
+
+		~QuadSerializer() { g2d::UnregisterComponentSerializer(this); }
+
+		virtual const char* GetTypeName() const override { return "g2d.Quad"; }
+
+		virtual unsigned int GetComponentClassID() const override { return ::Quad::GetStaticClassID(); }
+
+		virtual void Save(g2d::Component* component, g2d::PayloadWriter& writer) override
+		{
+			::Quad* quad = static_cast<::Quad*>(component);
+			WriteFloat2(writer, quad->GetSize());
+			WriteFloat2(writer, quad->GetPivot());
+			WriteFloat2(writer, quad->GetTexcoordOffset());
+			WriteFloat2(writer, quad->GetTexcoordScale());
+			for (int c = 0; c < 4; c++)
+			{
+				writer.Write(quad->GetColor().value.v[c]);
+			}
+		}
+
+		virtual g2d::Component* Load(g2d::PayloadReader& reader) override
+		{
+			cxx::float2 size;
+			if (!ReadFloat2(reader, size))
+				return nullptr;
+
+			g2d::Quad* quad = g2d::Quad::Create()->SetSize(size);
+
+			// files saved before pivot, texcoord and color were added end here.
+			if (reader.GetRemainingLength() > 0)
+			{
+				cxx::float2 pivot, offset, scale;
+				cxx::color4f color;
+				if (!ReadFloat2(reader, pivot) || !ReadFloat2(reader, offset) || !ReadFloat2(reader, scale) ||
+					!reader.Read(color.value.v[0]) || !reader.Read(color.value.v[1]) ||
+					!reader.Read(color.value.v[2]) || !reader.Read(color.value.v[3]))
+				{
+					quad->Release();
+					return nullptr;
+				}
+				quad->SetPivot(pivot)->SetTexcoordRect(offset, scale)->SetColor(color);
+			}
+			return quad;
+		}
+
+	private:
+		static void WriteFloat2(g2d::PayloadWriter& writer, const cxx::float2& value)
+		{
+			writer.Write(value.x);
+			writer.Write(value.y);
+		}
+
+		static bool ReadFloat2(g2d::PayloadReader& reader, cxx::float2& value)
+		{
+			return reader.Read(value.x) && reader.Read(value.y);
+		}
+	} sQuadSerializer;
+}
 
-	vertices[0].VertexColor = cxx::color4f::random();
-	vertices[1].VertexColor = cxx::color4f::random();
-	vertices[2].VertexColor = cxx::color4f::random();
-	vertices[3].VertexColor = cxx::color4f::random();
+g2d::ComponentPool<::Quad>& Quad::GetPool()
+{
+	static g2d::ComponentPool<::Quad> sPool;
+	return sPool;
+}
 
+Quad::Quad()
+{
+	auto& renderSystem = GetRenderSystem();
+	mSprite = renderSystem.GetSpriteTable().Alloc();
+	renderSystem.GetSpriteTable().SetColor(mSprite, cxx::color4f::random());
 
 	mAABB.expand(cxx::float2(-0.5f, -0.5f));
 	mAABB.expand(cxx::float2(+0.5f, +0.5f));
@@ -39,50 +89,141 @@ Quad::Quad()
 	switch ((rand() % 3))
 	{
 	case 0:
-		mMaterial = g2d::Material::CreateSimpleColor();
+		mMaterial = renderSystem.GetSharedMaterial("quad.simple_color", [] { return g2d::Material::CreateSimpleColor(); });
 		break;
 	case 1:
-		mMaterial = g2d::Material::CreateSimpleTexture();
-		mMaterial->GetPassByIndex(0)->SetTexture(0, g2d::Texture::LoadFromFile((rand() % 2) ? "palette8_100x128.bmp" : "dxt1_100x128.dds"), true);
+	{
+		const char* texture = (rand() % 2) ? "palette8_100x128.bmp" : "dxt1_100x128.dds";
+		mMaterial = renderSystem.GetSharedMaterial(std::string("quad.simple_texture.") + texture, [texture]
+		{
+			g2d::Material* material = g2d::Material::CreateSimpleTexture();
+			material->GetPassByIndex(0)->SetTexture(0, g2d::Texture::LoadFromFile(texture), true);
+			return material;
+		});
 		break;
+	}
 	case 2:
-		mMaterial = g2d::Material::CreateColorTexture();
-		mMaterial->GetPassByIndex(0)->SetTexture(0, g2d::Texture::LoadFromFile((rand() % 2) ? "dxt5a_128x128.dds" : "rgba_128x128.png"), true);
+	{
+		const char* texture = (rand() % 2) ? "dxt5a_128x128.dds" : "rgba_128x128.png";
+		mMaterial = renderSystem.GetSharedMaterial(std::string("quad.color_texture.") + texture, [texture]
+		{
+			g2d::Material* material = g2d::Material::CreateColorTexture();
+			material->GetPassByIndex(0)->SetTexture(0, g2d::Texture::LoadFromFile(texture), true);
+			return material;
+		});
 		break;
 	}
+	}
 }
 
 Quad::~Quad()
 {
-	cxx::safe_release(mMesh);
+	GetRenderSystem().GetSpriteTable().Free(mSprite);
 	cxx::safe_release(mMaterial);
 }
 
 
 void Quad::OnRender()
 {
-	GetRenderSystem().RenderMesh(
+	// expanded from the sprite table, without meshes.
+	GetRenderSystem().RenderSprite(
 		g2d::RenderLayer::Default,
-			mMesh,
-			mMaterial,
-		GetSceneNode()->GetWorldMatrix()
+		mMaterial,
+		GetSceneNode()->GetWorldMatrix(),
+		mSprite
 	);
 }
 
 g2d::Quad* Quad::SetSize(const cxx::float2& size)
 {
-	g2d::GeometryVertex* vertices = mMesh->GetRawVertices();
-	vertices[0].Position = cxx::float2(-0.5f, -0.5f);
-	vertices[3].Position = cxx::float2(-0.5f, +0.5f);
-	vertices[2].Position = cxx::float2(+0.5f, +0.5f);
-	vertices[1].Position = cxx::float2(+0.5f, -0.5f);
+	AddDamage();
+	GetRenderSystem().GetSpriteTable().SetSize(mSprite, size);
+	UpdateAABB();
+	return this;
+}
+
+const cxx::float2& Quad::GetSize() const
+{
+	return GetRenderSystem().GetSpriteTable().GetSize(mSprite);
+}
+
+g2d::Quad* Quad::SetPivot(const cxx::float2& pivot)
+{
+	AddDamage();
+	GetRenderSystem().GetSpriteTable().SetPivot(mSprite, pivot);
+	UpdateAABB();
+	return this;
+}
+
+const cxx::float2& Quad::GetPivot() const
+{
+	return GetRenderSystem().GetSpriteTable().GetPivot(mSprite);
+}
+
+g2d::Quad* Quad::SetTexcoordRect(const cxx::float2& offset, const cxx::float2& scale)
+{
+	AddDamage();
+	GetRenderSystem().GetSpriteTable().SetTexcoordRect(mSprite, offset, scale);
+	SetStaticBatchDirty();
+	return this;
+}
+
+const cxx::float2& Quad::GetTexcoordOffset() const
+{
+	return GetRenderSystem().GetSpriteTable().GetTexcoordOffset(mSprite);
+}
 
-	vertices[0].Position *= size;
-	vertices[3].Position *= size;
-	vertices[2].Position *= size;
-	vertices[1].Position *= size;
+const cxx::float2& Quad::GetTexcoordScale() const
+{
+	return GetRenderSystem().GetSpriteTable().GetTexcoordScale(mSprite);
+}
 
-	mAABB.expand(cxx::float2(-0.5f, -0.5f) * size);
-	mAABB.expand(cxx::float2(+0.5f, +0.5f) * size);
+g2d::Quad* Quad::SetColor(const cxx::color4f& color)
+{
+	AddDamage();
+	GetRenderSystem().GetSpriteTable().SetColor(mSprite, color);
+	SetStaticBatchDirty();
 	return this;
+}
+
+const cxx::color4f& Quad::GetColor() const
+{
+	return GetRenderSystem().GetSpriteTable().GetColor(mSprite);
+}
+
+void Quad::AddDamage()
+{
+	if (GetSceneNode() != nullptr)
+	{
+		auto scene = reinterpret_cast<::Scene*>(GetSceneNode()->GetScene());
+		scene->SetLayerDirty(GetCameraVisibleMask());
+		scene->AddDamage(this);
+	}
+}
+
+void Quad::SetStaticBatchDirty()
+{
+	if (GetSceneNode() != nullptr && GetSceneNode()->IsStatic())
+	{
+		reinterpret_cast<::SceneNode*>(GetSceneNode())->SetStaticBatchDirty(this);
+	}
+}
+
+void Quad::UpdateAABB()
+{
+	auto& spriteTable = GetRenderSystem().GetSpriteTable();
+	const cxx::float2& size = spriteTable.GetSize(mSprite);
+	const cxx::float2& pivot = spriteTable.GetPivot(mSprite);
+
+	mAABB.clear();
+	mAABB.expand(cxx::float2(-pivot.x * size.x, -pivot.y * size.y));
+	mAABB.expand(cxx::float2((1.0f - pivot.x) * size.x, (1.0f - pivot.y) * size.y));
+	mAABBVersion++;
+
+	// relocate it in quad tree with the new bounding.
+	if (GetSceneNode() != nullptr)
+	{
+		_UpdateWorldAABB_Internal();
+		reinterpret_cast<::SceneNode*>(GetSceneNode())->RelocateComponent(this);
+	}
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include "g2dscene.h"
 #include "g2drender.h"
+#include "g2dpool.h"
 
 class Quad : public g2d::Quad
 {
@@ -8,22 +9,55 @@ class Quad : public g2d::Quad
 public:
 	virtual const cxx::aabb2d<float>& GetLocalAABB() const override { return mAABB; }
 
+	virtual unsigned int GetLocalAABBVersion() const override { return mAABBVersion; }
+
+	virtual unsigned int GetSubscribedEvents() const override { return g2d::BroadcastEvent::None; }
+
 	virtual void OnRender() override;
 
-	virtual void Release() override { delete this; }
+	virtual void Release() override { GetPool().Destroy(this); }
 
 public:
 	virtual g2d::Quad* SetSize(const cxx::float2& size) override;
 
-	virtual const cxx::float2& GetSize() const override { return mQuadSize; }
+	virtual const cxx::float2& GetSize() const override;
+
+	virtual g2d::Quad* SetPivot(const cxx::float2& pivot) override;
+
+	virtual const cxx::float2& GetPivot() const override;
+
+	virtual g2d::Quad* SetTexcoordRect(const cxx::float2& offset, const cxx::float2& scale) override;
+
+	virtual const cxx::float2& GetTexcoordOffset() const override;
+
+	virtual const cxx::float2& GetTexcoordScale() const override;
+
+	virtual g2d::Quad* SetColor(const cxx::color4f& color) override;
+
+	virtual const cxx::color4f& GetColor() const override;
 
 public:
+	static g2d::ComponentPool<::Quad>& GetPool();
+
 	Quad();
 
 	~Quad();
 
-	g2d::Mesh*		mMesh = nullptr;
+private:
+	// redraw the current bounds, called before changing.
+	void AddDamage();
+
+	// static batches keep the expanded sprite, rebake them
+	// when sprite data changes without changing the bounds.
+	void SetStaticBatchDirty();
+
+	void UpdateAABB();
+
+	// shared by quads, see RenderSystem::GetSharedMaterial.
 	g2d::Material*	mMaterial = nullptr;
-	cxx::float2	mQuadSize;
+
+	// size, pivot, texcoord and color are in the sprite table.
+	unsigned int mSprite;
 	cxx::aabb2d<float> mAABB;
+	unsigned int mAABBVersion = 0;
 };
\ No newline at end of file
@@ -1,12 +1,16 @@
 #include <algorithm>
 #include "../system_blackboard.h"
 #include "../render/render_system.h"
+#include "../job_system.h"
 #include "scene.h"
 #include "scene_node.h"
 #include "camera.h"
+#include "static_batch.h"
 
 bool RenderingOrderSorter(g2d::Component* a, g2d::Component* b);
 
+bool StaticBatchSpanSorter(const StaticBatchSpan& a, const StaticBatchSpan& b);
+
 //*************************************************************
 // overrides
 //*************************************************************
@@ -17,7 +21,7 @@ g2d::SceneNode* Scene::GetRootNode()
 
 g2d::Camera* Scene::CreateAdditionalCameraNode()
 {
-	Camera* pCamera = new ::Camera(this, static_cast<unsigned int>(mCameraList.size()));
+	Camera* pCamera = ::Camera::GetPool().Create(this, static_cast<unsigned int>(mCameraList.size()));
 	mCameraList.push_back(pCamera);
 	mCameraOrderDirty = true;
 
@@ -43,31 +47,154 @@ unsigned int Scene::GetCameraCount() const
 
 void Scene::Render()
 {
-	GetRenderSystem().FlushRequests();
+	auto& renderSystem = GetRenderSystem();
+	renderSystem.FlushRequests();
 	ResortCameraOrder();
 	ResetRenderingOrder();
+	unsigned int dirtyLayerMask = mDirtyLayerMask.exchange(0, std::memory_order_relaxed);
+
+	// cameras of the back buffer only redraw the damaged region.
+	rhi::Rect redrawRegion;
+	bool isFullRedraw = true;
+	bool isRedrawing = false;
+	if (mIsTrackingDamage)
+	{
+		isRedrawing = CollectRedrawRegion(redrawRegion, isFullRedraw);
+		if (isRedrawing)
+		{
+			renderSystem.BeginRedraw(isFullRedraw ? nullptr : &redrawRegion);
+		}
+	}
+
+	std::vector<StaticBatchSpan> batchSpans;
 	for (auto camera : mCameraOrder)
 	{
 		if (!camera->IsActivity())
 			continue;
 
+		// the target still keeps the image of the last rendering.
+		if (camera->IsCacheValid(dirtyLayerMask))
+			continue;
+
+		cxx::aabb2d<float> redrawBounds;
+		bool isClipping = false;
+		if (mIsTrackingDamage && !renderSystem.IsDeclaredTarget(camera->GetRenderTargetName()))
+		{
+			if (!isRedrawing)
+				continue;
+
+			if (!isFullRedraw)
+			{
+				isClipping = true;
+				redrawBounds.expand(camera->ScreenToWorld({ redrawRegion.Left, redrawRegion.Top }));
+				redrawBounds.expand(camera->ScreenToWorld({ redrawRegion.Right, redrawRegion.Top }));
+				redrawBounds.expand(camera->ScreenToWorld({ redrawRegion.Left, redrawRegion.Bottom }));
+				redrawBounds.expand(camera->ScreenToWorld({ redrawRegion.Right, redrawRegion.Bottom }));
+			}
+		}
+
+		GetRenderSystem().BindCameraTarget(camera->GetRenderTargetName());
 		GetRenderSystem().SetViewMatrix(camera->GetViewMatrix());
+		mRenderingCamera = camera;
 
 		camera->mVisibleComponents.clear();
+		camera->mVisibleStaticBatches.clear();
 		mSpatial.RecursiveFindVisible(camera);
 
 		//sort visibleEntities by render order
-		std::sort(
-			camera->mVisibleComponents.begin(),
-			camera->mVisibleComponents.end(),
-			RenderingOrderSorter);
+		auto& components = camera->mVisibleComponents;
+		std::sort(components.begin(), components.end(), RenderingOrderSorter);
 
-		for (auto& component : camera->mVisibleComponents)
+		//split static batches where dynamic components are interleaved.
+		batchSpans.clear();
+		for (StaticBatch* batch : camera->mVisibleStaticBatches)
 		{
+			auto& batchComponents = batch->GetComponents();
+			auto itSplit = std::upper_bound(components.begin(), components.end(), batch->GetRenderingOrder(),
+				[](unsigned int order, g2d::Component* component) { return order < component->_GetRenderingOrder_Internal(); });
+
+			unsigned int first = 0;
+			for (; itSplit != components.end() && (*itSplit)->_GetRenderingOrder_Internal() < batch->GetLastRenderingOrder(); itSplit++)
+			{
+				unsigned int end = batch->FindComponent((*itSplit)->_GetRenderingOrder_Internal());
+				if (end > first)
+				{
+					batchSpans.push_back({ batchComponents[first]->_GetRenderingOrder_Internal(), batch, first, end });
+					first = end;
+				}
+			}
+			batchSpans.push_back({ batchComponents[first]->_GetRenderingOrder_Internal(), batch, first, batch->GetComponentCount() });
+		}
+		std::sort(batchSpans.begin(), batchSpans.end(), StaticBatchSpanSorter);
+
+		//merge static batches into component sequence.
+		auto cameraMask = camera->GetCameraVisibleMask();
+		auto itSpan = batchSpans.begin();
+		auto itSpanEnd = batchSpans.end();
+		for (auto& component : components)
+		{
+			for (; itSpan != itSpanEnd && itSpan->Order < component->_GetRenderingOrder_Internal(); itSpan++)
+			{
+				GetRenderSystem().RenderStaticBatch(*(itSpan->Batch), cameraMask, itSpan->FirstComponent, itSpan->EndComponent);
+			}
+
+			// pixels outside the region are kept.
+			if (isClipping && redrawBounds.hit_test(component->GetWorldAABB()) == cxx::intersection::none)
+				continue;
+
+			GetRenderSystem().SetSubmissionOrder(component->_GetRenderingOrder_Internal());
 			component->OnRender();
 		}
+		for (; itSpan != itSpanEnd; itSpan++)
+		{
+			GetRenderSystem().RenderStaticBatch(*(itSpan->Batch), cameraMask, itSpan->FirstComponent, itSpan->EndComponent);
+		}
 		GetRenderSystem().FlushRequests();
+		camera->ValidateCache();
+	}
+	mRenderingCamera = nullptr;
+
+	if (isRedrawing)
+	{
+		renderSystem.EndRedraw();
 	}
+	GetRenderSystem().BindCameraTarget(nullptr);
+}
+
+void Scene::InvalidateRegion(const cxx::aabb2d<float>& worldRegion)
+{
+	if (mIsTrackingDamage)
+	{
+		std::lock_guard<std::mutex> lock(mDamageMutex);
+		mDamages.push_back({ worldRegion, g2d::DefaultCameraVisibkeMask });
+	}
+}
+
+void Scene::BeginBatchEdit()
+{
+	ENSURE(!JobSystem::IsInJob());
+	if (mBatchEditDepth++ == 0)
+	{
+		mSpatial.BeginBulkAdd();
+	}
+}
+
+void Scene::EndBatchEdit()
+{
+	ENSURE(!JobSystem::IsInJob() && mBatchEditDepth > 0);
+	if (--mBatchEditDepth > 0)
+		return;
+
+	// world bounds are required by the spatial graph.
+	std::vector<::SceneNode*> deferredNodes;
+	deferredNodes.swap(mDeferredTransformNodes);
+	for (::SceneNode* node : deferredNodes)
+	{
+		node->FlushTransformNotify();
+	}
+
+	mSpatial.EndBulkAdd();
+	ResetRenderingOrder();
 }
 
 void Scene::Release()
@@ -85,6 +212,8 @@ Scene::Scene(float boundSize)
 	, mSpatial(boundSize)
 	, mMouseButtonState{ 0, 1, 2 }
 {
+	mIsTrackingDamage = GetRenderSystem().IsPartialRedraw();
+
 	//for main pCamera
 	CreateAdditionalCameraNode();
 
@@ -221,6 +350,7 @@ void Scene::ResetRenderingOrder()
 	{
 		mRenderingOrderDirtyNode->AdjustRenderingOrder();
 		mRenderingOrderDirtyNode = nullptr;
+		mSpatial.SetRenderingOrderChanged();
 	}
 }
 
@@ -244,13 +374,21 @@ void Scene::UnRegisterMouseEventReceiver()
 
 void Scene::Update(unsigned int elapsedTime, unsigned int deltaTime)
 {
+	ENSURE(!IsBatchEditing());
+	ResolveCursorMoving();
+
 	if (mHoverNode != nullptr && mCanTickHovering && GetMouse().IsFree())
 	{
 		mHoverNode->OnCursorHovering();
 		mCanTickHovering = false;
 	}
 
-	mRootNode->OnUpdate(deltaTime);
+	bool parallelUpdate = GetJobSystem().GetWorkerCount() > 0;
+	if (parallelUpdate)
+	{
+		mUpdateScheduler.Update(mRootNode, deltaTime);
+	}
+	mRootNode->OnUpdate(deltaTime, parallelUpdate);
 
 	//TODO: checking whether mHovering is deleted
 	mCanTickHovering = true;
@@ -258,11 +396,17 @@ void Scene::Update(unsigned int elapsedTime, unsigned int deltaTime)
 
 void Scene::OnMessage(const g2d::Message& message, unsigned int currentTimeStamp)
 {
-	mRootNode->OnMessage(message);
+	DispatchEvent(SubscriberList::Message, [&](g2d::Component* component)
+	{
+		component->OnMessage(message);
+	});
 }
 
 void Scene::SetRenderingOrderDirty(::SceneNode* parent)
 {
+	// nodes or components are added or reordered.
+	mSubscribersDirty = true;
+
 	if (mRenderingOrderDirtyNode == nullptr)
 	{
 		mRenderingOrderDirtyNode = parent;
@@ -273,6 +417,88 @@ void Scene::SetRenderingOrderDirty(::SceneNode* parent)
 	}
 }
 
+void Scene::AddDamage(g2d::Component* component)
+{
+	if (!mIsTrackingDamage || !component->GetLocalAABB().is_valid())
+		return;
+
+	cxx::aabb2d<float> bounds = component->GetWorldAABB();
+	unsigned int cameraMask = component->GetCameraVisibleMask();
+
+	std::lock_guard<std::mutex> lock(mDamageMutex);
+	mDamages.push_back({ bounds, cameraMask });
+}
+
+bool Scene::CollectRedrawRegion(rhi::Rect& region, bool& isFullRedraw)
+{
+	auto& renderSystem = GetRenderSystem();
+	{
+		std::lock_guard<std::mutex> lock(mDamageMutex);
+		mCollectingDamages.swap(mDamages);
+	}
+
+	// composited images are drawn over the whole buffer.
+	isFullRedraw = mIsFullRedraw || renderSystem.HasCompositePasses();
+	mIsFullRedraw = false;
+
+	int windowWidth = static_cast<int>(renderSystem.GetWindowWidth());
+	int windowHeight = static_cast<int>(renderSystem.GetWindowHeight());
+	region.Left = windowWidth;
+	region.Top = windowHeight;
+	region.Right = 0;
+	region.Bottom = 0;
+	for (auto camera : mCameraOrder)
+	{
+		if (renderSystem.IsDeclaredTarget(camera->GetRenderTargetName()))
+			continue;
+
+		// moved, resized, invalidated, or its activity is changed.
+		if (!camera->IsLastImageValid())
+		{
+			isFullRedraw = true;
+			camera->ValidateCache();
+		}
+
+		if (isFullRedraw || !camera->IsActivity())
+			continue;
+
+		for (const Damage& damage : mCollectingDamages)
+		{
+			if (!camera->IsMatchCameraVisibleMask(damage.CameraMask) || !camera->TestVisible(damage.Bounds))
+				continue;
+
+			cxx::float2 center = damage.Bounds.center();
+			cxx::float2 extend = damage.Bounds.extend();
+			cxx::float2 corners[4] =
+			{
+				{ center.x - extend.x, center.y - extend.y },
+				{ center.x + extend.x, center.y - extend.y },
+				{ center.x - extend.x, center.y + extend.y },
+				{ center.x + extend.x, center.y + extend.y },
+			};
+			for (const cxx::float2& corner : corners)
+			{
+				cxx::point2d<int> p = camera->WorldToScreen(cxx::point2d<float>(corner));
+				region.Left = std::min(region.Left, p.x);
+				region.Top = std::min(region.Top, p.y);
+				region.Right = std::max(region.Right, p.x);
+				region.Bottom = std::max(region.Bottom, p.y);
+			}
+		}
+	}
+	mCollectingDamages.clear();
+
+	if (isFullRedraw)
+		return true;
+
+	// one more pixel for edges truncated to integers.
+	region.Left = std::max(region.Left - 1, 0);
+	region.Top = std::max(region.Top - 1, 0);
+	region.Right = std::min(region.Right + 2, windowWidth);
+	region.Bottom = std::min(region.Bottom + 2, windowHeight);
+	return region.Left < region.Right && region.Top < region.Bottom;
+}
+
 void Scene::OnResize()
 {
 	for (auto& camera : mCameraList)
@@ -292,6 +518,8 @@ void Scene::AdjustRenderingOrder()
 
 void Scene::OnRemoveSceneNode(::SceneNode* node)
 {
+	mSubscribersDirty = true;
+
 	if (node == mHoverNode)
 	{
 		mHoverNode = nullptr;
@@ -310,26 +538,83 @@ void Scene::OnRemoveSceneNode(::SceneNode* node)
 
 void Scene::OnKeyPress(g2d::KeyCode key)
 {
-	mRootNode->OnKeyPress(key);
+	DispatchEvent(SubscriberList::KeyPress, [&](g2d::Component* component)
+	{
+		component->OnKeyPress(key, GetMouse(), GetKeyboard());
+	});
 }
 
 void Scene::OnKeyPressingBegin(g2d::KeyCode key)
 {
-	mRootNode->OnKeyPressingBegin(key);
+	DispatchEvent(SubscriberList::KeyPressingBegin, [&](g2d::Component* component)
+	{
+		component->OnKeyPressingBegin(key, GetMouse(), GetKeyboard());
+	});
 }
 
 void Scene::OnKeyPressing(g2d::KeyCode key)
 {
-	mRootNode->OnKeyPressing(key);
+	DispatchEvent(SubscriberList::KeyPressing, [&](g2d::Component* component)
+	{
+		component->OnKeyPressing(key, GetMouse(), GetKeyboard());
+	});
 }
 
 void Scene::OnKeyPressingEnd(g2d::KeyCode key)
 {
-	mRootNode->OnKeyPressingEnd(key);
+	DispatchEvent(SubscriberList::KeyPressingEnd, [&](g2d::Component* component)
+	{
+		component->OnKeyPressingEnd(key, GetMouse(), GetKeyboard());
+	});
+}
+
+void Scene::RebuildSubscribers()
+{
+	for (auto& subscribers : mSubscribers)
+	{
+		subscribers.clear();
+	}
+	RecursiveCollectSubscribers(mRootNode);
+	mSubscribersDirty = false;
+}
+
+void Scene::RecursiveCollectSubscribers(g2d::SceneNode* node)
+{
+	for (unsigned int i = 0, n = node->GetComponentCount(); i < n; i++)
+	{
+		g2d::Component* component = node->GetComponentByIndex(i);
+		unsigned int events = component->GetSubscribedEvents();
+		if (events & g2d::BroadcastEvent::Message)
+		{
+			mSubscribers[SubscriberList::Message].push_back(component);
+		}
+		if (events & g2d::BroadcastEvent::KeyPress)
+		{
+			mSubscribers[SubscriberList::KeyPress].push_back(component);
+		}
+		if (events & g2d::BroadcastEvent::KeyPressingBegin)
+		{
+			mSubscribers[SubscriberList::KeyPressingBegin].push_back(component);
+		}
+		if (events & g2d::BroadcastEvent::KeyPressing)
+		{
+			mSubscribers[SubscriberList::KeyPressing].push_back(component);
+		}
+		if (events & g2d::BroadcastEvent::KeyPressingEnd)
+		{
+			mSubscribers[SubscriberList::KeyPressingEnd].push_back(component);
+		}
+	}
+
+	for (unsigned int i = 0, n = node->GetChildCount(); i < n; i++)
+	{
+		RecursiveCollectSubscribers(node->GetChildByIndex(i));
+	}
 }
 
 void Scene::OnMousePress(g2d::MouseButton button)
 {
+	ResolveCursorMoving();
 	if (mHoverNode != nullptr)
 	{
 		mHoverNode->OnClick(button);
@@ -347,6 +632,7 @@ void Scene::MouseButtonState::OnPressingBegin(::SceneNode* hitNode)
 
 void Scene::OnMousePressingBegin(g2d::MouseButton button)
 {
+	ResolveCursorMoving();
 	mMouseButtonState[(int)button].OnPressingBegin(mHoverNode);
 }
 
@@ -368,6 +654,7 @@ void Scene::MouseButtonState::OnPressing(::SceneNode* hitNode)
 
 void Scene::OnMousePressing(g2d::MouseButton button)
 {
+	ResolveCursorMoving();
 	mMouseButtonState[(int)button].OnPressing(mHoverNode);
 }
 
@@ -399,11 +686,13 @@ void Scene::MouseButtonState::OnRemoveSceneNode(::SceneNode* node)
 
 void Scene::OnMousePressingEnd(g2d::MouseButton button)
 {
+	ResolveCursorMoving();
 	mMouseButtonState[(int)button].OnPressingEnd(mHoverNode);
 }
 
 void Scene::OnMouseDoubleClick(g2d::MouseButton button)
 {
+	ResolveCursorMoving();
 	if (mHoverNode != nullptr)
 	{
 		mHoverNode->OnDoubleClick(button);
@@ -427,6 +716,15 @@ void Scene::MouseButtonState::OnMoving(::SceneNode* hitNode)
 
 void Scene::OnMouseMoving()
 {
+	mCursorMoved = true;
+}
+
+void Scene::ResolveCursorMoving()
+{
+	if (!mCursorMoved)
+		return;
+
+	mCursorMoved = false;
 	::SceneNode* hitNode = FindInteractiveObject(GetMouse().GetCursorPosition());
 	if (GetMouse().IsFree())
 	{
@@ -479,3 +777,8 @@ bool RenderingOrderSorter(g2d::Component* a, g2d::Component* b)
 {
 	return a->_GetRenderingOrder_Internal() < b->_GetRenderingOrder_Internal();
 }
+
+bool StaticBatchSpanSorter(const StaticBatchSpan& a, const StaticBatchSpan& b)
+{
+	return a.Order < b.Order;
+}
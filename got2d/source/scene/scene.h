@@ -1,8 +1,12 @@
 #pragma once
+#include <atomic>
+#include <mutex>
 #include <vector>
 #include "g2dscene.h"
+#include "../RHI/RHI.h"
 #include "../input/input.h"
 #include "spatial_graph.h"
+#include "update_scheduler.h"
 #include "cxx_scope.h"
 
 class SceneNode;
@@ -23,6 +27,12 @@ public:
 
 	virtual void Render() override;
 
+	virtual void InvalidateRegion(const cxx::aabb2d<float>& worldRegion) override;
+
+	virtual void BeginBatchEdit() override;
+
+	virtual void EndBatchEdit() override;
+
 	virtual void Release() override;
 
 public:
@@ -42,16 +52,69 @@ public:
 
 	SpatialGraph& GetSpatialGraph() { return mSpatial; }
 
+	UpdateScheduler& GetUpdateScheduler() { return mUpdateScheduler; }
+
 	void AdjustRenderingOrder();
 
 	void OnRemoveSceneNode(::SceneNode* node);
 
+	// subscriber lists will be rebuilt before next dispatching.
+	void SetSubscribersDirty() { mSubscribersDirty = true; }
+
+	bool IsBatchEditing() const { return mBatchEditDepth > 0; }
+
+	// contents seen by cameras matching the mask are changed,
+	// cached cameras of them will render again. thread-safe.
+	void SetLayerDirty(unsigned int cameraMask)
+	{
+		if (IsCachingLayers())
+		{
+			mDirtyLayerMask.fetch_or(cameraMask, std::memory_order_relaxed);
+		}
+	}
+
+	// true if any camera is cached, dirty layers are only tracked then.
+	bool IsCachingLayers() const { return mCachedCameraCount > 0; }
+
+	// called by cameras outside jobs, a camera turning cached invalidates itself.
+	void OnCameraCachedChanged(bool cached) { cached ? mCachedCameraCount++ : mCachedCameraCount--; }
+
+	// damaged regions are recorded only in partial redraw.
+	bool IsTrackingDamage() const { return mIsTrackingDamage; }
+
+	// world bounds of the component need redrawing. thread-safe.
+	void AddDamage(g2d::Component* component);
+
+	// camera whose visible components are rendering, nullptr outside Render.
+	::Camera* GetRenderingCamera() const { return mRenderingCamera; }
+
+	// the node will be notified at the end of batch editing.
+	void DeferTransformNotify(::SceneNode* node) { mDeferredTransformNodes.push_back(node); }
 
 private:
 	void ResortCameraOrder();
 
 	void ResetRenderingOrder();
 
+	void RebuildSubscribers();
+
+	void RecursiveCollectSubscribers(g2d::SceneNode* node);
+
+	template<typename TDispatcher> void DispatchEvent(unsigned int listIndex, TDispatcher dispatch)
+	{
+		if (mSubscribersDirty)
+		{
+			RebuildSubscribers();
+		}
+
+		// list may be rebuilt by nested dispatching, do not hold iterators.
+		auto& subscribers = mSubscribers[listIndex];
+		for (size_t i = 0; i < subscribers.size(); i++)
+		{
+			dispatch(subscribers[i]);
+		}
+	}
+
 	::SceneNode* FindInteractiveObject(const cxx::int2& cursorPos);
 
 	void RegisterKeyEventReceiver();
@@ -82,6 +145,10 @@ private:
 
 	void OnMouseMoving();
 
+	// picking is deferred until the hit node is needed,
+	// done once per frame if the cursor only moves.
+	void ResolveCursorMoving();
+
 	KeyEventReceiver mKeyPressReceiver;
 	KeyEventReceiver mKeyPressingBeginReceiver;
 	KeyEventReceiver mKeyPressingReceiver;
@@ -111,13 +178,51 @@ private:
 	::SceneNode* mRootNode;
 
 	SpatialGraph mSpatial;
+	UpdateScheduler mUpdateScheduler;
 	std::vector<::Camera*> mCameraList;
 	std::vector<::Camera*> mCameraOrder;
 	bool mCameraOrderDirty = true;
+	::Camera* mRenderingCamera = nullptr;
 
 	::SceneNode* mHoverNode = nullptr;
 	bool mCanTickHovering = false;
+	bool mCursorMoved = false;
 
 	::SceneNode* mRenderingOrderDirtyNode = nullptr;
 	unsigned int mRenderingOrderEnd = 1;
+
+	unsigned int mBatchEditDepth = 0;
+	std::atomic<unsigned int> mDirtyLayerMask{ g2d::DefaultCameraVisibkeMask };
+	unsigned int mCachedCameraCount = 0;
+	std::vector<::SceneNode*> mDeferredTransformNodes;
+
+	// screen region covering damages seen by cameras of the back buffer,
+	// return false if nothing needs redrawing.
+	bool CollectRedrawRegion(rhi::Rect& region, bool& isFullRedraw);
+
+	struct Damage
+	{
+		cxx::aabb2d<float> Bounds;
+		unsigned int CameraMask;
+	};
+	bool mIsTrackingDamage = false;
+	bool mIsFullRedraw = true;
+	std::mutex mDamageMutex;
+	std::vector<Damage> mDamages;
+	std::vector<Damage> mCollectingDamages;
+
+	// components receiving broadcasting events, in
+	// the order of depth-first traversal of the tree.
+	class SubscriberList
+	{
+	public:
+		constexpr static unsigned int Message = 0;
+		constexpr static unsigned int KeyPress = 1;
+		constexpr static unsigned int KeyPressingBegin = 2;
+		constexpr static unsigned int KeyPressing = 3;
+		constexpr static unsigned int KeyPressingEnd = 4;
+		constexpr static unsigned int Count = 5;
+	};
+	std::vector<g2d::Component*> mSubscribers[SubscriberList::Count];
+	bool mSubscribersDirty = true;
 };
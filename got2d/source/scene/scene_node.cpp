@@ -1,5 +1,6 @@
 #include "scene_node.h"
 #include "scene.h"
+#include "../job_system.h"
 #include "cxx_math/cxx_point.h"
 
 //*************************************************************
@@ -49,8 +50,14 @@ unsigned int SceneNode::GetChildCount() const
 g2d::SceneNode * SceneNode::CreateChild()
 {
 	::SceneNode* pChild = new SceneNode(mScene, this);
-	mChildrenNodes.Add(pChild);
-	mScene->SetRenderingOrderDirty(this);
+	if (JobSystem::IsInJob())
+	{
+		mScene->GetUpdateScheduler().Defer(UpdateScheduler::CommandType::AttachChild, this, pChild, nullptr, false);
+	}
+	else
+	{
+		AttachChild(pChild);
+	}
 	return pChild;
 }
 
@@ -61,6 +68,7 @@ void SceneNode::MoveToFront()
 	if (mParentNode->mChildrenNodes.Move(mChildIndex, mParentNode->mChildrenNodes.GetCount() - 1))
 	{
 		mScene->SetRenderingOrderDirty(mParentNode->mChildrenNodes.At(oldIndex));
+		InvalidateSubtree();
 	}
 }
 
@@ -69,6 +77,7 @@ void SceneNode::MoveToBack()
 	if (mParentNode->mChildrenNodes.Move(mChildIndex, 0))
 	{
 		mScene->SetRenderingOrderDirty(this);
+		InvalidateSubtree();
 	}
 }
 
@@ -77,6 +86,7 @@ void SceneNode::MovePrev()
 	if (mParentNode->mChildrenNodes.Move(mChildIndex, mChildIndex - 1))
 	{
 		mScene->SetRenderingOrderDirty(this);
+		InvalidateSubtree();
 	}
 }
 
@@ -86,17 +96,26 @@ void SceneNode::MoveNext()
 	if (mParentNode->mChildrenNodes.Move(mChildIndex, mChildIndex + 1))
 	{
 		mScene->SetRenderingOrderDirty(mParentNode->mChildrenNodes.At(oldIndex));
+		InvalidateSubtree();
 	}
 }
 
 bool SceneNode::AddComponent(g2d::Component* component, bool autoRelease)
 {
 	ENSURE(component != nullptr);
+	if (JobSystem::IsInJob())
+	{
+		mScene->GetUpdateScheduler().Defer(UpdateScheduler::CommandType::AddComponent, this, nullptr, component, autoRelease);
+		return true;
+	}
+
 	bool successed = mComponenList.Add(this, component, autoRelease);
 	if (successed)
 	{
 		mScene->GetSpatialGraph().Add(component);
 		mScene->SetRenderingOrderDirty(this);
+		mScene->SetLayerDirty(mCameraVisibleMask);
+		mScene->AddDamage(component);
 		return true;
 	}
 	else
@@ -108,9 +127,23 @@ bool SceneNode::AddComponent(g2d::Component* component, bool autoRelease)
 bool SceneNode::RemoveComponent(g2d::Component * component)
 {
 	ENSURE(component != nullptr);
+	if (JobSystem::IsInJob())
+	{
+		mScene->GetUpdateScheduler().Defer(UpdateScheduler::CommandType::RemoveComponent, this, nullptr, component, false);
+		return mComponenList.Exist(component);
+	}
+
+	// the component may be released by removing.
+	if (mScene->IsTrackingDamage() && mComponenList.Exist(component))
+	{
+		mScene->AddDamage(component);
+	}
+
 	if (mComponenList.Remove(component, false))
 	{
 		mScene->GetSpatialGraph().Remove(component);
+		mScene->SetSubscribersDirty();
+		mScene->SetLayerDirty(mCameraVisibleMask);
 		return true;
 	}
 	else
@@ -122,7 +155,24 @@ bool SceneNode::RemoveComponent(g2d::Component * component)
 bool SceneNode::RemoveComponentWithoutRelease(g2d::Component * component)
 {
 	ENSURE(component != nullptr);
-	return mComponenList.Remove(component, true);
+	if (JobSystem::IsInJob())
+	{
+		mScene->GetUpdateScheduler().Defer(UpdateScheduler::CommandType::RemoveComponentWithoutRelease, this, nullptr, component, false);
+		return mComponenList.Exist(component);
+	}
+
+	if (mScene->IsTrackingDamage() && mComponenList.Exist(component))
+	{
+		mScene->AddDamage(component);
+	}
+
+	if (mComponenList.Remove(component, true))
+	{
+		mScene->SetSubscribersDirty();
+		mScene->SetLayerDirty(mCameraVisibleMask);
+		return true;
+	}
+	return false;
 }
 
 bool SceneNode::HasComponent(g2d::Component* comp) const
@@ -179,7 +229,7 @@ g2d::SceneNode * SceneNode::SetWorldPosition(const cxx::point2d<float>& Position
 
 cxx::point2d<float> SceneNode::GetWorldPosition()
 {
-	return mTransform.GetPosition();
+	return mTransform.GetWorldPosition();
 }
 
 g2d::SceneNode * SceneNode::SetRightDirection(const cxx::nfloat2 & right)
@@ -277,7 +327,18 @@ cxx::radian<float> SceneNode::GetRotation() const
 
 void SceneNode::SetVisible(bool visible)
 {
-	mIsVisible = visible;
+	if (mIsVisible != visible)
+	{
+		mIsVisible = visible;
+		mScene->SetLayerDirty(mCameraVisibleMask);
+		AddDamage(false);
+
+		// static batches only contain visible nodes.
+		if (IsStatic())
+		{
+			AdjustSpatial();
+		}
+	}
 }
 
 bool SceneNode::IsVisible() const
@@ -301,7 +362,15 @@ bool SceneNode::IsStatic() const
 
 void SceneNode::SetCameraVisibleMask(unsigned int mask, bool recursive)
 {
+	// visible to cameras of both masks.
+	mScene->SetLayerDirty(mCameraVisibleMask | mask);
+	AddDamage(false);
 	mCameraVisibleMask = mask;
+	AddDamage(false);
+	if (IsStatic())
+	{
+		AdjustSpatial();
+	}
 	if (recursive)
 	{
 		mChildrenNodes.Traversal([&](::SceneNode* child)
@@ -327,22 +396,27 @@ bool SceneNode::IsRemoved() const {
 
 cxx::point2d<float> SceneNode::WorldToLocal(const cxx::point2d<float>& pos)
 {
-	cxx::float3x3 worldMatrixInv = inversed(to_matrix3x3(GetWorldMatrix()));
-	return transform(worldMatrixInv, pos);
+	return transform(mTransform.GetWorldMatrixInverse(), pos);
 }
 
 cxx::point2d<float> SceneNode::WorldToParent(const cxx::point2d<float>& pos)
 {
-	cxx::float3x3 worldMatrixInv = inversed(to_matrix3x3(mParentNode->GetWorldMatrix()));
-	return transform(worldMatrixInv, pos);
+	return transform(mParentNode->mTransform.GetWorldMatrixInverse(), pos);
 }
 
 void SceneNode::Release()
 {
+	if (JobSystem::IsInJob())
+	{
+		mScene->GetUpdateScheduler().Defer(UpdateScheduler::CommandType::ReleaseNode, this, nullptr, nullptr, false);
+		return;
+	}
+
 	/**
 	*	deleteing node will affect continuity of rendering order, but wont change the order,
 	*	so we do nothing when deleting nodes
 	*/
+	InvalidateSubtree();
 	mIsRemoved = true;
 	mParentNode->mChildrenNodes.Remove(this);
 	mScene->OnRemoveSceneNode(this);
@@ -353,7 +427,7 @@ void SceneNode::Release()
 SceneNode::SceneNode(::Scene* scene, ::SceneNode* parent)
 	: mScene(scene)
 	, mParentNode(parent)
-	, mTransform(parent == nullptr ? nullptr : parent->mTransform)
+	, mTransform(parent == nullptr ? nullptr : &(parent->mTransform))
 {
 
 }
@@ -419,9 +493,113 @@ void SceneNode::AdjustRenderingOrder()
 	}
 }
 
+void SceneNode::AttachChild(::SceneNode* child)
+{
+	mChildrenNodes.Add(child);
+	mScene->SetRenderingOrderDirty(this);
+	child->InvalidateSubtree();
+}
+
+void SceneNode::RelocateComponent(g2d::Component* component)
+{
+	if (JobSystem::IsInJob())
+	{
+		mScene->GetUpdateScheduler().Defer(UpdateScheduler::CommandType::RelocateComponent, this, nullptr, component, false);
+	}
+	else
+	{
+		mScene->GetSpatialGraph().Add(component);
+		mScene->SetLayerDirty(mCameraVisibleMask);
+		mScene->AddDamage(component);
+	}
+}
+
+void SceneNode::SetStaticBatchDirty(g2d::Component* component)
+{
+	if (JobSystem::IsInJob())
+	{
+		mScene->GetUpdateScheduler().Defer(UpdateScheduler::CommandType::SetStaticBatchDirty, this, nullptr, component, false);
+	}
+	else
+	{
+		mScene->GetSpatialGraph().SetStaticBatchDirty(component);
+	}
+}
+
+::SceneNode* SceneNode::CreateChildForLoading()
+{
+	::SceneNode* child = new SceneNode(mScene, this);
+	mChildrenNodes.Add(child);
+	return child;
+}
+
+void SceneNode::AddComponentForLoading(g2d::Component* component, bool autoRelease)
+{
+	mComponenList.Add(this, component, autoRelease);
+}
+
+void SceneNode::SetTransformForLoading(const cxx::point2d<float>& position, const cxx::float2& pivot, const cxx::float2& scale, cxx::radian<float> rotation)
+{
+	mTransform.SetPosition(position);
+	mTransform.SetPivot(pivot);
+	mTransform.SetScale(scale);
+	mTransform.SetRotation(rotation);
+}
+
+void SceneNode::SetStateForLoading(bool visible, bool isStatic, unsigned int cameraVisibleMask)
+{
+	mIsVisible = visible;
+	mIsStatic = isStatic;
+	mCameraVisibleMask = cameraVisibleMask;
+}
+
+void SceneNode::FinishLoading()
+{
+	// loaded trees may be very deep, without recursion.
+	std::vector<::SceneNode*> pendingNodes(1, this);
+	while (!pendingNodes.empty())
+	{
+		::SceneNode* node = pendingNodes.back();
+		pendingNodes.pop_back();
+		node->AdjustSpatial();
+		node->mChildrenNodes.Traversal([&](::SceneNode* child)
+		{
+			pendingNodes.push_back(child);
+		});
+	}
+}
+
+void SceneNode::FlushTransformNotify()
+{
+	if (mTransformNotifyDeferred && !mIsRemoved)
+	{
+		NotifyChildrenTransformChanged();
+	}
+	mTransformNotifyDeferred = false;
+}
+
 void SceneNode::NotifyChildrenTransformChanged()
 {
+	if (mScene->IsBatchEditing())
+	{
+		if (!mTransformNotifyDeferred)
+		{
+			mTransformNotifyDeferred = true;
+			mScene->DeferTransformNotify(this);
+		}
+		return;
+	}
+
+	mTransformNotifyDeferred = false;
+	mScene->SetLayerDirty(mCameraVisibleMask);
 	mTransform.NotifyChildrenTransformChanged();
+	mComponenList.Traversal([&](g2d::Component* component)
+	{
+		// both the old and the new bounds need redrawing.
+		mScene->AddDamage(component);
+		component->_UpdateWorldAABB_Internal();
+		mScene->AddDamage(component);
+	});
 	mChildrenNodes.Traversal([](::SceneNode* child)
 	{
 		child->NotifyChildrenTransformChanged();
@@ -431,30 +609,65 @@ void SceneNode::NotifyChildrenTransformChanged()
 
 void SceneNode::AdjustSpatial()
 {
+	mScene->SetLayerDirty(mCameraVisibleMask);
 	mComponenList.Traversal([&](g2d::Component* component)
 	{
 		mScene->GetSpatialGraph().Add(component);
 	});
 }
 
-void SceneNode::OnUpdate(unsigned int deltaTime)
+void SceneNode::AddDamage(bool recursive)
 {
-	mComponenList.OnUpdate(deltaTime);
+	if (!mScene->IsTrackingDamage())
+		return;
+
+	mComponenList.Traversal([&](g2d::Component* component)
+	{
+		mScene->AddDamage(component);
+	});
+	if (recursive)
+	{
+		mChildrenNodes.Traversal([](::SceneNode* child)
+		{
+			child->AddDamage(true);
+		});
+	}
+}
+
+void SceneNode::InvalidateSubtree()
+{
+	if (mScene->IsCachingLayers())
+	{
+		mScene->SetLayerDirty(GetSubtreeCameraVisibleMask());
+	}
+	AddDamage(true);
+}
+
+unsigned int SceneNode::GetSubtreeCameraVisibleMask()
+{
+	unsigned int mask = mCameraVisibleMask;
+	mChildrenNodes.Traversal([&](::SceneNode* child)
+	{
+		mask |= child->GetSubtreeCameraVisibleMask();
+	});
+	return mask;
+}
+
+void SceneNode::OnUpdate(unsigned int deltaTime, bool scheduled)
+{
+	mComponenList.OnUpdate(deltaTime, scheduled);
 	if (mTranformChanged)
 	{
-		// static object need to adjust location in
+		// objects need to adjust location in
 		// quad tree, at this time, we may adjust it
 		// before visibility testing process, aka 
 		// rendering process
-		if (IsStatic())
-		{
-			AdjustSpatial();
-		}
+		AdjustSpatial();
 		mComponenList.OnPostUpdateTransformChanged();
 		mTranformChanged = false;
 	}
 
-	mChildrenNodes.OnUpdate(deltaTime);
+	mChildrenNodes.OnUpdate(deltaTime, scheduled);
 }
 
 void SceneNode::SetRenderingOrder(unsigned int & order)
@@ -475,12 +688,6 @@ void SceneNode::SetRenderingOrderOnly(unsigned int order)
 	mRenderingOrder = order;
 }
 
-void SceneNode::OnMessage(const g2d::Message& message)
-{
-	mComponenList.OnMessage(message);
-	mChildrenNodes.OnMessage(message);
-}
-
 void SceneNode::OnCursorEnterFrom(::SceneNode* adjacency)
 {
 	mComponenList.OnCursorEnterFrom(adjacency);
@@ -609,30 +816,6 @@ void SceneNode::OnDropTo(::SceneNode* dropped, g2d::MouseButton button)
 	}
 }
 
-void SceneNode::OnKeyPress(g2d::KeyCode key)
-{
-	mComponenList.OnKeyPress(key);
-	mChildrenNodes.OnKeyPress(key);
-}
-
-void SceneNode::OnKeyPressingBegin(g2d::KeyCode key)
-{
-	mComponenList.OnKeyPressingBegin(key);
-	mChildrenNodes.OnKeyPressingBegin(key);
-}
-
-void SceneNode::OnKeyPressing(g2d::KeyCode key)
-{
-	mComponenList.OnKeyPressing(key);
-	mChildrenNodes.OnKeyPressing(key);
-}
-
-void SceneNode::OnKeyPressingEnd(g2d::KeyCode key)
-{
-	mComponenList.OnKeyPressingEnd(key);
-	mChildrenNodes.OnKeyPressingEnd(key);
-}
-
 RootSceneNode::RootSceneNode(::Scene * scene)
 	: SceneNode(scene, nullptr)
 {
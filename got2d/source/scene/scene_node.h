@@ -123,7 +123,15 @@ public:
 
 	virtual void AdjustRenderingOrder();
 
-	void OnUpdate(unsigned int deltaTime);
+	void AttachChild(::SceneNode* child);
+
+	// call it when the local bounding of the component changed.
+	void RelocateComponent(g2d::Component* component);
+
+	// call it when render data of the static component changed.
+	void SetStaticBatchDirty(g2d::Component* component);
+
+	void OnUpdate(unsigned int deltaTime, bool scheduled);
 
 	void SetChildIndex(unsigned int index) { mChildIndex = index; }
 
@@ -135,8 +143,6 @@ public:
 
 	//bool ParentIsRoot() const { return mParentNode == mScene->GetRootNode(); }
 
-	void OnMessage(const g2d::Message& message);
-
 	void OnCursorEnterFrom(::SceneNode* adjacency);
 
 	void OnCursorHovering();
@@ -157,13 +163,21 @@ public:
 
 	void OnDropTo(::SceneNode* dropped, g2d::MouseButton button);
 
-	void OnKeyPress(g2d::KeyCode key);
+	// used by scene loader, nodes are built without
+	// updating rendering order and spatial graph,
+	// call FinishLoading on the top node at the end.
+	::SceneNode* CreateChildForLoading();
+
+	void AddComponentForLoading(g2d::Component* component, bool autoRelease);
 
-	void OnKeyPressingBegin(g2d::KeyCode key);
+	void SetTransformForLoading(const cxx::point2d<float>& position, const cxx::float2& pivot, const cxx::float2& scale, cxx::radian<float> rotation);
 
-	void OnKeyPressing(g2d::KeyCode key);
+	void SetStateForLoading(bool visible, bool isStatic, unsigned int cameraVisibleMask);
 
-	void OnKeyPressingEnd(g2d::KeyCode key);
+	void FinishLoading();
+
+	// notify the transform changes deferred by batch editing.
+	void FlushTransformNotify();
 
 private:
 
@@ -171,6 +185,16 @@ private:
 
 	void AdjustSpatial();
 
+	// masks of the node and all its descendants.
+	unsigned int GetSubtreeCameraVisibleMask();
+
+	// bounds of components need redrawing in partial redraw.
+	void AddDamage(bool recursive);
+
+	// layers and bounds of the node and all its descendants need redrawing,
+	// nothing is traversed without cached cameras and partial redraw.
+	void InvalidateSubtree();
+
 private:
 	::Scene* mScene;
 
@@ -184,6 +208,8 @@ private:
 
 	bool mIsRemoved = false;
 
+	bool mTransformNotifyDeferred = false;
+
 	unsigned int mChildIndex = 0;
 
 	unsigned int mRenderingOrder = 0xFFFFFFFF;	// make sure the order maxinum(error) at the beginning
@@ -113,7 +113,7 @@ bool SceneNodeContainer::Move(unsigned int from, unsigned int to)
 }
 
 
-void SceneNodeContainer::OnMessage(const g2d::Message & message)
+void SceneNodeContainer::OnUpdate(unsigned int deltaTime, bool scheduled)
 {
 	/**
 	*	Cache must not be process before dispatching
@@ -121,72 +121,7 @@ void SceneNodeContainer::OnMessage(const g2d::Message & message)
 	*/
 	for (::SceneNode* pChild : mChildrenNodesForTraversal)
 	{
-		pChild->OnMessage(message);
-	}
-	CacheChildrenForTraversal();
-}
-
-void SceneNodeContainer::OnUpdate(unsigned int deltaTime)
-{
-	/**
-	*	Cache must not be process before dispatching
-	*	or it may cause potential recursive dispatching
-	*/
-	for (::SceneNode* pChild : mChildrenNodesForTraversal)
-	{
-		pChild->OnUpdate(deltaTime);
-	}
-	CacheChildrenForTraversal();
-}
-
-void SceneNodeContainer::OnKeyPress(g2d::KeyCode key)
-{
-	/**
-	*	Cache must not be process before dispatching
-	*	or it may cause potential recursive dispatching
-	*/
-	for (::SceneNode* pChild : mChildrenNodesForTraversal)
-	{
-		pChild->OnKeyPress(key);
-	}
-	CacheChildrenForTraversal();
-}
-
-void SceneNodeContainer::OnKeyPressingBegin(g2d::KeyCode key)
-{
-	/**
-	*	Cache must not be process before dispatching
-	*	or it may cause potential recursive dispatching
-	*/
-	for (::SceneNode* pChild : mChildrenNodesForTraversal)
-	{
-		pChild->OnKeyPressingBegin(key);
-	}
-	CacheChildrenForTraversal();
-}
-
-void SceneNodeContainer::OnKeyPressing(g2d::KeyCode key)
-{
-	/**
-	*	Cache must not be process before dispatching
-	*	or it may cause potential recursive dispatching
-	*/
-	for (::SceneNode* pChild : mChildrenNodesForTraversal)
-	{
-		pChild->OnKeyPressing(key);
-	}
-	CacheChildrenForTraversal();
-}
-
-void SceneNodeContainer::OnKeyPressingEnd(g2d::KeyCode key)
-{
-	/**
-	*	Cache must not be process before dispatching
-	*	or it may cause potential recursive dispatching
-	*/
-	for (::SceneNode* pChild : mChildrenNodesForTraversal)
-	{
-		pChild->OnKeyPressingEnd(key);
+		pChild->OnUpdate(deltaTime, scheduled);
 	}
 	CacheChildrenForTraversal();
 }
@@ -48,17 +48,7 @@ public:
 	}
 
 public:
-	void OnMessage(const g2d::Message& message);
-
-	void OnUpdate(unsigned int deltaTime);
-
-	void OnKeyPress(g2d::KeyCode key);
-
-	void OnKeyPressingBegin(g2d::KeyCode key);
-
-	void OnKeyPressing(g2d::KeyCode key);
-
-	void OnKeyPressingEnd(g2d::KeyCode key);
+	void OnUpdate(unsigned int deltaTime, bool scheduled);
 
 private:
 	void CacheChildrenForTraversal();
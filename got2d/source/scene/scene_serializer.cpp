@@ -0,0 +1,307 @@
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include "../scope_utility.h"
+#include "../job_system.h"
+#include "scene_serializer.h"
+#include "scene_node.h"
+#include "scene.h"
+
+namespace
+{
+	constexpr uint32_t SceneFileMagic = 0x53443247;	// "G2DS"
+	constexpr uint32_t SceneFileVersion = 1;
+
+	class NodeFlag
+	{
+	public:
+		constexpr static uint8_t Visible = 1 << 0;
+		constexpr static uint8_t Static = 1 << 1;
+	};
+}
+
+void SceneSaver::SaveChildren(g2d::SceneNode* parent)
+{
+	// children are pushed reversely to pop the first one.
+	std::vector<g2d::SceneNode*> pendingNodes;
+	for (unsigned int i = parent->GetChildCount(); i > 0; i--)
+	{
+		pendingNodes.push_back(parent->GetChildByIndex(i - 1));
+	}
+	mRootCount += parent->GetChildCount();
+
+	while (!pendingNodes.empty())
+	{
+		g2d::SceneNode* node = pendingNodes.back();
+		pendingNodes.pop_back();
+		SaveNode(node);
+		for (unsigned int i = node->GetChildCount(); i > 0; i--)
+		{
+			pendingNodes.push_back(node->GetChildByIndex(i - 1));
+		}
+	}
+}
+
+bool SceneSaver::WriteFile(const char* filePath)
+{
+	std::vector<uint8_t> header;
+	g2d::PayloadWriter writer(header);
+	writer.Write(SceneFileMagic);
+	writer.Write(SceneFileVersion);
+	writer.Write(static_cast<uint32_t>(mTypes.size()));
+	for (g2d::ComponentSerializer* serializer : mTypes)
+	{
+		const char* typeName = serializer->GetTypeName();
+		uint16_t nameLength = static_cast<uint16_t>(std::strlen(typeName));
+		writer.Write(nameLength);
+		writer.Write(typeName, nameLength);
+	}
+	writer.Write(static_cast<uint32_t>(mRootCount));
+
+	std::FILE* file = std::fopen(filePath, "wb");
+	if (file == nullptr)
+		return false;
+
+	bool success = std::fwrite(header.data(), 1, header.size(), file) == header.size();
+	if (success && !mNodeData.empty())
+	{
+		success = std::fwrite(mNodeData.data(), 1, mNodeData.size(), file) == mNodeData.size();
+	}
+	std::fclose(file);
+	return success;
+}
+
+void SceneSaver::SaveNode(g2d::SceneNode* node)
+{
+	uint8_t flags = 0;
+	if (node->IsVisible()) flags |= NodeFlag::Visible;
+	if (node->IsStatic()) flags |= NodeFlag::Static;
+
+	Write(static_cast<uint32_t>(node->GetChildCount()));
+	Write(flags);
+	Write(static_cast<uint32_t>(node->GetCameraVisibleMask()));
+
+	cxx::point2d<float> position = node->GetPosition();
+	const cxx::float2& pivot = node->GetPivot();
+	const cxx::float2& scale = node->GetScale();
+	Write(position.x);
+	Write(position.y);
+	Write(pivot.x);
+	Write(pivot.y);
+	Write(scale.x);
+	Write(scale.y);
+	Write(node->GetRotation());
+
+	// count of components is patched after saving them.
+	size_t countOffset = mNodeData.size();
+	uint32_t componentCount = 0;
+	Write(componentCount);
+	for (unsigned int i = 0, n = node->GetComponentCount(); i < n; i++)
+	{
+		g2d::Component* component = node->GetComponentByIndex(i);
+		g2d::ComponentSerializer* serializer = g2d::FindComponentSerializer(component->GetClassID());
+		if (serializer == nullptr)
+			continue;
+
+		Write(static_cast<uint16_t>(GetTypeIndex(serializer)));
+		size_t lengthOffset = mNodeData.size();
+		Write(static_cast<uint32_t>(0));
+
+		g2d::PayloadWriter writer(mNodeData);
+		serializer->Save(component, writer);
+
+		uint32_t payloadLength = static_cast<uint32_t>(mNodeData.size() - lengthOffset - sizeof(uint32_t));
+		std::memcpy(mNodeData.data() + lengthOffset, &payloadLength, sizeof(uint32_t));
+		componentCount++;
+	}
+	std::memcpy(mNodeData.data() + countOffset, &componentCount, sizeof(uint32_t));
+}
+
+unsigned int SceneSaver::GetTypeIndex(g2d::ComponentSerializer* serializer)
+{
+	auto itFound = std::find(mTypes.begin(), mTypes.end(), serializer);
+	if (itFound != mTypes.end())
+	{
+		return static_cast<unsigned int>(itFound - mTypes.begin());
+	}
+	mTypes.push_back(serializer);
+	return static_cast<unsigned int>(mTypes.size() - 1);
+}
+
+SceneLoader::SceneLoader(const std::vector<uint8_t>& data)
+	: mData(data)
+{
+
+}
+
+bool SceneLoader::Load(::SceneNode* parent)
+{
+	ENSURE(!JobSystem::IsInJob());
+
+	unsigned int rootCount = 0;
+	if (!ReadHeader(rootCount))
+		return false;
+
+	unsigned int firstIndex = parent->GetChildCount();
+	bool success = LoadNodes(parent, rootCount);
+
+	// loaded nodes are the last children of the parent.
+	unsigned int lastIndex = parent->GetChildCount();
+	std::vector<::SceneNode*> loadedNodes;
+	for (unsigned int i = firstIndex; i < lastIndex; i++)
+	{
+		loadedNodes.push_back(reinterpret_cast<::SceneNode*>(parent->GetChildByIndex(i)));
+	}
+
+	// spatial graph is built in one pass at the end.
+	::Scene* scene = parent->GetSceneImpl();
+	scene->BeginBatchEdit();
+	for (::SceneNode* node : loadedNodes)
+	{
+		if (success)
+		{
+			node->FinishLoading();
+		}
+		else
+		{
+			node->Release();
+		}
+	}
+
+	if (success && !loadedNodes.empty())
+	{
+		scene->SetRenderingOrderDirty(parent);
+	}
+	scene->EndBatchEdit();
+	return success;
+}
+
+bool SceneLoader::ReadHeader(unsigned int& rootCount)
+{
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	uint32_t typeCount = 0;
+	if (!Read(magic) || !Read(version) || !Read(typeCount))
+		return false;
+
+	if (magic != SceneFileMagic || version != SceneFileVersion)
+		return false;
+
+	std::string typeName;
+	for (uint32_t i = 0; i < typeCount; i++)
+	{
+		uint16_t nameLength = 0;
+		if (!Read(nameLength))
+			return false;
+
+		typeName.resize(nameLength);
+		if (nameLength > 0 && !Read(&(typeName[0]), nameLength))
+			return false;
+
+		mTypes.push_back(g2d::FindComponentSerializer(typeName.c_str()));
+	}
+
+	uint32_t count = 0;
+	if (!Read(count))
+		return false;
+
+	rootCount = count;
+	return true;
+}
+
+bool SceneLoader::LoadNodes(::SceneNode* parent, unsigned int rootCount)
+{
+	// nodes still having children to load, the last one is the
+	// parent of the next node in the file.
+	struct PendingParent
+	{
+		::SceneNode* Node;
+		unsigned int RemainingChildren;
+	};
+
+	std::vector<PendingParent> pendingParents;
+	pendingParents.push_back({ parent, rootCount });
+	while (!pendingParents.empty())
+	{
+		PendingParent& pending = pendingParents.back();
+		if (pending.RemainingChildren == 0)
+		{
+			pendingParents.pop_back();
+			continue;
+		}
+		pending.RemainingChildren--;
+
+		::SceneNode* node = nullptr;
+		unsigned int childCount = 0;
+		if (!LoadNode(pending.Node, node, childCount))
+			return false;
+
+		if (childCount > 0)
+		{
+			pendingParents.push_back({ node, childCount });
+		}
+	}
+	return true;
+}
+
+bool SceneLoader::LoadNode(::SceneNode* parent, ::SceneNode*& node, unsigned int& childCount)
+{
+	uint32_t count = 0;
+	uint8_t flags = 0;
+	uint32_t cameraMask = 0;
+	cxx::point2d<float> position;
+	cxx::float2 pivot;
+	cxx::float2 scale;
+	cxx::radian<float> rotation(0);
+	if (!Read(count) || !Read(flags) || !Read(cameraMask) ||
+		!Read(position.x) || !Read(position.y) ||
+		!Read(pivot.x) || !Read(pivot.y) ||
+		!Read(scale.x) || !Read(scale.y) ||
+		!Read(rotation))
+	{
+		return false;
+	}
+
+	node = parent->CreateChildForLoading();
+	childCount = count;
+	node->SetTransformForLoading(position, pivot, scale, rotation);
+	node->SetStateForLoading((flags & NodeFlag::Visible) != 0, (flags & NodeFlag::Static) != 0, cameraMask);
+
+	uint32_t componentCount = 0;
+	if (!Read(componentCount))
+		return false;
+
+	for (uint32_t i = 0; i < componentCount; i++)
+	{
+		uint16_t typeIndex = 0;
+		uint32_t payloadLength = 0;
+		if (!Read(typeIndex) || !Read(payloadLength))
+			return false;
+
+		if (typeIndex >= mTypes.size() || mData.size() - mOffset < payloadLength)
+			return false;
+
+		g2d::ComponentSerializer* serializer = mTypes[typeIndex];
+		if (serializer != nullptr)
+		{
+			g2d::PayloadReader reader(mData.data() + mOffset, payloadLength);
+			g2d::Component* component = serializer->Load(reader);
+			if (component == nullptr)
+				return false;
+
+			node->AddComponentForLoading(component, true);
+		}
+		mOffset += payloadLength;
+	}
+	return true;
+}
+
+bool SceneLoader::Read(void* data, unsigned int length)
+{
+	if (mData.size() - mOffset < length)
+		return false;
+
+	std::memcpy(data, mData.data() + mOffset, length);
+	mOffset += length;
+	return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+#include "g2dserialize.h"
+
+class SceneNode;
+
+// binary scene file:
+//	header:		magic, version, count of types, names of types, count of root nodes.
+//	node:		count of children, flags, camera visible mask, transform,
+//				count of components, [type index, payload length, payload]...
+//				followed by children nodes in pre-order.
+class SceneSaver
+{
+public:
+	void SaveChildren(g2d::SceneNode* parent);
+
+	bool WriteFile(const char* filePath);
+
+private:
+	// children are not included, they are saved by SaveChildren
+	// in pre-order without recursion, trees may be very deep.
+	void SaveNode(g2d::SceneNode* node);
+
+	unsigned int GetTypeIndex(g2d::ComponentSerializer* serializer);
+
+	template<typename T> void Write(const T& value)
+	{
+		g2d::PayloadWriter(mNodeData).Write(value);
+	}
+
+	std::vector<g2d::ComponentSerializer*> mTypes;
+	std::vector<uint8_t> mNodeData;
+	unsigned int mRootCount = 0;
+};
+
+class SceneLoader
+{
+public:
+	SceneLoader(const std::vector<uint8_t>& data);
+
+	// all nodes are released if the file is broken.
+	bool Load(::SceneNode* parent);
+
+private:
+	bool ReadHeader(unsigned int& rootCount);
+
+	// pre-order without recursion, trees may be very deep.
+	bool LoadNodes(::SceneNode* parent, unsigned int rootCount);
+
+	// children are not included, loaded by LoadNodes.
+	bool LoadNode(::SceneNode* parent, ::SceneNode*& node, unsigned int& childCount);
+
+	bool Read(void* data, unsigned int length);
+
+	template<typename T> bool Read(T& value)
+	{
+		return Read(&value, sizeof(T));
+	}
+
+	const std::vector<uint8_t>& mData;
+	unsigned int mOffset = 0;
+
+	// nullptr for types without serializers, skipped.
+	std::vector<g2d::ComponentSerializer*> mTypes;
+};
@@ -1,8 +1,30 @@
 #include <algorithm>
 #include "g2dscene.h"
 #include "camera.h"
+#include "tilemap.h"
+#include "static_batch.h"
 #include "spatial_graph.h"
 
+namespace
+{
+	// insert a zero bit between each of the lower 16 bits.
+	inline uint32_t SpreadBits(uint32_t v)
+	{
+		v &= 0x0000FFFF;
+		v = (v | (v << 8)) & 0x00FF00FF;
+		v = (v | (v << 4)) & 0x0F0F0F0F;
+		v = (v | (v << 2)) & 0x33333333;
+		v = (v | (v << 1)) & 0x55555555;
+		return v;
+	}
+
+	// containing each other.
+	inline bool IsSameBounds(const cxx::aabb2d<float>& a, const cxx::aabb2d<float>& b)
+	{
+		return a.hit_test(b) == cxx::intersection::contain && b.hit_test(a) == cxx::intersection::contain;
+	}
+}
+
 QuadTreeNode::QuadTreeNode(QuadTreeNode* parent, const cxx::float2& center, float gridSize)
 	: mBounding(
 		cxx::float2(center.x - gridSize, center.y - gridSize),
@@ -22,6 +44,7 @@ QuadTreeNode::~QuadTreeNode()
 	{
 		cxx::safe_delete(pChildNode);
 	}
+	cxx::safe_delete(mStaticBatch);
 }
 
 inline bool Contains(const cxx::float2& center, float gridSize, const cxx::aabb2d<float>& nodeAABB)
@@ -55,7 +78,7 @@ QuadTreeNode* QuadTreeNode::RecursiveAdd(const cxx::aabb2d<float>& bounds, g2d::
 		{
 			if (mDirectionNodes[Direction::LeftTop] == nullptr)
 			{
-				mDirectionNodes[Direction::LeftTop] = new QuadTreeNode(this, center, halfExtend);
+				mDirectionNodes[Direction::LeftTop] = new QuadTreeNode(this, bounding.center(), halfExtend);
 			}
 			return mDirectionNodes[Direction::LeftTop]->RecursiveAdd(bounds, component);
 		}
@@ -66,7 +89,7 @@ QuadTreeNode* QuadTreeNode::RecursiveAdd(const cxx::aabb2d<float>& bounds, g2d::
 		{
 			if (mDirectionNodes[Direction::LeftDown] == nullptr)
 			{
-				mDirectionNodes[Direction::LeftDown] = new QuadTreeNode(this, center, halfExtend);
+				mDirectionNodes[Direction::LeftDown] = new QuadTreeNode(this, bounding.center(), halfExtend);
 			}
 			return  mDirectionNodes[Direction::LeftDown]->RecursiveAdd(bounds, component);
 		}
@@ -77,7 +100,7 @@ QuadTreeNode* QuadTreeNode::RecursiveAdd(const cxx::aabb2d<float>& bounds, g2d::
 		{
 			if (mDirectionNodes[Direction::RightTop] == nullptr)
 			{
-				mDirectionNodes[Direction::RightTop] = new QuadTreeNode(this, center, halfExtend);
+				mDirectionNodes[Direction::RightTop] = new QuadTreeNode(this, bounding.center(), halfExtend);
 			}
 			return mDirectionNodes[Direction::RightTop]->RecursiveAdd(bounds, component);
 		}
@@ -88,7 +111,7 @@ QuadTreeNode* QuadTreeNode::RecursiveAdd(const cxx::aabb2d<float>& bounds, g2d::
 		{
 			if (mDirectionNodes[Direction::RightDown] == nullptr)
 			{
-				mDirectionNodes[Direction::RightDown] = new QuadTreeNode(this, center, halfExtend);
+				mDirectionNodes[Direction::RightDown] = new QuadTreeNode(this, bounding.center(), halfExtend);
 			}
 			return mDirectionNodes[Direction::RightDown]->RecursiveAdd(bounds, component);
 		}
@@ -105,9 +128,45 @@ QuadTreeNode* QuadTreeNode::AddToList(g2d::Component* component)
 {
 	mIsEmpty = false;
 	mComponenList.push_back(component);
+
+	// tilemaps are never batched, they have baked chunks.
+	if (!component->GetSceneNode()->IsStatic() || g2d::Is<::Tilemap>(component))
+	{
+		mUnbatchedComponents.push_back(component);
+	}
+
+	if (component->GetSceneNode()->IsStatic())
+	{
+		SetStaticBatchDirty();
+	}
 	return this;
 }
 
+QuadTreeNode* QuadTreeNode::FindContainer(const cxx::aabb2d<float>& bounds)
+{
+	QuadTreeNode* container = this;
+	while (container->mParent != nullptr && container->mBounding.hit_test(bounds) != cxx::intersection::contain)
+	{
+		container = container->mParent;
+	}
+
+	// ancestors may be marked empty by removing.
+	for (QuadTreeNode* ancestor = container->mParent; ancestor != nullptr && ancestor->mIsEmpty; ancestor = ancestor->mParent)
+	{
+		ancestor->mIsEmpty = false;
+	}
+	return container;
+}
+
+void QuadTreeNode::SetStaticBatchDirty()
+{
+	if (mStaticBatch == nullptr)
+	{
+		mStaticBatch = new StaticBatch();
+	}
+	mStaticBatch->SetDirty();
+}
+
 void QuadTreeNode::UpdateEmptyMark()
 {
 	if (mComponenList.size() > 0)
@@ -140,15 +199,31 @@ void QuadTreeNode::Remove(g2d::Component* component)
 	auto newEnd = std::remove(mComponenList.begin(), oldEnd, component);
 	mComponenList.erase(newEnd, oldEnd);
 
+	// the static flag may be changed since adding.
+	oldEnd = mUnbatchedComponents.end();
+	newEnd = std::remove(mUnbatchedComponents.begin(), oldEnd, component);
+	mUnbatchedComponents.erase(newEnd, oldEnd);
+
+	//the component may be static before removing,
+	//dynamic ones moving through the node are ignored.
+	if (mStaticBatch != nullptr && !mStaticBatch->IsDirty())
+	{
+		auto& batchComponents = mStaticBatch->GetComponents();
+		if (component->GetSceneNode()->IsStatic() ||
+			batchComponents.end() != std::find(batchComponents.begin(), batchComponents.end(), component))
+		{
+			mStaticBatch->SetDirty();
+		}
+	}
 	UpdateEmptyMark();
 }
 
-void QuadTreeNode::RecursiveFindVisible(Camera* camera)
+void QuadTreeNode::RecursiveFindVisible(Camera* camera, unsigned int renderingOrderVersion)
 {
 	if (IsEmpty())
 		return;
 
-	for (g2d::Component*& component : mComponenList)
+	for (g2d::Component* component : mUnbatchedComponents)
 	{
 		if (component->GetSceneNode()->IsVisible() && camera->TestVisible(component))
 		{
@@ -156,11 +231,61 @@ void QuadTreeNode::RecursiveFindVisible(Camera* camera)
 		}
 	}
 
+	if (mStaticBatch != nullptr)
+	{
+		mStaticBatch->CheckChanges(renderingOrderVersion);
+		if (mStaticBatch->IsDirty())
+		{
+			mStaticBatch->Rebuild(mComponenList);
+		}
+
+		if (!mStaticBatch->IsEmpty())
+		{
+			camera->mVisibleStaticBatches.push_back(mStaticBatch);
+		}
+	}
+
 	for (auto& child : mDirectionNodes)
 	{
 		if (child != nullptr && camera->TestVisible(child->GetBounding()))
 		{
-			child->RecursiveFindVisible(camera);
+			child->RecursiveFindVisible(camera, renderingOrderVersion);
+		}
+	}
+}
+
+void QuadTreeNode::RecursiveFindNearest(Camera* camera, const cxx::point2d<float>& worldPosition, g2d::Component*& nearest)
+{
+	if (IsEmpty())
+		return;
+
+	for (g2d::Component* component : mComponenList)
+	{
+		if (nearest != nullptr && nearest->_GetRenderingOrder_Internal() > component->_GetRenderingOrder_Internal())
+			continue;
+
+		g2d::SceneNode* node = component->GetSceneNode();
+		if (node->IsRemoved() || !node->IsVisible() ||
+			cxx::is_single_point(component->GetLocalAABB()) ||
+			!camera->IsMatchCameraVisibleMask(component->GetCameraVisibleMask()))
+			continue;
+
+		// cheap rejection before transforming to local space.
+		if (!component->GetWorldAABB().contains(worldPosition))
+			continue;
+
+		cxx::point2d<float> localPos = node->WorldToLocal(worldPosition);
+		if (component->GetLocalAABB().contains(localPos))
+		{
+			nearest = component;
+		}
+	}
+
+	for (auto& child : mDirectionNodes)
+	{
+		if (child != nullptr && child->GetBounding().contains(worldPosition))
+		{
+			child->RecursiveFindNearest(camera, worldPosition, nearest);
 		}
 	}
 }
@@ -179,21 +304,14 @@ void SpatialGraph::Add(g2d::Component* component)
 {
 	if (!g2d::Is<::Camera>(component))
 	{
-		Remove(component);
-
-		QuadTreeNode* pNode = nullptr;
-		if (component->GetSceneNode()->IsStatic())
+		if (mIsBulkAdding)
 		{
-			cxx::aabb2d<float> nodeAABB = component->GetWorldAABB();
-			pNode = mRoot->RecursiveAdd(nodeAABB, component);
+			mPendingComponents.insert(component);
 		}
 		else
 		{
-			//dynamic objects
-			// FOR HINT: mRoot->mIsEmpty = false;
-			pNode = mRoot->AddToList(component);
+			Locate(component, mRoot);
 		}
-		mLinkRef[component] = pNode;
 	}
 }
 
@@ -201,16 +319,138 @@ void SpatialGraph::Remove(g2d::Component* component)
 {
 	if (!g2d::Is<::Camera>(component))
 	{
-		if (mLinkRef.count(component))
+		if (mIsBulkAdding)
 		{
-			QuadTreeNode* pNode = mLinkRef[component];
-			pNode->Remove(component);
-			mLinkRef.erase(component);
+			mPendingComponents.erase(component);
+		}
+
+		auto itFound = mLinkRef.find(component);
+		if (itFound != mLinkRef.end())
+		{
+			itFound->second.Node->Remove(component);
+			mLinkRef.erase(itFound);
 		}
 	}
 }
 
+void SpatialGraph::SetStaticBatchDirty(g2d::Component* component)
+{
+	// pending ones dirty the batch when they are located.
+	auto itFound = mLinkRef.find(component);
+	if (itFound != mLinkRef.end() && itFound->second.IsStatic)
+	{
+		itFound->second.Node->SetStaticBatchDirty();
+	}
+}
+
+QuadTreeNode* SpatialGraph::FindNode(g2d::Component* component)
+{
+	auto itFound = mLinkRef.find(component);
+	return (itFound != mLinkRef.end()) ? itFound->second.Node : nullptr;
+}
+
+void SpatialGraph::BeginBulkAdd()
+{
+	mIsBulkAdding = true;
+}
+
+void SpatialGraph::EndBulkAdd()
+{
+	mIsBulkAdding = false;
+	if (mPendingComponents.empty())
+		return;
+
+	std::vector<std::pair<uint32_t, g2d::Component*>> sortedComponents;
+	sortedComponents.reserve(mPendingComponents.size());
+	for (g2d::Component* component : mPendingComponents)
+	{
+		sortedComponents.push_back({ GetMortonCode(component->GetWorldAABB()), component });
+	}
+	mPendingComponents.clear();
+
+	std::sort(sortedComponents.begin(), sortedComponents.end(),
+		[](const std::pair<uint32_t, g2d::Component*>& a, const std::pair<uint32_t, g2d::Component*>& b)
+	{
+		return a.first < b.first;
+	});
+
+	mLinkRef.reserve(mLinkRef.size() + sortedComponents.size());
+	QuadTreeNode* lastNode = mRoot;
+	for (auto& entry : sortedComponents)
+	{
+		lastNode = Locate(entry.second, lastNode);
+	}
+}
+
+QuadTreeNode* SpatialGraph::Locate(g2d::Component* component, QuadTreeNode* start)
+{
+	/**
+	*	dynamic components are located in the tree as well,
+	*	they are relocated in the update pass of the frames
+	*	their transform changed, like the static ones.
+	*/
+	cxx::aabb2d<float> nodeAABB = component->GetWorldAABB();
+	bool isStatic = component->GetSceneNode()->IsStatic();
+	auto itFound = mLinkRef.find(component);
+	if (itFound != mLinkRef.end())
+	{
+		// switching static flag always goes through Remove to dirty the batch.
+		Link& link = itFound->second;
+		if (link.IsStatic == isStatic)
+		{
+			// dynamic ones rotating or moving back and forth. static ones
+			// are re-added anyway, the batch holds their geometry.
+			if (!isStatic && IsSameBounds(link.Bounds, nodeAABB))
+				return link.Node;
+
+			// staying in the same leaf, most small moves end here.
+			QuadTreeNode* pNode = link.Node;
+			if (pNode->IsLeaf() && pNode->GetBounding().hit_test(nodeAABB) == cxx::intersection::contain)
+			{
+				if (isStatic)
+				{
+					pNode->Remove(component);
+					pNode->AddToList(component);
+				}
+				link.Bounds = nodeAABB;
+				return pNode;
+			}
+		}
+		Remove(component);
+	}
+
+	QuadTreeNode* pNode = start->FindContainer(nodeAABB)->RecursiveAdd(nodeAABB, component);
+	mLinkRef[component] = { pNode, nodeAABB, isStatic };
+	return pNode;
+}
+
+uint32_t SpatialGraph::GetMortonCode(const cxx::aabb2d<float>& bounds) const
+{
+	if (!bounds.is_valid())
+		return 0;
+
+	cxx::aabb2d<float> rootBounding = mRoot->GetBounding();
+	cxx::float2 rootCenter = rootBounding.center();
+	float rootSize = rootBounding.extend().x * 2.0f;
+	cxx::float2 center = bounds.center();
+
+	// out of the bounding ones are clamped to the border.
+	float normalizedX = std::min(std::max((center.x - rootCenter.x) / rootSize + 0.5f, 0.0f), 1.0f);
+	float normalizedY = std::min(std::max((center.y - rootCenter.y) / rootSize + 0.5f, 0.0f), 1.0f);
+	uint32_t x = static_cast<uint32_t>(normalizedX * 65535.0f);
+	uint32_t y = static_cast<uint32_t>(normalizedY * 65535.0f);
+	return SpreadBits(x) | (SpreadBits(y) << 1);
+}
+
 void SpatialGraph::RecursiveFindVisible(Camera* camera)
 {
-	mRoot->RecursiveFindVisible(camera);
+	mRoot->RecursiveFindVisible(camera, mRenderingOrderVersion);
+}
+
+g2d::Component* SpatialGraph::FindNearestComponent(Camera* camera, const cxx::point2d<float>& worldPosition)
+{
+	// components out of the bounding are kept by the root.
+	g2d::Component* nearest = nullptr;
+	mRoot->RecursiveFindNearest(camera, worldPosition, nearest);
+	return nearest;
 }
@@ -1,9 +1,12 @@
 #pragma once
+#include <cstdint>
 #include <vector>
-#include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include "../scope_utility.h"
 
 class Camera;
+class StaticBatch;
 
 class QuadTreeNode
 {
@@ -18,14 +21,27 @@ public:
 
 	QuadTreeNode* AddToList(g2d::Component* component);
 
+	// nearest ancestor (or itself) containing the bounds, the root
+	// accepts everything. adding from it is the same as from the root.
+	QuadTreeNode* FindContainer(const cxx::aabb2d<float>& bounds);
+
 	void Remove(g2d::Component* component);
 
 	cxx::aabb2d<float> GetBounding() { return mBounding; }
 
-	void RecursiveFindVisible(Camera* camera);
+	void RecursiveFindVisible(Camera* camera, unsigned int renderingOrderVersion);
+
+	// only descends into the children containing the position.
+	void RecursiveFindNearest(Camera* camera, const cxx::point2d<float>& worldPosition, g2d::Component*& nearest);
 
 	bool IsEmpty() { return mIsEmpty; }
 
+	bool IsLeaf() { return mIsLeaf; }
+
+	void SetStaticBatchDirty();
+
+	StaticBatch* GetStaticBatch() { return mStaticBatch; }
+
 private:
 	void UpdateEmptyMark();
 
@@ -44,7 +60,15 @@ private:
 	QuadTreeNode* mParent;
 	QuadTreeNode* mDirectionNodes[Direction::Count];
 	std::vector<g2d::Component*> mComponenList;
+
+	// dynamic ones and tilemaps in mComponenList, the rest are
+	// drawn by the batch, so static cells are culled at once.
+	std::vector<g2d::Component*> mUnbatchedComponents;
 	cxx::aabb2d<float> mBounding;
+
+	// static components in mComponenList are rendered
+	// by the batch, created at the first static one added.
+	StaticBatch* mStaticBatch = nullptr;
 };
 
 class SpatialGraph
@@ -58,9 +82,48 @@ public:
 
 	void Remove(g2d::Component* component);
 
+	// rebake the batch holding the component, called when
+	// its render data changes without moving it.
+	void SetStaticBatchDirty(g2d::Component* component);
+
+	// node containing the component, nullptr if it is not located.
+	QuadTreeNode* FindNode(g2d::Component* component);
+
+	// components added between them are collected and located
+	// in morton order at the end, neighbours share the path of
+	// the tree so that most of them are added without descending
+	// from the root.
+	void BeginBulkAdd();
+
+	void EndBulkAdd();
+
 	void RecursiveFindVisible(Camera* camera);
 
+	// static batches check the order of their components after it.
+	void SetRenderingOrderChanged() { mRenderingOrderVersion++; }
+
+	// topmost component (by rendering order) visible in
+	// the camera and containing the position.
+	g2d::Component* FindNearestComponent(Camera* camera, const cxx::point2d<float>& worldPosition);
+
 private:
+	// bounds and static flag at the time it is located.
+	struct Link
+	{
+		QuadTreeNode* Node;
+		cxx::aabb2d<float> Bounds;
+		bool IsStatic;
+	};
+
+	// return the node containing the component.
+	QuadTreeNode* Locate(g2d::Component* component, QuadTreeNode* start);
+
+	uint32_t GetMortonCode(const cxx::aabb2d<float>& bounds) const;
+
 	QuadTreeNode* mRoot;
-	std::map<g2d::Component*, QuadTreeNode*> mLinkRef;
+	std::unordered_map<g2d::Component*, Link> mLinkRef;
+
+	bool mIsBulkAdding = false;
+	unsigned int mRenderingOrderVersion = 0;
+	std::unordered_set<g2d::Component*> mPendingComponents;
 };
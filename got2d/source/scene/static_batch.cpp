@@ -0,0 +1,193 @@
+#include <algorithm>
+#include "../system_blackboard.h"
+#include "../render/render_system.h"
+#include "static_batch.h"
+#include "tilemap.h"
+
+bool RenderingOrderSorter(g2d::Component* a, g2d::Component* b);
+
+namespace
+{
+	// passes are always newer than the ones they replaced.
+	unsigned int GetMaterialVersion(g2d::Material* material)
+	{
+		unsigned int version = 0;
+		for (unsigned int i = 0, n = material->GetPassCount(); i < n; i++)
+		{
+			version = std::max(version, material->GetPassByIndex(i)->GetStateVersion());
+		}
+		return version;
+	}
+}
+
+StaticBatch::~StaticBatch()
+{
+	ReleaseMaterials();
+}
+
+void StaticBatch::Rebuild(const std::vector<g2d::Component*>& components)
+{
+	mIsDirty = false;
+	mComponents.clear();
+	mRuns.clear();
+	mIndexStarts.clear();
+	mGeometry = nullptr;
+	ReleaseMaterials();
+
+	for (g2d::Component* component : components)
+	{
+		g2d::SceneNode* node = component->GetSceneNode();
+		if (node->IsStatic() && node->IsVisible() && !cxx::is_single_point(component->GetLocalAABB()) &&
+			!g2d::Is<::Tilemap>(component))
+		{
+			mComponents.push_back(component);
+		}
+	}
+
+	if (mComponents.empty())
+		return;
+
+	std::sort(mComponents.begin(), mComponents.end(), RenderingOrderSorter);
+
+	GetRenderSystem().BeginCapture(this);
+	for (unsigned int i = 0, n = GetComponentCount(); i < n; i++)
+	{
+		mCapturingComponent = i;
+		mCapturingMask = mComponents[i]->GetCameraVisibleMask();
+		mComponents[i]->OnRender();
+	}
+	GetRenderSystem().EndCapture();
+
+	MergeCapturedRequests();
+	mCapturedRequests.clear();
+}
+
+void StaticBatch::Capture(unsigned int layer, g2d::Mesh& mesh, g2d::Material& material, const cxx::float2x3& worldMatrix, const g2d::DrawParameters& params)
+{
+	mCapturedRequests.push_back({ mCapturingComponent, layer, mCapturingMask, &mesh, &material, worldMatrix, params });
+
+	auto sameMaterial = [&](const MaterialVersion& m) { return m.MaterialPtr == &material; };
+	if (std::none_of(mMaterials.begin(), mMaterials.end(), sameMaterial))
+	{
+		material.AddRef();
+		mMaterials.push_back({ &material, GetMaterialVersion(&material) });
+	}
+}
+
+void StaticBatch::CheckChanges(unsigned int renderingOrderVersion)
+{
+	if (mIsDirty)
+		return;
+
+	for (auto& m : mMaterials)
+	{
+		if (m.Version != GetMaterialVersion(m.MaterialPtr))
+		{
+			mIsDirty = true;
+			return;
+		}
+	}
+
+	// only checked when the scene has reordered nodes.
+	if (mRenderingOrderVersion != renderingOrderVersion)
+	{
+		mRenderingOrderVersion = renderingOrderVersion;
+		if (!std::is_sorted(mComponents.begin(), mComponents.end(), RenderingOrderSorter))
+		{
+			mIsDirty = true;
+		}
+	}
+}
+
+unsigned int StaticBatch::GetRenderingOrder() const
+{
+	ENSURE(!mComponents.empty());
+	return mComponents.front()->_GetRenderingOrder_Internal();
+}
+
+unsigned int StaticBatch::GetLastRenderingOrder() const
+{
+	ENSURE(!mComponents.empty());
+	return mComponents.back()->_GetRenderingOrder_Internal();
+}
+
+unsigned int StaticBatch::FindComponent(unsigned int renderingOrder) const
+{
+	auto it = std::lower_bound(mComponents.begin(), mComponents.end(), renderingOrder,
+		[](g2d::Component* component, unsigned int order) { return component->_GetRenderingOrder_Internal() < order; });
+	return static_cast<unsigned int>(it - mComponents.begin());
+}
+
+void StaticBatch::ReleaseMaterials()
+{
+	for (auto& m : mMaterials)
+	{
+		m.MaterialPtr->Release();
+	}
+	mMaterials.clear();
+}
+
+void StaticBatch::MergeCapturedRequests()
+{
+	auto geometry = std::make_shared<RetainedGeometry>(GetRenderSystem().GetVertexFormat());
+	auto& vertices = geometry->Vertices;
+	auto& indices = geometry->Indices;
+
+	// requests are captured in rendering order, so are the indices.
+	unsigned int componentIndex = 0;
+	mIndexStarts.resize(mComponents.size() + 1);
+
+	Run* run = nullptr;
+	for (auto& request : mCapturedRequests)
+	{
+		for (; componentIndex <= request.ComponentIndex; componentIndex++)
+		{
+			mIndexStarts[componentIndex] = static_cast<unsigned int>(indices.size());
+		}
+
+		g2d::Mesh& mesh = *(request.MeshPtr);
+		unsigned int numVertex = static_cast<unsigned int>(vertices.size());
+		if (run == nullptr ||
+			run->Layer != request.Layer ||
+			run->CameraVisibleMask != request.CameraVisibleMask ||
+			!run->MaterialPtr->IsSame(request.MaterialPtr) ||
+			numVertex - run->BaseVertex + mesh.GetVertexCount() > ::Mesh::MaxBatchVertexCount)
+		{
+			mRuns.emplace_back();
+			run = &(mRuns.back());
+			run->Layer = request.Layer;
+			run->CameraVisibleMask = request.CameraVisibleMask;
+			run->MaterialPtr = request.MaterialPtr;
+			run->StartIndex = static_cast<unsigned int>(indices.size());
+			run->BaseVertex = numVertex;
+		}
+
+		auto srcVertices = mesh.GetRawVertices();
+		for (unsigned int i = 0, n = mesh.GetVertexCount(); i < n; i++)
+		{
+			vertices.push_back(srcVertices[i]);
+			auto& p = vertices.back().Position;
+			p = transform(request.WorldMatrix, cxx::point2d<float>(p));
+			ApplyDrawParameters(vertices.back(), request.Params);
+		}
+
+		auto srcIndices = mesh.GetRawIndices();
+		unsigned int indexOffset = numVertex - run->BaseVertex;
+		for (unsigned int i = 0, n = mesh.GetIndexCount(); i < n; i++)
+		{
+			indices.push_back(srcIndices[i] + indexOffset);
+		}
+		run->IndexCount += mesh.GetIndexCount();
+	}
+	for (; componentIndex <= mComponents.size(); componentIndex++)
+	{
+		mIndexStarts[componentIndex] = static_cast<unsigned int>(indices.size());
+	}
+
+	if (indices.empty())
+	{
+		mRuns.clear();
+		return;
+	}
+	mGeometry = geometry;
+}
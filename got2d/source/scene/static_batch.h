@@ -0,0 +1,113 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "g2dscene.h"
+#include "../render/frame_packet.h"
+
+/**
+*	Retained geometry of static components inside one quadtree node.
+*	Render requests of those components are captured once, merged by
+*	(layer, camera mask, material) and kept in video memory until
+*	the content of the node changes.
+*
+*	the batch is drawn in spans of its components, it is split
+*	where dynamic components are interleaved in rendering order.
+*	it is rebuilt when the passes of captured materials are
+*	changed, or the rendering order of its components is shuffled.
+*/
+class StaticBatch
+{
+public:
+	~StaticBatch();
+
+	struct Run
+	{
+		unsigned int Layer = 0;
+		unsigned int CameraVisibleMask = 0;
+		g2d::Material* MaterialPtr = nullptr;
+		unsigned int StartIndex = 0;
+		unsigned int IndexCount = 0;
+		unsigned int BaseVertex = 0;
+	};
+
+	void SetDirty() { mIsDirty = true; }
+
+	bool IsDirty() const { return mIsDirty; }
+
+	bool IsEmpty() const { return mRuns.empty(); }
+
+	// components are the content of quadtree node, dynamic ones will be skipped.
+	void Rebuild(const std::vector<g2d::Component*>& components);
+
+	// called by RenderSystem while capturing.
+	void Capture(unsigned int layer, g2d::Mesh& mesh, g2d::Material& material, const cxx::float2x3& worldMatrix, const g2d::DrawParameters& params);
+
+	// set dirty if captured materials are modified, or components are
+	// reordered. the order version is changed when scene reorders nodes.
+	void CheckChanges(unsigned int renderingOrderVersion);
+
+	unsigned int GetRenderingOrder() const;
+
+	unsigned int GetLastRenderingOrder() const;
+
+	// index of the first component not before the rendering order.
+	unsigned int FindComponent(unsigned int renderingOrder) const;
+
+	// geometry of component [first, end) takes indices of [start(first), start(end)).
+	unsigned int GetIndexStart(unsigned int componentIndex) const { return mIndexStarts[componentIndex]; }
+
+	unsigned int GetComponentCount() const { return static_cast<unsigned int>(mComponents.size()); }
+
+	const std::vector<Run>& GetRuns() const { return mRuns; }
+
+	const std::vector<g2d::Component*>& GetComponents() const { return mComponents; }
+
+	const std::shared_ptr<RetainedGeometry>& GetGeometry() const { return mGeometry; }
+
+private:
+	struct CapturedRequest
+	{
+		unsigned int ComponentIndex;
+		unsigned int Layer;
+		unsigned int CameraVisibleMask;
+		g2d::Mesh* MeshPtr;
+		g2d::Material* MaterialPtr;
+		cxx::float2x3 WorldMatrix;
+		g2d::DrawParameters Params;
+	};
+
+	struct MaterialVersion
+	{
+		g2d::Material* MaterialPtr;
+		unsigned int Version;
+	};
+
+	void MergeCapturedRequests();
+
+	void ReleaseMaterials();
+
+	bool mIsDirty = true;
+	unsigned int mCapturingComponent = 0;
+	unsigned int mCapturingMask = 0;
+	unsigned int mRenderingOrderVersion = 0;
+	std::vector<g2d::Component*> mComponents;
+	std::vector<CapturedRequest> mCapturedRequests;
+	std::vector<Run> mRuns;
+	std::vector<unsigned int> mIndexStarts;
+
+	// referenced until rebuilding, components may drop them meanwhile.
+	std::vector<MaterialVersion> mMaterials;
+
+	// frame packets in flight may still refer the old one,
+	// so rebuilding always creates a new geometry.
+	std::shared_ptr<RetainedGeometry> mGeometry;
+};
+
+// components [FirstComponent, EndComponent) of the batch drawn at Order.
+struct StaticBatchSpan
+{
+	unsigned int Order;
+	StaticBatch* Batch;
+	unsigned int FirstComponent;
+	unsigned int EndComponent;
+};
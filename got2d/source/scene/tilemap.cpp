@@ -0,0 +1,243 @@
+#include "../system_blackboard.h"
+#include "../render/render_system.h"
+#include "tilemap.h"
+#include "camera.h"
+#include "scene.h"
+
+Tilemap::Tilemap(unsigned int columns, unsigned int rows, const cxx::float2& tileSize)
+	: mColumnCount(columns)
+	, mRowCount(rows)
+	, mChunkCountX((columns + ChunkSize - 1) / ChunkSize)
+	, mChunkCountY((rows + ChunkSize - 1) / ChunkSize)
+	, mTileSize(tileSize)
+{
+	mAABB.expand(cxx::float2::zero());
+	mAABB.expand(cxx::float2(columns * tileSize.x, rows * tileSize.y));
+	mChunks.resize(mChunkCountX * mChunkCountY);
+}
+
+Tilemap::~Tilemap()
+{
+	cxx::safe_release(mMaterial);
+}
+
+void Tilemap::SetTileset(g2d::Material* material, unsigned int atlasColumns, unsigned int atlasRows)
+{
+	if (material != nullptr)
+	{
+		material->AddRef();
+	}
+	cxx::safe_release(mMaterial);
+	mMaterial = material;
+	mAtlasColumns = (atlasColumns > 0) ? atlasColumns : 1;
+	mAtlasRows = (atlasRows > 0) ? atlasRows : 1;
+
+	SetAllChunksDirty();
+	InvalidateLocalRegion(mAABB);
+}
+
+void Tilemap::SetTile(unsigned int column, unsigned int row, unsigned int tile)
+{
+	if (column >= mColumnCount || row >= mRowCount)
+		return;
+
+	uint16_t tileIndex = (tile < EmptyTile) ? static_cast<uint16_t>(tile) : static_cast<uint16_t>(EmptyTile);
+	Chunk& chunk = mChunks[(row / ChunkSize) * mChunkCountX + column / ChunkSize];
+	if (chunk.Tiles.empty())
+	{
+		if (tileIndex == EmptyTile)
+			return;
+
+		chunk.Tiles.assign(ChunkSize * ChunkSize, static_cast<uint16_t>(EmptyTile));
+	}
+
+	uint16_t& current = chunk.Tiles[(row % ChunkSize) * ChunkSize + column % ChunkSize];
+	if (current == tileIndex)
+		return;
+
+	current = tileIndex;
+	chunk.IsDirty = true;
+
+	cxx::aabb2d<float> tileRegion;
+	tileRegion.expand(cxx::float2(column * mTileSize.x, row * mTileSize.y));
+	tileRegion.expand(cxx::float2((column + 1) * mTileSize.x, (row + 1) * mTileSize.y));
+	InvalidateLocalRegion(tileRegion);
+}
+
+unsigned int Tilemap::GetTile(unsigned int column, unsigned int row) const
+{
+	if (column >= mColumnCount || row >= mRowCount)
+		return EmptyTile;
+
+	const Chunk& chunk = mChunks[(row / ChunkSize) * mChunkCountX + column / ChunkSize];
+	if (chunk.Tiles.empty())
+		return EmptyTile;
+
+	return chunk.Tiles[(row % ChunkSize) * ChunkSize + column % ChunkSize];
+}
+
+void Tilemap::SetRenderLayer(unsigned int layer)
+{
+	if (mRenderLayer != layer)
+	{
+		mRenderLayer = layer;
+		InvalidateLocalRegion(mAABB);
+	}
+}
+
+void Tilemap::OnRender()
+{
+	if (mMaterial == nullptr)
+		return;
+
+	auto scene = reinterpret_cast<::Scene*>(GetSceneNode()->GetScene());
+	::Camera* camera = scene->GetRenderingCamera();
+	if (camera == nullptr)
+		return;
+
+	const cxx::float2x3& worldMatrix = GetSceneNode()->GetWorldMatrix();
+	auto& renderSystem = GetRenderSystem();
+	unsigned int frame = renderSystem.GetFrameFence();
+	cxx::float2 chunkExtent(ChunkSize * mTileSize.x, ChunkSize * mTileSize.y);
+	for (unsigned int chunkY = 0; chunkY < mChunkCountY; chunkY++)
+	{
+		for (unsigned int chunkX = 0; chunkX < mChunkCountX; chunkX++)
+		{
+			Chunk& chunk = mChunks[chunkY * mChunkCountX + chunkX];
+			if (chunk.Tiles.empty())
+				continue;
+
+			cxx::aabb2d<float> chunkRegion;
+			chunkRegion.expand(cxx::float2(chunkX * chunkExtent.x, chunkY * chunkExtent.y));
+			chunkRegion.expand(cxx::float2((chunkX + 1) * chunkExtent.x, (chunkY + 1) * chunkExtent.y));
+			if (!camera->TestVisible(GetWorldBounds(chunkRegion)))
+			{
+				// keep video memory for chunks just out of sight.
+				if (chunk.Geometry != nullptr && frame - chunk.LastRenderedFrame > ChunkEvictFrames)
+				{
+					chunk.Geometry = nullptr;
+					chunk.IndexCount = 0;
+					chunk.IsDirty = true;
+				}
+				continue;
+			}
+
+			if (chunk.IsDirty)
+			{
+				BakeChunk(chunkX, chunkY, chunk);
+			}
+
+			chunk.LastRenderedFrame = frame;
+			if (chunk.IndexCount > 0)
+			{
+				renderSystem.RenderRetained(mRenderLayer, mMaterial, chunk.Geometry, chunk.IndexCount, worldMatrix);
+			}
+		}
+	}
+}
+
+void Tilemap::BakeChunk(unsigned int chunkX, unsigned int chunkY, Chunk& chunk)
+{
+	chunk.IsDirty = false;
+
+	// geometry may be referred by frames in flight, build a new one.
+	auto geometry = std::make_shared<RetainedGeometry>(GetRenderSystem().GetVertexFormat());
+	auto& vertices = geometry->Vertices;
+	auto& indices = geometry->Indices;
+
+	float cellWidth = 1.0f / mAtlasColumns;
+	float cellHeight = 1.0f / mAtlasRows;
+	unsigned int atlasCount = mAtlasColumns * mAtlasRows;
+	g2d::GeometryVertex vertex;
+	vertex.VertexColor = g2d::DrawParameters().Tint;
+
+	static const unsigned int sQuadIndices[] = { 0, 2, 1, 0, 3, 2 };
+	for (unsigned int y = 0; y < ChunkSize; y++)
+	{
+		unsigned int row = chunkY * ChunkSize + y;
+		if (row >= mRowCount)
+			break;
+
+		for (unsigned int x = 0; x < ChunkSize; x++)
+		{
+			unsigned int column = chunkX * ChunkSize + x;
+			if (column >= mColumnCount)
+				break;
+
+			unsigned int tile = chunk.Tiles[y * ChunkSize + x];
+			if (tile == EmptyTile || tile >= atlasCount)
+				continue;
+
+			// atlas cells start from the top-left of the texture.
+			float uvLeft = (tile % mAtlasColumns) * cellWidth;
+			float uvTop = (tile / mAtlasColumns) * cellHeight;
+			float uvRight = uvLeft + cellWidth;
+			float uvBottom = uvTop + cellHeight;
+
+			float left = column * mTileSize.x;
+			float bottom = row * mTileSize.y;
+			float right = left + mTileSize.x;
+			float top = bottom + mTileSize.y;
+			unsigned int baseVertex = static_cast<unsigned int>(vertices.size());
+
+			vertex.Position = cxx::point2d<float>(left, bottom);
+			vertex.Texcoord = cxx::point2d<float>(uvLeft, uvBottom);
+			vertices.push_back(vertex);
+
+			vertex.Position = cxx::point2d<float>(right, bottom);
+			vertex.Texcoord = cxx::point2d<float>(uvRight, uvBottom);
+			vertices.push_back(vertex);
+
+			vertex.Position = cxx::point2d<float>(right, top);
+			vertex.Texcoord = cxx::point2d<float>(uvRight, uvTop);
+			vertices.push_back(vertex);
+
+			vertex.Position = cxx::point2d<float>(left, top);
+			vertex.Texcoord = cxx::point2d<float>(uvLeft, uvTop);
+			vertices.push_back(vertex);
+
+			for (unsigned int index : sQuadIndices)
+			{
+				indices.push_back(baseVertex + index);
+			}
+		}
+	}
+
+	chunk.IndexCount = static_cast<unsigned int>(indices.size());
+	chunk.Geometry = (chunk.IndexCount > 0) ? geometry : nullptr;
+}
+
+void Tilemap::InvalidateLocalRegion(const cxx::aabb2d<float>& localRegion)
+{
+	if (GetSceneNode() != nullptr)
+	{
+		auto scene = reinterpret_cast<::Scene*>(GetSceneNode()->GetScene());
+		scene->SetLayerDirty(GetCameraVisibleMask());
+		scene->InvalidateRegion(GetWorldBounds(localRegion));
+	}
+}
+
+void Tilemap::SetAllChunksDirty()
+{
+	for (Chunk& chunk : mChunks)
+	{
+		chunk.IsDirty = true;
+	}
+}
+
+cxx::aabb2d<float> Tilemap::GetWorldBounds(const cxx::aabb2d<float>& localRegion) const
+{
+	if (GetSceneNode() == nullptr)
+		return localRegion;
+
+	const cxx::float2x3& worldMatrix = GetSceneNode()->GetWorldMatrix();
+	cxx::float2 center = localRegion.center();
+	cxx::float2 extend = localRegion.extend();
+
+	cxx::aabb2d<float> bounds;
+	bounds.expand(transform(worldMatrix, cxx::point2d<float>(center.x - extend.x, center.y - extend.y)));
+	bounds.expand(transform(worldMatrix, cxx::point2d<float>(center.x + extend.x, center.y - extend.y)));
+	bounds.expand(transform(worldMatrix, cxx::point2d<float>(center.x - extend.x, center.y + extend.y)));
+	bounds.expand(transform(worldMatrix, cxx::point2d<float>(center.x + extend.x, center.y + extend.y)));
+	return bounds;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "g2dscene.h"
+#include "g2drender.h"
+#include "../render/frame_packet.h"
+
+class Tilemap : public g2d::Tilemap
+{
+	RTTI_IMPL;
+public:
+	virtual const cxx::aabb2d<float>& GetLocalAABB() const override { return mAABB; }
+
+	virtual unsigned int GetSubscribedEvents() const override { return g2d::BroadcastEvent::None; }
+
+	virtual void OnRender() override;
+
+	virtual void Release() override { delete this; }
+
+public:
+	virtual unsigned int GetColumnCount() const override { return mColumnCount; }
+
+	virtual unsigned int GetRowCount() const override { return mRowCount; }
+
+	virtual const cxx::float2& GetTileSize() const override { return mTileSize; }
+
+	virtual void SetTileset(g2d::Material* material, unsigned int atlasColumns, unsigned int atlasRows) override;
+
+	virtual g2d::Material* GetTilesetMaterial() const override { return mMaterial; }
+
+	virtual void SetTile(unsigned int column, unsigned int row, unsigned int tile) override;
+
+	virtual unsigned int GetTile(unsigned int column, unsigned int row) const override;
+
+	virtual void SetRenderLayer(unsigned int layer) override;
+
+	virtual unsigned int GetRenderLayer() const override { return mRenderLayer; }
+
+public:
+	Tilemap(unsigned int columns, unsigned int rows, const cxx::float2& tileSize);
+
+	~Tilemap();
+
+private:
+	// at most 64 * 64 * 4 vertices, indices fit in 16 bits.
+	constexpr static unsigned int ChunkSize = 64;
+
+	// geometry of chunks out of sight for the frames is released.
+	constexpr static unsigned int ChunkEvictFrames = 300;
+
+	struct Chunk
+	{
+		std::vector<uint16_t> Tiles;	//empty until a tile is set.
+		std::shared_ptr<RetainedGeometry> Geometry;
+		unsigned int IndexCount = 0;
+		unsigned int LastRenderedFrame = 0;
+		bool IsDirty = true;
+	};
+
+	// geometry is baked in local space, moving the node does not rebake.
+	void BakeChunk(unsigned int chunkX, unsigned int chunkY, Chunk& chunk);
+
+	// mark the region changed, for cached cameras and partial redraw.
+	void InvalidateLocalRegion(const cxx::aabb2d<float>& localRegion);
+
+	void SetAllChunksDirty();
+
+	cxx::aabb2d<float> GetWorldBounds(const cxx::aabb2d<float>& localRegion) const;
+
+	unsigned int mColumnCount;
+	unsigned int mRowCount;
+	unsigned int mChunkCountX;
+	unsigned int mChunkCountY;
+	cxx::float2 mTileSize;
+	cxx::aabb2d<float> mAABB;
+	std::vector<Chunk> mChunks;
+
+	g2d::Material* mMaterial = nullptr;
+	unsigned int mAtlasColumns = 1;
+	unsigned int mAtlasRows = 1;
+	unsigned int mRenderLayer = g2d::RenderLayer::BackGround;
+};
@@ -1,6 +1,29 @@
 #include "transform.h"
 #include "scene_node.h"
 
+cxx::float2x3 InverseAffine(const cxx::float2x3& m)
+{
+	// | a b tx |      | d/det  -b/det  (b*ty - d*tx)/det |
+	// | c d ty |  =>  | -c/det  a/det  (c*tx - a*ty)/det |
+	float a = m.r[0].x, b = m.r[0].y, tx = m.r[0].z;
+	float c = m.r[1].x, d = m.r[1].y, ty = m.r[1].z;
+	float det = a * d - b * c;
+	if (cxx::is_equal(det, 0.0f))
+	{
+		return cxx::float2x3::identity();
+	}
+
+	float invDet = 1.0f / det;
+	cxx::float2x3 inv = cxx::float2x3::identity();
+	inv.r[0].x = d * invDet;
+	inv.r[0].y = -b * invDet;
+	inv.r[0].z = (b * ty - d * tx) * invDet;
+	inv.r[1].x = -c * invDet;
+	inv.r[1].y = a * invDet;
+	inv.r[1].z = (c * tx - a * ty) * invDet;
+	return inv;
+}
+
 Transform::Transform(Transform* parent)
 	: mParent(parent)
 {
@@ -51,10 +74,19 @@ const cxx::float2x3& Transform::GetWorldMatrix()
 			mWorldPositionDirty = true;
 
 			mWorldMatrix = mParent->GetWorldMatrix() * GetMatrix();
-			return mWorldMatrix;
 		}
 	}
-	return GetMatrix();
+	return (mParent != nullptr) ? mWorldMatrix : GetMatrix();
+}
+
+const cxx::float2x3& Transform::GetWorldMatrixInverse()
+{
+	if (mWorldMatrixInverseNeedUpdate)
+	{
+		mWorldMatrixInverse = InverseAffine(GetWorldMatrix());
+		mWorldMatrixInverseNeedUpdate = false;
+	}
+	return mWorldMatrixInverse;
 }
 
 const cxx::point2d<float>& Transform::GetPosition() const
@@ -73,11 +105,9 @@ const cxx::point2d<float> & Transform::GetWorldPosition()
 				mParent->GetWorldMatrix(),
 				GetPosition()
 			);
-
-			return mWorldPosition;
 		}
 	}
-	return GetPosition();
+	return (mParent != nullptr) ? mWorldPosition : GetPosition();
 }
 
 const cxx::float2 & Transform::GetPivot() const
@@ -99,6 +129,7 @@ void Transform::SetMatrixDirty()
 {
 	mMatrixNeedUpdate = true;
 	mWorldMatrixNeedUpdate = true;
+	mWorldMatrixInverseNeedUpdate = true;
 	mWorldPositionDirty = true;
 	mWorldRightDirectionDirty = true;
 	mWorldUpDirectionDirty = true;
@@ -107,6 +138,7 @@ void Transform::SetMatrixDirty()
 void Transform::NotifyChildrenTransformChanged()
 {
 	mWorldMatrixNeedUpdate = true;
+	mWorldMatrixInverseNeedUpdate = true;
 	mWorldPositionDirty = true;
 	mWorldRightDirectionDirty = true;
 	mWorldUpDirectionDirty = true;
@@ -126,7 +158,7 @@ const cxx::nfloat2 & Transform::GetWorldRightDirection()
 {
 	if (mWorldRightDirectionDirty)
 	{
-		mWorldRightDirection = cxx::transform(GetWorldMatrix(), cxx::nfloat2::unit_y());
+		mWorldRightDirection = cxx::transform(GetWorldMatrix(), cxx::nfloat2::unit_x());
 		mWorldRightDirectionDirty = false;
 	}
 	return mWorldRightDirection;
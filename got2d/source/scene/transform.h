@@ -3,6 +3,10 @@
 
 class SceneNode;
 
+// inverse of scale-rotation-translation matrix,
+// cheaper than inversing a general 3x3 matrix.
+cxx::float2x3 InverseAffine(const cxx::float2x3& m);
+
 class Transform
 {
 public:
@@ -22,6 +26,8 @@ public:
 
 	const cxx::float2x3& GetWorldMatrix();
 
+	const cxx::float2x3& GetWorldMatrixInverse();
+
 	const cxx::point2d<float>& GetPosition() const;
 
 	const cxx::point2d<float>& GetWorldPosition();
@@ -44,6 +50,7 @@ private:
 
 	bool mMatrixNeedUpdate = true;
 	bool mWorldMatrixNeedUpdate = true;
+	bool mWorldMatrixInverseNeedUpdate = true;
 	bool mWorldPositionDirty = true;
 	bool mWorldRightDirectionDirty = true;
 	bool mWorldUpDirectionDirty = true;
@@ -63,4 +70,5 @@ private:
 
 	cxx::float2x3 mLocalMatrix = cxx::float2x3::identity();
 	cxx::float2x3 mWorldMatrix = cxx::float2x3::identity();
+	cxx::float2x3 mWorldMatrixInverse = cxx::float2x3::identity();
 };
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include "../system_blackboard.h"
+#include "../job_system.h"
+#include "update_scheduler.h"
+#include "scene_node.h"
+
+namespace
+{
+	// components per job, small enough to be stolen
+	// when update costs of components are uneven.
+	constexpr unsigned int UpdateGrainSize = 32;
+}
+
+void UpdateScheduler::Update(::SceneNode* root, unsigned int deltaTime)
+{
+	CollectEntries(root);
+
+	unsigned int begin = 0;
+	while (begin < mEntries.size())
+	{
+		int order = mEntries[begin].ExecuteOrder;
+		unsigned int serialBegin = 0;
+		unsigned int end = 0;
+		FindGroup(order, serialBegin, end);
+
+		GetJobSystem().ParallelFor(serialBegin - begin, UpdateGrainSize, [&](unsigned int b, unsigned int e)
+		{
+			for (unsigned int i = begin + b; i < begin + e; i++)
+			{
+				mEntries[i].ComponentPtr->OnUpdate(deltaTime);
+			}
+		});
+
+		//barrier
+		if (ApplyCommands())
+		{
+			// the tree has been changed, collect again and
+			// continue from the serial ones of the same order.
+			CollectEntries(root);
+			FindGroup(order, serialBegin, end);
+		}
+
+		// changes made by serial components take effect at once,
+		// removed ones are still alive until the end of the frame.
+		for (unsigned int i = serialBegin; i < end; i++)
+		{
+			mEntries[i].ComponentPtr->OnUpdate(deltaTime);
+		}
+		begin = end;
+	}
+	mEntries.clear();
+}
+
+void UpdateScheduler::Defer(CommandType type, ::SceneNode* node, ::SceneNode* child, g2d::Component* component, bool autoRelease)
+{
+	std::lock_guard<std::mutex> lock(mCommandMutex);
+	mCommands.push_back({ type, node, child, component, autoRelease });
+}
+
+void UpdateScheduler::CollectEntries(::SceneNode* root)
+{
+	mEntries.clear();
+	CollectNodeEntries(root);
+
+	// keep the order of depth-first traversal inside one group.
+	std::stable_sort(mEntries.begin(), mEntries.end(), ExecuteOrderSorter);
+}
+
+void UpdateScheduler::FindGroup(int order, unsigned int& serialBegin, unsigned int& end)
+{
+	Entry key{ order, false, nullptr };
+	serialBegin = static_cast<unsigned int>(std::lower_bound(mEntries.begin(), mEntries.end(), key, ExecuteOrderSorter) - mEntries.begin());
+	end = static_cast<unsigned int>(std::upper_bound(mEntries.begin(), mEntries.end(), key, ExecuteOrderSorter) - mEntries.begin());
+}
+
+void UpdateScheduler::CollectNodeEntries(g2d::SceneNode* node)
+{
+	for (unsigned int i = 0, n = node->GetComponentCount(); i < n; i++)
+	{
+		g2d::Component* component = node->GetComponentByIndex(i);
+		if (component->GetSubscribedEvents() & g2d::BroadcastEvent::Update)
+		{
+			mEntries.push_back({ component->GetExecuteOrder(), component->IsParallelSafe(), component });
+		}
+	}
+
+	for (unsigned int i = 0, n = node->GetChildCount(); i < n; i++)
+	{
+		CollectNodeEntries(node->GetChildByIndex(i));
+	}
+}
+
+bool UpdateScheduler::ApplyCommands()
+{
+	{
+		std::lock_guard<std::mutex> lock(mCommandMutex);
+		if (mCommands.empty())
+			return false;
+
+		mApplyingCommands.swap(mCommands);
+	}
+
+	for (Command& command : mApplyingCommands)
+	{
+		switch (command.Type)
+		{
+		case CommandType::AttachChild:
+			command.Node->AttachChild(command.Child);
+			break;
+		case CommandType::AddComponent:
+			command.Node->AddComponent(command.ComponentPtr, command.AutoRelease);
+			break;
+		case CommandType::RemoveComponent:
+			command.Node->RemoveComponent(command.ComponentPtr);
+			break;
+		case CommandType::RemoveComponentWithoutRelease:
+			command.Node->RemoveComponentWithoutRelease(command.ComponentPtr);
+			break;
+		case CommandType::ReleaseNode:
+			command.Node->Release();
+			break;
+		case CommandType::RelocateComponent:
+			command.Node->RelocateComponent(command.ComponentPtr);
+			break;
+		case CommandType::SetStaticBatchDirty:
+			command.Node->SetStaticBatchDirty(command.ComponentPtr);
+			break;
+		}
+	}
+	mApplyingCommands.clear();
+	return true;
+}
+
+bool UpdateScheduler::ExecuteOrderSorter(const Entry& a, const Entry& b)
+{
+	if (a.ExecuteOrder != b.ExecuteOrder)
+		return a.ExecuteOrder < b.ExecuteOrder;
+
+	return a.IsParallelSafe && !b.IsParallelSafe;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <mutex>
+#include <vector>
+#include "g2dscene.h"
+
+class SceneNode;
+
+/**
+*	Updates components group by group in execute order.
+*	Parallel-safe components of a group run on the job
+*	system, then the others run in depth-first order on
+*	the calling thread. Structural changes requested by jobs
+*	are recorded and applied at the barrier between them,
+*	components that do not belong to the tree any more
+*	will not be updated by the rest of the frame.
+*/
+class UpdateScheduler
+{
+public:
+	enum class CommandType : int
+	{
+		AttachChild,
+		AddComponent,
+		RemoveComponent,
+		RemoveComponentWithoutRelease,
+		ReleaseNode,
+		RelocateComponent,
+		SetStaticBatchDirty,
+	};
+
+	void Update(::SceneNode* root, unsigned int deltaTime);
+
+	// thread-safe, called by scene nodes inside a job.
+	void Defer(CommandType type, ::SceneNode* node, ::SceneNode* child, g2d::Component* component, bool autoRelease);
+
+private:
+	struct Entry
+	{
+		int ExecuteOrder;
+		bool IsParallelSafe;
+		g2d::Component* ComponentPtr;
+	};
+
+	struct Command
+	{
+		CommandType Type;
+		::SceneNode* Node;
+		::SceneNode* Child;
+		g2d::Component* ComponentPtr;
+		bool AutoRelease;
+	};
+
+	// parallel-safe ones first inside one execute order.
+	static bool ExecuteOrderSorter(const Entry& a, const Entry& b);
+
+	void CollectEntries(::SceneNode* root);
+
+	void CollectNodeEntries(g2d::SceneNode* node);
+
+	// serial components of the order are in [serialBegin, end).
+	void FindGroup(int order, unsigned int& serialBegin, unsigned int& end);
+
+	// return false if there is nothing to apply.
+	bool ApplyCommands();
+
+	std::vector<Entry> mEntries;
+
+	std::mutex mCommandMutex;
+	std::vector<Command> mCommands;
+	std::vector<Command> mApplyingCommands;
+};
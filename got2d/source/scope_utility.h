@@ -34,7 +34,7 @@ public:
 	}
 	ensure_exception& operator<<(int) { return *this; }
 	virtual ~ensure_exception() throw() { }
-	virtual const char* what() const override { return expression.c_str(); }
+	virtual const char* what() const throw() override { return expression.c_str(); }
 };
 static int ENSURE_NEXT_A = 0;
 static int ENSURE_NEXT_B = 0;
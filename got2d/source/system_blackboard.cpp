@@ -22,3 +22,8 @@ Keyboard& GetKeyboard()
 {
 	return Engine::Instance->GetKeyboardImpl();
 }
+
+JobSystem& GetJobSystem()
+{
+	return Engine::Instance->GetJobSystemImpl();
+}
@@ -4,6 +4,7 @@ class Engine;
 class RenderSystem;
 class Mouse;
 class Keyboard;
+class JobSystem;
 
 Engine* GetEngine();
 
@@ -11,4 +12,6 @@ RenderSystem& GetRenderSystem();
 
 Mouse& GetMouse();
 
-Keyboard& GetKeyboard();
\ No newline at end of file
+Keyboard& GetKeyboard();
+
+JobSystem& GetJobSystem();
\ No newline at end of file
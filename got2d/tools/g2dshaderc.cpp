@@ -0,0 +1,19 @@
+#include <cstdio>
+#include "g2drender.h"
+
+// usage: g2dshaderc <output file>
+int main(int argc, char* argv[])
+{
+	if (argc != 2)
+	{
+		std::fprintf(stderr, "usage: g2dshaderc <output file>\n");
+		return 1;
+	}
+
+	if (!g2d::BuildShaderCache(argv[1]))
+	{
+		std::fprintf(stderr, "g2dshaderc: failed to build shader cache %s\n", argv[1]);
+		return 1;
+	}
+	return 0;
+}
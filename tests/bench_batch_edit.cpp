@@ -0,0 +1,62 @@
+#include "headless.h"
+
+namespace
+{
+	// about 500k tiles of a square map.
+	constexpr unsigned int MapSize = 708;
+	constexpr float TileSize = 32.0f;
+	constexpr float SceneBoundSize = 32768.0f;
+	constexpr double TargetSpeedup = 10.0;
+
+	// construction and the first frame, where deferred work is done.
+	double BuildTileMap(HeadlessEngine& engine, bool batchEdit)
+	{
+		g2d::Scene* scene = g2d::Engine::GetInstance()->CreateNewScene(SceneBoundSize);
+		Stopwatch watch;
+		if (batchEdit)
+		{
+			scene->BeginBatchEdit();
+		}
+
+		float origin = -0.5f * MapSize * TileSize;
+		for (unsigned int row = 0; row < MapSize; row++)
+		{
+			for (unsigned int column = 0; column < MapSize; column++)
+			{
+				g2d::SceneNode* tile = scene->GetRootNode()->CreateChild();
+				tile->SetPosition(cxx::point2d<float>(origin + column * TileSize, origin + row * TileSize));
+				tile->SetStatic(true);
+				tile->AddComponent(g2d::Quad::Create()->SetSize(cxx::float2(TileSize, TileSize)), true);
+			}
+		}
+
+		if (batchEdit)
+		{
+			scene->EndBatchEdit();
+		}
+		g2d::Engine::GetInstance()->Update(16);
+		engine.RenderFrame(scene);
+		double time = watch.GetMilliseconds();
+
+		CHECK(scene->GetRootNode()->GetChildCount() == MapSize * MapSize);
+		scene->Release();
+		return time;
+	}
+}
+
+// building a tile map node by node, with and without batch editing.
+int main()
+{
+	HeadlessEngine engine;
+	double perNodeTime = BuildTileMap(engine, false);
+	double batchEditTime = BuildTileMap(engine, true);
+	double speedup = perNodeTime / batchEditTime;
+
+	std::printf("batch edit, %u tiles\n", MapSize * MapSize);
+	std::printf("  per node:   %.1f ms\n", perNodeTime);
+	std::printf("  batch edit: %.1f ms\n", batchEditTime);
+
+	bool passed = speedup >= TargetSpeedup;
+	std::printf("  speedup %.1fx, target %.0fx: %s\n", speedup, TargetSpeedup, passed ? "passed" : "missed");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+#include <cstdio>
+#include "headless.h"
+
+namespace
+{
+	// 50k quads covering the default window of the null RHI.
+	constexpr unsigned int GridColumns = 250;
+	constexpr unsigned int GridRows = 200;
+	constexpr float WindowWidth = 1280.0f;
+	constexpr float WindowHeight = 720.0f;
+	constexpr unsigned int FrameCount = 20000;
+	constexpr unsigned int DeltaTime = 16;
+	const char* MovingLogPath = "bench_cursor_hit_test_moving.rec";
+	const char* IdleLogPath = "bench_cursor_hit_test_idle.rec";
+
+	unsigned int gEnterCount = 0;
+
+	class HoverCounter : public g2d::Component
+	{
+		RTTI_IMPL;
+	public:
+		virtual void Release() override { delete this; }
+
+		virtual void OnCursorEnterFrom(g2d::SceneNode* adjacency, const g2d::Mouse&, const g2d::Keyboard&) override
+		{
+			gEnterCount++;
+		}
+	};
+
+	// one message per frame, they are not merged.
+	void Record(HeadlessEngine& engine, const char* filePath, bool moving)
+	{
+		CHECK(engine->StartRecording(filePath));
+		unsigned int timeStamp = 0;
+		for (unsigned int frame = 0; frame < FrameCount; frame++)
+		{
+			if (moving)
+			{
+				// sweep the window diagonally, back and forth.
+				unsigned int step = frame % 1000;
+				unsigned int t = (step < 500) ? step : 1000 - step;
+				unsigned int x = static_cast<unsigned int>(WindowWidth * t / 500);
+				unsigned int y = static_cast<unsigned int>(WindowHeight * t / 500);
+				engine->InjectMessage(g2d::Message(g2d::MessageEvent::MouseMove, g2d::MouseButton::None, x, y), timeStamp);
+			}
+			engine->Update(DeltaTime);
+			timeStamp += DeltaTime;
+		}
+		engine->StopRecording();
+	}
+
+	double Replay(HeadlessEngine& engine, const char* filePath)
+	{
+		CHECK(engine->StartReplaying(filePath));
+		Stopwatch watch;
+		unsigned int frameCount = 0;
+		while (engine->ReplayFrame())
+		{
+			frameCount++;
+		}
+		double time = watch.GetMilliseconds();
+		CHECK(frameCount == FrameCount);
+		return time;
+	}
+}
+
+// mouse sweeps over a crowded scene replayed from a log,
+// frames without messages are replayed as the baseline.
+int main()
+{
+	HeadlessEngine engine;
+	g2d::Scene* scene = engine->CreateNewScene(2048.0f);
+	cxx::float2 cellSize(WindowWidth / GridColumns, WindowHeight / GridRows);
+	scene->BeginBatchEdit();
+	for (unsigned int row = 0; row < GridRows; row++)
+	{
+		for (unsigned int column = 0; column < GridColumns; column++)
+		{
+			g2d::SceneNode* node = scene->GetRootNode()->CreateChild();
+			node->SetPosition(cxx::point2d<float>((column + 0.5f) * cellSize.x - 0.5f * WindowWidth, (row + 0.5f) * cellSize.y - 0.5f * WindowHeight));
+			node->AddComponent(g2d::Quad::Create()->SetSize(cellSize), true);
+			node->AddComponent(new HoverCounter(), true);
+		}
+	}
+	scene->EndBatchEdit();
+	engine->Update(DeltaTime);
+	engine.RenderFrame(scene);
+
+	Record(engine, MovingLogPath, true);
+	Record(engine, IdleLogPath, false);
+
+	gEnterCount = 0;
+	double movingTime = Replay(engine, MovingLogPath);
+	CHECK(gEnterCount > 0);
+	double idleTime = Replay(engine, IdleLogPath);
+	std::remove(MovingLogPath);
+	std::remove(IdleLogPath);
+	scene->Release();
+
+	double hitTestTime = (movingTime > idleTime) ? movingTime - idleTime : 0.0;
+	std::printf("cursor hit test, %u sprites, %u mouse moves\n", GridColumns * GridRows, FrameCount);
+	std::printf("  replay with moves: %.1f ms\n", movingTime);
+	std::printf("  replay idle:       %.1f ms\n", idleTime);
+	std::printf("  %.0f frames/s, %.0f mouse-move events/s net of idle frames\n",
+		FrameCount * 1000.0 / movingTime,
+		(hitTestTime > 0.0) ? FrameCount * 1000.0 / hitTestTime : 0.0);
+	return 0;
+}
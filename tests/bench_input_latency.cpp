@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <vector>
+#include "headless.h"
+
+namespace
+{
+	constexpr unsigned int NodeCount = 10000;
+	constexpr unsigned int SampleCount = 200000;
+
+	using Clock = std::chrono::steady_clock;
+
+	Clock::time_point gCallbackTime;
+
+	// the only subscriber of messages and key presses.
+	class Listener : public g2d::Component
+	{
+		RTTI_IMPL;
+	public:
+		virtual void Release() override { delete this; }
+
+		virtual unsigned int GetSubscribedEvents() const override
+		{
+			return g2d::BroadcastEvent::Message | g2d::BroadcastEvent::KeyPress;
+		}
+
+		virtual void OnMessage(const g2d::Message& message) override
+		{
+			if (message.Event == g2d::MessageEvent::MouseMove)
+			{
+				gCallbackTime = Clock::now();
+			}
+		}
+
+		virtual void OnKeyPress(g2d::KeyCode key, const g2d::Mouse& mouse, const g2d::Keyboard& keyboard) override
+		{
+			gCallbackTime = Clock::now();
+		}
+	};
+
+	// nanoseconds from injecting the message to the callback.
+	double Inject(HeadlessEngine& engine, const g2d::Message& message, unsigned int timeStamp)
+	{
+		gCallbackTime = Clock::time_point();
+		Clock::time_point injectTime = Clock::now();
+		engine->InjectMessage(message, timeStamp);
+		CHECK(gCallbackTime != Clock::time_point());
+		return std::chrono::duration<double, std::nano>(gCallbackTime - injectTime).count();
+	}
+
+	void PrintLatency(const char* name, std::vector<double>& samples)
+	{
+		std::sort(samples.begin(), samples.end());
+		double sum = 0.0;
+		for (double sample : samples)
+		{
+			sum += sample;
+		}
+		std::printf("  %s: mean %.0f ns, median %.0f ns, p99 %.0f ns\n", name,
+			sum / samples.size(), samples[samples.size() / 2], samples[samples.size() * 99 / 100]);
+	}
+}
+
+// raw input dispatches messages at once, so the time to the
+// scene callback is the cost of the input and event paths.
+int main()
+{
+	HeadlessEngine engine(0, true);
+	g2d::Scene* scene = engine->CreateNewScene(2048.0f);
+	for (unsigned int i = 0; i < NodeCount; i++)
+	{
+		scene->GetRootNode()->CreateChild()->AddComponent(g2d::Quad::Create(), true);
+	}
+	scene->GetRootNode()->CreateChild()->AddComponent(new Listener(), true);
+	engine->Update(16);
+
+	std::vector<double> moveSamples;
+	std::vector<double> keySamples;
+	moveSamples.reserve(SampleCount);
+	keySamples.reserve(SampleCount);
+	for (unsigned int i = 0; i < SampleCount; i++)
+	{
+		unsigned int timeStamp = 16 + i;
+		moveSamples.push_back(Inject(engine, g2d::Message(g2d::MessageEvent::MouseMove, g2d::MouseButton::None, i % 1280, i % 720), timeStamp));
+
+		// a key up right after the key down is a press.
+		engine->InjectMessage(g2d::Message(g2d::MessageEvent::KeyDown, g2d::KeyCode::KeyA), timeStamp);
+		keySamples.push_back(Inject(engine, g2d::Message(g2d::MessageEvent::KeyUp, g2d::KeyCode::KeyA), timeStamp));
+	}
+	scene->Release();
+
+	std::printf("input latency, %u samples, %u nodes\n", SampleCount, NodeCount + 1);
+	PrintLatency("mouse move -> OnMessage", moveSamples);
+	PrintLatency("key up -> OnKeyPress   ", keySamples);
+	return 0;
+}
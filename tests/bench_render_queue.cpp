@@ -0,0 +1,70 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "headless.h"
+#include "render/render_queue.h"
+
+namespace
+{
+	constexpr unsigned int ProducerCount = 8;
+	constexpr unsigned int RequestsPerProducer = 250000;
+	constexpr unsigned int FrameCount = 10;
+}
+
+// push and drain throughput of the queue, like OnRender jobs of a frame.
+int main()
+{
+	RenderQueue queue;
+	double pushTime = 0.0;
+	double drainTime = 0.0;
+	for (unsigned int frame = 0; frame < FrameCount; frame++)
+	{
+		std::atomic<unsigned int> ready(0);
+		std::atomic<bool> started(false);
+		std::vector<std::thread> producers;
+		for (unsigned int t = 0; t < ProducerCount; t++)
+		{
+			producers.emplace_back([&, t]
+			{
+				ready++;
+				while (!started.load())
+				{
+					std::this_thread::yield();
+				}
+
+				RenderRequest request;
+				for (unsigned int i = 0; i < RequestsPerProducer; i++)
+				{
+					request.Layer = i / 50000;
+					request.Order = t * RequestsPerProducer + i;
+					queue.Push(request);
+				}
+			});
+		}
+
+		while (ready.load() < ProducerCount)
+		{
+			std::this_thread::yield();
+		}
+
+		Stopwatch pushWatch;
+		started = true;
+		for (auto& producer : producers)
+		{
+			producer.join();
+		}
+		pushTime += pushWatch.GetMilliseconds();
+
+		Stopwatch drainWatch;
+		auto& requests = queue.Drain();
+		drainTime += drainWatch.GetMilliseconds();
+		CHECK(requests.size() == ProducerCount * RequestsPerProducer);
+		queue.Reset();
+	}
+
+	double requestCount = static_cast<double>(ProducerCount) * RequestsPerProducer * FrameCount;
+	std::printf("render queue, %u producers, %u requests per frame\n", ProducerCount, ProducerCount * RequestsPerProducer);
+	std::printf("  push:  %.1f M requests/s\n", requestCount / pushTime / 1000.0);
+	std::printf("  drain: %.1f M requests/s\n", requestCount / drainTime / 1000.0);
+	return 0;
+}
@@ -0,0 +1,60 @@
+#include <cstdio>
+#include "headless.h"
+#include "g2dserialize.h"
+
+namespace
+{
+	// one million nodes, quads on the leaves.
+	constexpr unsigned int GroupCount = 1000;
+	constexpr unsigned int LeavesPerGroup = 999;
+	constexpr float SceneBoundSize = 65536.0f;
+	constexpr double TargetMilliseconds = 1000.0;
+	const char* FilePath = "bench_scene_serializer.g2ds";
+}
+
+// saving and loading a scene of 1M nodes, the target is under a second each.
+int main()
+{
+	HeadlessEngine engine;
+	g2d::Scene* scene = g2d::Engine::GetInstance()->CreateNewScene(SceneBoundSize);
+	scene->BeginBatchEdit();
+	for (unsigned int g = 0; g < GroupCount; g++)
+	{
+		g2d::SceneNode* group = scene->GetRootNode()->CreateChild();
+		group->SetPosition(cxx::point2d<float>((g % 32) * 1000.0f, (g / 32) * 1000.0f));
+		for (unsigned int i = 0; i < LeavesPerGroup; i++)
+		{
+			g2d::SceneNode* leaf = group->CreateChild();
+			leaf->SetPosition(cxx::point2d<float>((i % 32) * 30.0f, (i / 32) * 30.0f));
+			leaf->SetStatic(true);
+			leaf->AddComponent(g2d::Quad::Create()->SetSize(cxx::float2(28.0f, 28.0f)), true);
+		}
+	}
+	scene->EndBatchEdit();
+
+	Stopwatch saveWatch;
+	CHECK(g2d::SaveSceneNodes(scene->GetRootNode(), FilePath));
+	double saveTime = saveWatch.GetMilliseconds();
+
+	// quads of both scenes would not fit in the sprite table.
+	scene->Release();
+	scene = g2d::Engine::GetInstance()->CreateNewScene(SceneBoundSize);
+
+	Stopwatch loadWatch;
+	CHECK(g2d::LoadSceneNodes(scene->GetRootNode(), FilePath));
+	double loadTime = loadWatch.GetMilliseconds();
+
+	CHECK(scene->GetRootNode()->GetChildCount() == GroupCount);
+	CHECK(scene->GetRootNode()->GetChildByIndex(GroupCount - 1)->GetChildCount() == LeavesPerGroup);
+	scene->Release();
+	std::remove(FilePath);
+
+	unsigned int nodeCount = GroupCount * (LeavesPerGroup + 1);
+	std::printf("scene serializer, %u nodes\n", nodeCount);
+	std::printf("  save: %.1f ms\n", saveTime);
+	std::printf("  load: %.1f ms\n", loadTime);
+
+	bool passed = saveTime < TargetMilliseconds && loadTime < TargetMilliseconds;
+	std::printf("  target %.0f ms: %s\n", TargetMilliseconds, passed ? "passed" : "missed");
+	return passed ? 0 : 1;
+}
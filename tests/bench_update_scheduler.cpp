@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include "headless.h"
+
+namespace
+{
+	constexpr unsigned int NodeCount = 20000;
+	constexpr unsigned int FrameCount = 20;
+	constexpr unsigned int MaxThreadCount = 8;
+	constexpr unsigned int OrderCount = 4;
+	constexpr double TargetEfficiency = 0.75;
+
+	// update-heavy component, only writes its own states.
+	class Simulation : public g2d::Component
+	{
+		RTTI_IMPL;
+	public:
+		Simulation(int order) : mOrder(order) { }
+
+		virtual void Release() override { delete this; }
+
+		virtual int GetExecuteOrder() const override { return mOrder; }
+
+		virtual bool IsParallelSafe() const override { return true; }
+
+		virtual void OnUpdate(unsigned int deltaTime) override
+		{
+			float value = mValue;
+			for (int i = 0; i < 2000; i++)
+			{
+				value = std::sin(value + deltaTime * 0.001f) * 0.5f + 0.5f;
+			}
+			mValue = value;
+			mUpdateCount++;
+		}
+
+		unsigned int GetUpdateCount() const { return mUpdateCount; }
+
+	private:
+		int mOrder;
+		float mValue = 0.0f;
+		unsigned int mUpdateCount = 0;
+	};
+
+	// serial component between the parallel groups,
+	// parallel ones of the same order finished before it.
+	class Monitor : public g2d::Component
+	{
+		RTTI_IMPL;
+	public:
+		Monitor(int order, std::vector<Simulation*>& simulations)
+			: mOrder(order), mSimulations(simulations) { }
+
+		virtual void Release() override { delete this; }
+
+		virtual int GetExecuteOrder() const override { return mOrder; }
+
+		virtual void OnUpdate(unsigned int deltaTime) override
+		{
+			mFrame++;
+			for (Simulation* simulation : mSimulations)
+			{
+				unsigned int expected = (simulation->GetExecuteOrder() <= mOrder) ? mFrame : mFrame - 1;
+				CHECK(simulation->GetUpdateCount() == expected);
+			}
+		}
+
+	private:
+		int mOrder;
+		unsigned int mFrame = 0;
+		std::vector<Simulation*>& mSimulations;
+	};
+
+	double RunFrames(unsigned int threadCount)
+	{
+		HeadlessEngine engine(threadCount - 1);
+		g2d::Scene* scene = engine->CreateNewScene(2048.0f);
+		std::vector<Simulation*> simulations;
+		std::vector<Simulation*> checked;
+		for (unsigned int i = 0; i < NodeCount; i++)
+		{
+			Simulation* simulation = new Simulation(static_cast<int>(i % OrderCount));
+			scene->GetRootNode()->CreateChild()->AddComponent(simulation, true);
+			simulations.push_back(simulation);
+			if (i % 97 == 0)
+			{
+				checked.push_back(simulation);
+			}
+		}
+		for (unsigned int order = 0; order <= OrderCount; order++)
+		{
+			scene->GetRootNode()->CreateChild()->AddComponent(new Monitor(static_cast<int>(order), checked), true);
+		}
+
+		Stopwatch watch;
+		for (unsigned int frame = 0; frame < FrameCount; frame++)
+		{
+			engine->Update(16);
+		}
+		double time = watch.GetMilliseconds();
+
+		for (Simulation* simulation : simulations)
+		{
+			CHECK(simulation->GetUpdateCount() == FrameCount);
+		}
+		scene->Release();
+		return time;
+	}
+}
+
+// frame time of parallel-safe components with more and more
+// threads, the calling thread is one of them.
+int main()
+{
+	unsigned int maxThreadCount = std::min(std::max(std::thread::hardware_concurrency(), 1u), MaxThreadCount);
+	std::printf("update scheduler, %u components, %u frames\n", NodeCount, FrameCount);
+
+	double serialTime = RunFrames(1);
+	double efficiency = 1.0;
+	std::printf("  1 thread:  %.1f ms\n", serialTime);
+	for (unsigned int threadCount = 2; threadCount <= maxThreadCount; threadCount *= 2)
+	{
+		double time = RunFrames(threadCount);
+		efficiency = serialTime / time / threadCount;
+		std::printf("  %u threads: %.1f ms, speedup %.2fx, efficiency %.0f%%\n", threadCount, time, serialTime / time, efficiency * 100.0);
+	}
+
+	bool passed = efficiency >= TargetEfficiency;
+	std::printf("  efficiency target %.0f%%: %s\n", TargetEfficiency * 100.0, passed ? "passed" : "missed");
+	return passed ? 0 : 1;
+}
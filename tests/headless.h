@@ -0,0 +1,67 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "g2dengine.h"
+#include "g2drender.h"
+#include "g2dscene.h"
+
+// abort the test, it runs without debugger.
+#define CHECK(expr) \
+	do \
+	{ \
+		if (!(expr)) \
+		{ \
+			std::fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #expr); \
+			std::exit(1); \
+		} \
+	} while (0)
+
+// wall clock time since constructed, for benchmarks.
+class Stopwatch
+{
+public:
+	Stopwatch() : mStart(std::chrono::steady_clock::now()) { }
+
+	double GetMilliseconds() const
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStart).count();
+	}
+
+private:
+	std::chrono::steady_clock::time_point mStart;
+};
+
+// engine on the null RHI, without window and resources.
+class HeadlessEngine
+{
+public:
+	HeadlessEngine(unsigned int updateWorkerCount = 0, bool rawInput = false)
+	{
+		g2d::Engine::CreationConfig config;
+		config.NativeWindow = nullptr;
+		config.ResourceFolderPath = "";
+		config.UpdateWorkerCount = updateWorkerCount;
+		config.RawInput = rawInput;
+		CHECK(g2d::Engine::Initialize(config) == g2d::Engine::InitialResult::Success);
+	}
+
+	~HeadlessEngine()
+	{
+		g2d::Engine::Uninitialize();
+	}
+
+	HeadlessEngine(const HeadlessEngine&) = delete;
+
+	HeadlessEngine& operator=(const HeadlessEngine&) = delete;
+
+	g2d::Engine* operator->() { return g2d::Engine::GetInstance(); }
+
+	void RenderFrame(g2d::Scene* scene)
+	{
+		g2d::RenderSystem* renderSystem = g2d::Engine::GetInstance()->GetRenderSystem();
+		renderSystem->BeginRender();
+		scene->Render();
+		renderSystem->EndRender();
+	}
+};
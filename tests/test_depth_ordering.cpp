@@ -0,0 +1,93 @@
+#include "headless.h"
+#include "system_blackboard.h"
+#include "render/render_system.h"
+#include "RHI/null/inner_RHI.h"
+
+namespace
+{
+	// index count tells drawcalls apart in the records.
+	g2d::Mesh* CreateQuads(unsigned int quadCount)
+	{
+		g2d::Mesh* mesh = g2d::Mesh::Create(quadCount * 4, quadCount * 6);
+		g2d::GeometryVertex* vertices = mesh->GetRawVertices();
+		unsigned int* indices = mesh->GetRawIndices();
+		const unsigned int quadIndices[] = { 0, 2, 1, 0, 3, 2 };
+		for (unsigned int q = 0; q < quadCount; q++)
+		{
+			float x = q * 10.0f;
+			vertices[q * 4 + 0].Position = cxx::point2d<float>(x - 5.0f, -5.0f);
+			vertices[q * 4 + 1].Position = cxx::point2d<float>(x + 5.0f, -5.0f);
+			vertices[q * 4 + 2].Position = cxx::point2d<float>(x + 5.0f, +5.0f);
+			vertices[q * 4 + 3].Position = cxx::point2d<float>(x - 5.0f, +5.0f);
+			for (unsigned int i = 0; i < 6; i++)
+			{
+				indices[q * 6 + i] = q * 4 + quadIndices[i];
+			}
+		}
+		return mesh;
+	}
+
+	g2d::Material* CreateMaterial(g2d::BlendMode blendMode)
+	{
+		g2d::Material* material = g2d::Material::CreateSimpleColor();
+		material->GetPassByIndex(0)->SetBlendMode(blendMode);
+		return material;
+	}
+}
+
+int main()
+{
+	HeadlessEngine engine;
+	g2d::RenderSystem* renderSystem = engine->GetRenderSystem();
+	::Context* context = reinterpret_cast<::Context*>(GetRenderSystem().GetContext());
+
+	// opaque, blended, opaque, blended, submitted in this order.
+	g2d::Mesh* meshes[] = { CreateQuads(1), CreateQuads(2), CreateQuads(3), CreateQuads(4) };
+	g2d::Material* materials[] =
+	{
+		CreateMaterial(g2d::BlendMode::None),
+		CreateMaterial(g2d::BlendMode::Normal),
+		CreateMaterial(g2d::BlendMode::None),
+		CreateMaterial(g2d::BlendMode::Additve),
+	};
+
+	context->SetDrawRecording(true);
+	renderSystem->BeginRender();
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		renderSystem->SetSubmissionOrder(i + 1);
+		renderSystem->RenderMesh(g2d::RenderLayer::Default, meshes[i], materials[i], cxx::float2x3::identity());
+	}
+	renderSystem->EndRender();
+	context->SetDrawRecording(false);
+
+	// opaque ones are drawn nearest first writing the depth,
+	// then the blended ones in order, only testing it.
+	auto& records = context->GetDrawRecords();
+	CHECK(records.size() == 4);
+	const unsigned int expectedIndexCounts[] = { 18, 6, 12, 24 };
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		const ::Context::DrawRecord& record = records[i];
+		bool isOpaque = i < 2;
+		CHECK(record.IndexCount == expectedIndexCounts[i]);
+		CHECK(record.DepthStencilState != nullptr);
+		CHECK(record.DepthStencilState->IsDepthTestEnabled());
+		CHECK(record.DepthStencilState->IsDepthWriteEnabled() == isOpaque);
+
+		// no blend state means blending disabled.
+		CHECK((record.BlendState != nullptr && record.BlendState->IsEnabled()) == !isOpaque);
+	}
+
+	// later drawcalls are nearer.
+	CHECK(records[0].Viewport.MinMaxZ.x < records[1].Viewport.MinMaxZ.x);
+	CHECK(records[2].Viewport.MinMaxZ.x > records[3].Viewport.MinMaxZ.x);
+	CHECK(records[1].Viewport.MinMaxZ.x > records[2].Viewport.MinMaxZ.x);
+
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		meshes[i]->Release();
+		materials[i]->Release();
+	}
+	return 0;
+}
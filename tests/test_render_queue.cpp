@@ -0,0 +1,87 @@
+#include <atomic>
+#include <map>
+#include <thread>
+#include <vector>
+#include "headless.h"
+#include "render/render_queue.h"
+
+namespace
+{
+	constexpr unsigned int ProducerCount = 8;
+	constexpr unsigned int RequestsPerProducer = 20000;
+}
+
+int main()
+{
+	RenderQueue queue;
+	std::atomic<bool> started(false);
+	std::vector<std::thread> producers;
+	for (unsigned int t = 0; t < ProducerCount; t++)
+	{
+		producers.emplace_back([&queue, &started, t]
+		{
+			while (!started.load())
+			{
+				std::this_thread::yield();
+			}
+
+			// keys collide between threads on purpose. batch
+			// fields are not read by the queue, they carry
+			// the thread and the submitting index.
+			for (unsigned int i = 0; i < RequestsPerProducer; i++)
+			{
+				RenderRequest request;
+				request.Layer = (i / 1000) % 4;
+				request.Order = i % 100;
+				request.BatchIndexCount = t;
+				request.BatchStartIndex = i;
+				queue.Push(request);
+			}
+		});
+	}
+	started = true;
+	for (auto& producer : producers)
+	{
+		producer.join();
+	}
+
+	auto& requests = queue.Drain();
+	CHECK(requests.size() == ProducerCount * RequestsPerProducer);
+
+	std::map<unsigned int, unsigned int> threadOfProducer;
+	for (const RenderRequest* request : requests)
+	{
+		CHECK(request->Producer < ProducerCount);
+		auto result = threadOfProducer.insert({ request->Producer, request->BatchIndexCount });
+		CHECK(result.first->second == request->BatchIndexCount);
+	}
+	CHECK(threadOfProducer.size() == ProducerCount);
+
+	for (size_t i = 1; i < requests.size(); i++)
+	{
+		const RenderRequest* prev = requests[i - 1];
+		const RenderRequest* curr = requests[i];
+		if (prev->Layer != curr->Layer)
+		{
+			CHECK(prev->Layer < curr->Layer);
+		}
+		else if (prev->Order != curr->Order)
+		{
+			CHECK(prev->Order < curr->Order);
+		}
+		else if (prev->Producer != curr->Producer)
+		{
+			// ties between threads are broken by registration.
+			CHECK(prev->Producer < curr->Producer);
+		}
+		else
+		{
+			CHECK(prev->BatchStartIndex < curr->BatchStartIndex);
+		}
+	}
+
+	// draining again after reset gives nothing.
+	queue.Reset();
+	CHECK(queue.Drain().empty());
+	return 0;
+}
@@ -0,0 +1,61 @@
+#include <cmath>
+#include <vector>
+#include "headless.h"
+#include "render/sprite_table.h"
+
+namespace
+{
+	// more than the fixed directory used to hold.
+	constexpr unsigned int SpriteCount = 1100000;
+
+	bool IsNear(const cxx::point2d<float>& a, const cxx::point2d<float>& b)
+	{
+		return std::fabs(a.x - b.x) < 1e-3f && std::fabs(a.y - b.y) < 1e-3f;
+	}
+}
+
+int main()
+{
+	SpriteTable table;
+	std::vector<unsigned int> sprites(SpriteCount);
+	for (unsigned int i = 0; i < SpriteCount; i++)
+	{
+		sprites[i] = table.Alloc();
+		CHECK(sprites[i] == i);
+		table.SetSize(sprites[i], cxx::float2(static_cast<float>(i % 100 + 1), 2.0f));
+	}
+
+	// sprites written before growing are kept.
+	for (unsigned int i = 0; i < SpriteCount; i += 997)
+	{
+		CHECK(table.GetSize(sprites[i]).x == static_cast<float>(i % 100 + 1));
+	}
+
+	unsigned int sprite = sprites.back();
+	table.SetSize(sprite, cxx::float2(4.0f, 2.0f));
+	table.SetPivot(sprite, cxx::float2(0.25f, 0.5f));
+	table.SetTexcoordRect(sprite, cxx::float2(0.5f, 0.25f), cxx::float2(0.5f, 0.5f));
+	table.SetColor(sprite, cxx::color4f::yellow());
+
+	cxx::float2x3 worldMatrix = cxx::float2x3::trsp(cxx::point2d<float>(10.0f, 20.0f), cxx::radian<float>(0.5f), cxx::float2(2.0f, 3.0f), cxx::float2::zero());
+	g2d::GeometryVertex vertices[4];
+	table.Expand(sprite, worldMatrix, vertices);
+
+	// corners in the order of the quad mesh.
+	const cxx::point2d<float> corners[] = { { -1.0f, -1.0f }, { 3.0f, -1.0f }, { 3.0f, 1.0f }, { -1.0f, 1.0f } };
+	const cxx::point2d<float> texcoords[] = { { 0.5f, 0.75f }, { 1.0f, 0.75f }, { 1.0f, 0.25f }, { 0.5f, 0.25f } };
+	for (int v = 0; v < 4; v++)
+	{
+		CHECK(IsNear(vertices[v].Position, transform(worldMatrix, corners[v])));
+		CHECK(IsNear(vertices[v].Texcoord, texcoords[v]));
+		for (int c = 0; c < 4; c++)
+		{
+			CHECK(vertices[v].VertexColor.value.v[c] == cxx::color4f::yellow().value.v[c]);
+		}
+	}
+
+	// freed sprites are reused before growing.
+	table.Free(sprites[42]);
+	CHECK(table.Alloc() == sprites[42]);
+	return 0;
+}
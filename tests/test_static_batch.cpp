@@ -0,0 +1,75 @@
+#include "headless.h"
+#include "scene/scene.h"
+#include "scene/static_batch.h"
+
+namespace
+{
+	bool IsSameColor(const cxx::color4f& a, const cxx::color4f& b)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			if (a.value.v[c] != b.value.v[c])
+				return false;
+		}
+		return true;
+	}
+
+	StaticBatch* GetStaticBatch(g2d::Scene* scene, g2d::Component* component)
+	{
+		QuadTreeNode* node = reinterpret_cast<::Scene*>(scene)->GetSpatialGraph().FindNode(component);
+		CHECK(node != nullptr);
+		return node->GetStaticBatch();
+	}
+
+	// vertices of the only component in the batch.
+	const std::vector<g2d::GeometryVertex>& GetBakedVertices(StaticBatch* batch)
+	{
+		CHECK(batch != nullptr && !batch->IsDirty());
+		CHECK(batch->GetComponentCount() == 1 && batch->GetGeometry() != nullptr);
+		return batch->GetGeometry()->Vertices;
+	}
+}
+
+int main()
+{
+	HeadlessEngine engine;
+	g2d::Scene* scene = g2d::Engine::GetInstance()->CreateNewScene(2048.0f);
+
+	g2d::Quad* quad = g2d::Quad::Create()->SetSize(cxx::float2(64.0f, 64.0f))->SetColor(cxx::color4f::yellow());
+	g2d::SceneNode* node = scene->GetRootNode()->CreateChild();
+	node->AddComponent(quad, true);
+	node->SetStatic(true);
+	engine.RenderFrame(scene);
+
+	StaticBatch* batch = GetStaticBatch(scene, quad);
+	for (auto& vertex : GetBakedVertices(batch))
+	{
+		CHECK(IsSameColor(vertex.VertexColor, cxx::color4f::yellow()));
+	}
+
+	// sprite data changes without moving the quad.
+	quad->SetColor(cxx::color4f::blue());
+	CHECK(batch->IsDirty());
+	engine.RenderFrame(scene);
+	for (auto& vertex : GetBakedVertices(batch))
+	{
+		CHECK(IsSameColor(vertex.VertexColor, cxx::color4f::blue()));
+	}
+
+	quad->SetTexcoordRect(cxx::float2(0.5f, 0.5f), cxx::float2(0.5f, 0.5f));
+	CHECK(batch->IsDirty());
+	engine.RenderFrame(scene);
+	for (auto& vertex : GetBakedVertices(batch))
+	{
+		CHECK(vertex.Texcoord.x >= 0.5f && vertex.Texcoord.y >= 0.5f);
+	}
+
+	// dynamic quads are not batched, nothing to rebake.
+	node->SetStatic(false);
+	engine.RenderFrame(scene);
+	quad->SetColor(cxx::color4f::yellow());
+	CHECK(!batch->IsDirty());
+
+	scene->Release();
+	return 0;
+}